@@ -0,0 +1,103 @@
+/*
+ * @file autotuner.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_AUTOTUNER_H_
+#define INCLUDE_REGION_DETECTION_CORE_AUTOTUNER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <log4cxx/logger.h>
+
+#include "region_detection_core/region_detector.h"
+
+namespace region_detection_core
+{
+/**
+ * @brief the fastest settings found for a machine and configuration, loaded by the detector from
+ * RegionDetectionConfig::BackendCfg::profile_file
+ */
+struct AutotuneProfile
+{
+  std::string search = "kdtree"; /** @brief backend of the nearest point lookups */
+  int opencv_threads = -1;       /** @brief threads of the opencv parallel regions */
+  int cpus = 0;                  /** @brief cpus available when the profile was made, it is ignored on other machines */
+  std::map<std::string, double> timings; /** @brief best time in seconds of each candidate, e.g. "search/kdtree" */
+
+  static bool load(const std::string& yaml_file, AutotuneProfile& profile, std::string& err_msg);
+  bool save(const std::string& yaml_file, std::string& err_msg) const;
+};
+
+/**
+ * @class region_detection_core::Autotuner
+ * @brief Benchmarks the interchangeable implementations of the detector stages on sample data and picks the fastest
+ * one of each.  Only candidates that find the same regions as the configured settings are considered.
+ */
+class Autotuner
+{
+public:
+  Autotuner(log4cxx::LoggerPtr logger = nullptr);
+
+  /**
+   * @brief times each candidate on the samples, first the opencv thread counts on the 2d stage and then the search
+   * backends on the 3d, merge and poses stages
+   * @param config      The configuration to tune, the incremental mode is disabled while benchmarking
+   * @param samples     Representative data bundles
+   * @param profile     (Output) The fastest settings
+   * @param repetitions Runs of each candidate, the fastest one is kept
+   * @return  True on success, false otherwise
+   */
+  bool run(const RegionDetectionConfig& config,
+           const RegionDetector::DataBundleVec& samples,
+           AutotuneProfile& profile,
+           int repetitions = 3);
+
+private:
+  /**
+   * @brief best time of the stages over the repetitions and the number of poses of each region found
+   */
+  bool benchmark(const RegionDetectionConfig& config,
+                 const RegionDetector::DataBundleVec& samples,
+                 const std::vector<std::string>& stages,
+                 int repetitions,
+                 double& seconds,
+                 std::vector<std::size_t>& region_sizes);
+
+  log4cxx::LoggerPtr logger_;
+};
+
+}  // namespace region_detection_core
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_AUTOTUNER_H_ */
@@ -0,0 +1,138 @@
+/*
+ * @file binary_image.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_BINARY_IMAGE_H_
+#define INCLUDE_REGION_DETECTION_CORE_BINARY_IMAGE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace region_detection_core
+{
+/**
+ * @class region_detection_core::BinaryImage
+ * @brief Binary image packed at one bit per pixel in 64 bit words.  The morphological operations and the contour
+ * tracing work on whole words so that the stages following a threshold move an eighth of the memory of a CV_8UC1 mask.
+ */
+class BinaryImage
+{
+public:
+  BinaryImage();
+  BinaryImage(int rows, int cols);
+
+  /**
+   * @brief packs the non zero pixels of a single channel 8 bit image
+   * @param src The source image, must be CV_8UC1
+   * @param dst The packed image
+   * @return False when the source type is not supported
+   */
+  static bool pack(const cv::Mat& src, BinaryImage& dst);
+
+  /**
+   * @brief writes the packed pixels as 0 or the value found in the source image
+   * @param dst The output CV_8UC1 image
+   */
+  void unpack(cv::Mat& dst) const;
+
+  /**
+   * @brief true when the structuring element can be applied on the packed image, the non zero entries of each row of
+   * the element must be contiguous which is the case of the rect, cross and ellipse shapes.
+   */
+  static bool supportsElement(const cv::Mat& element);
+
+  /**
+   * @brief true when the contour mode and approximation method can be traced on the packed image, currently
+   * CV_RETR_EXTERNAL and CV_RETR_LIST with CV_CHAIN_APPROX_NONE and CV_CHAIN_APPROX_SIMPLE.
+   */
+  static bool supportsContours(int mode, int method);
+
+  bool empty() const;
+  int rows() const;
+  int cols() const;
+
+  /**
+   * @brief true when all the non zero pixels of the source image had the same value, otherwise the morphological
+   * operations would not match the grayscale ones
+   */
+  bool isBinary() const;
+  bool get(int x, int y) const;
+
+  /**
+   * @brief same as cv::dilate with the default constant border
+   * @return False if the element is not supported
+   */
+  bool dilate(const cv::Mat& element, cv::Point anchor, BinaryImage& dst) const;
+
+  /**
+   * @brief same as cv::erode with the default constant border, pixels outside the image are considered set
+   * @return False if the element is not supported
+   */
+  bool erode(const cv::Mat& element, cv::Point anchor, BinaryImage& dst) const;
+
+  bool open(const cv::Mat& element, cv::Point anchor, BinaryImage& dst) const;
+  bool close(const cv::Mat& element, cv::Point anchor, BinaryImage& dst) const;
+
+  /**
+   * @brief traces the borders of the non zero regions following Suzuki and Abe, equivalent to cv::findContours
+   * @param contours  (Output) The contours found
+   * @param hierarchy (Output) Flat hierarchy of the contours, as produced by OpenCV for the supported modes
+   * @param mode      The retrieval mode
+   * @param method    The approximation method
+   * @return False if the mode or method are not supported
+   */
+  bool findContours(std::vector<std::vector<cv::Point>>& contours,
+                    std::vector<cv::Vec4i>& hierarchy,
+                    int mode,
+                    int method) const;
+
+private:
+  void create(int rows, int cols);
+  void complement(BinaryImage& dst) const;
+  void clearPadding();
+  const std::uint64_t* rowPtr(int y) const;
+  std::uint64_t* rowPtr(int y);
+
+  int rows_;
+  int cols_;
+  int words_per_row_;
+  bool binary_;
+  uchar on_value_;
+  std::vector<std::uint64_t> data_;
+};
+
+} /* namespace region_detection_core */
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_BINARY_IMAGE_H_ */
@@ -0,0 +1,147 @@
+/*
+ * @file chain_contour.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_CHAIN_CONTOUR_H_
+#define INCLUDE_REGION_DETECTION_CORE_CHAIN_CONTOUR_H_
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace region_detection_core
+{
+/**
+ * @class region_detection_core::ChainContour
+ * @brief Pixel contour stored as its first point followed by one chain code byte per step to an 8-connected
+ * neighbor, longer steps are escaped and stored as 16 or 32 bit deltas.  Traced contours take a byte per point instead
+ * of the eight of a cv::Point and are read back sequentially with a Decoder.
+ */
+class ChainContour
+{
+public:
+  /**
+   * @class region_detection_core::ChainContour::Decoder
+   * @brief Reads the points of a contour in order without expanding it
+   */
+  class Decoder
+  {
+  public:
+    explicit Decoder(const ChainContour& contour)
+      : codes_(contour.codes_.data()), remaining_(contour.size_), current_(contour.front_)
+    {
+    }
+
+    /**
+     * @brief writes the next point
+     * @return False when all the points were read
+     */
+    bool next(cv::Point& p)
+    {
+      if (remaining_ == 0)
+      {
+        return false;
+      }
+      if (started_)
+      {
+        std::uint8_t code = *codes_++;
+        if (code < NUM_DIRECTIONS)
+        {
+          current_ += DIRECTIONS[code];
+        }
+        else if (code == ESCAPE_16)
+        {
+          std::int16_t delta[2];
+          std::memcpy(delta, codes_, sizeof(delta));
+          codes_ += sizeof(delta);
+          current_ += cv::Point(delta[0], delta[1]);
+        }
+        else
+        {
+          std::int32_t delta[2];
+          std::memcpy(delta, codes_, sizeof(delta));
+          codes_ += sizeof(delta);
+          current_ += cv::Point(delta[0], delta[1]);
+        }
+      }
+      started_ = true;
+      remaining_--;
+      p = current_;
+      return true;
+    }
+
+  private:
+    const std::uint8_t* codes_;
+    std::size_t remaining_;
+    cv::Point current_;
+    bool started_ = false;
+  };
+
+  ChainContour();
+  explicit ChainContour(const std::vector<cv::Point>& points);
+
+  void push_back(const cv::Point& p);
+  void clear();
+
+  bool empty() const;
+  std::size_t size() const;
+
+  /**
+   * @brief bytes taken by the codes, excluding the first point
+   */
+  std::size_t byteSize() const;
+  cv::Point front() const;
+  cv::Point back() const;
+
+  std::vector<cv::Point> toPoints() const;
+
+  bool operator==(const ChainContour& other) const;
+  bool operator!=(const ChainContour& other) const;
+
+private:
+  static const std::uint8_t NUM_DIRECTIONS = 8;
+  static const std::uint8_t ESCAPE_16 = 8;
+  static const std::uint8_t ESCAPE_32 = 9;
+  static const cv::Point DIRECTIONS[NUM_DIRECTIONS];
+
+  cv::Point front_;
+  cv::Point back_;
+  std::size_t size_;
+  std::vector<std::uint8_t> codes_;
+};
+
+}  // namespace region_detection_core
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_CHAIN_CONTOUR_H_ */
@@ -0,0 +1,117 @@
+/*
+ * @file cloud_planes.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_CLOUD_PLANES_H_
+#define INCLUDE_REGION_DETECTION_CORE_CLOUD_PLANES_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <pcl/PCLPointCloud2.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <Eigen/Geometry>
+
+namespace region_detection_core
+{
+/**
+ * @class region_detection_core::CloudPlanes
+ * @brief Structure of arrays view of a cloud, the x, y and z coordinates are kept in separate row major planes with
+ * a bit per point telling whether all three are finite.  The loops over the planes have no padding or strides to
+ * skip, so the transform, the validity check and the window statistics are left to the compiler to vectorize.
+ */
+class CloudPlanes
+{
+public:
+  /**
+   * @brief moments of a set of points relative to a reference point
+   */
+  struct Moments
+  {
+    int count = 0;
+    Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+    Eigen::Matrix3d sum_sqr = Eigen::Matrix3d::Zero();
+  };
+
+  CloudPlanes();
+
+  /**
+   * @brief copies the coordinates of a cloud blob into the planes
+   * @param cloud The cloud, must have FLOAT32 x, y and z fields
+   * @return False when the cloud is not supported
+   */
+  bool build(const pcl::PCLPointCloud2& cloud);
+
+  /**
+   * @brief applies the transform to all the points, non finite points stay invalid
+   */
+  void transform(const Eigen::Isometry3d& transform);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  std::size_t size() const { return x_.size(); }
+
+  const std::vector<float>& x() const { return x_; }
+  const std::vector<float>& y() const { return y_; }
+  const std::vector<float>& z() const { return z_; }
+
+  bool isValid(std::size_t i) const { return (valid_[i >> 6] >> (i & 63)) & 1; }
+  std::size_t countValid() const;
+
+  /**
+   * @brief moments of the valid points of the window of (2 * half_size + 1) pixels per side centered at the given
+   * column and row that are within max_dist of the center, relative to the center
+   */
+  Moments windowMoments(int x, int y, int half_size, const Eigen::Vector3f& center, float max_dist) const;
+
+  /**
+   * @brief copies the planes into a cloud with the same width and height
+   */
+  void toPointCloud(pcl::PointCloud<pcl::PointXYZ>& cloud) const;
+
+private:
+  void updateValid();
+
+  int width_;
+  int height_;
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> z_;
+  std::vector<std::uint64_t> valid_;
+};
+
+}  // namespace region_detection_core
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_CLOUD_PLANES_H_ */
@@ -22,6 +22,11 @@
 #ifndef INCLUDE_CONFIG_TYPES_H_
 #define INCLUDE_CONFIG_TYPES_H_
 
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 
@@ -64,6 +69,7 @@ struct CountourCfg
 {
   int mode = CV_RETR_EXTERNAL;
   int method = CV_CHAIN_APPROX_SIMPLE;
+  bool trace_skeleton = true; /** @brief walks the lines once when the 2d methods end with THINNING */
 
   static const int MAX_MODE = CV_RETR_TREE;
   static const int MAX_METHOD = CV_CHAIN_APPROX_TC89_KCOS;
@@ -87,6 +93,20 @@ struct CLAHECfg
   double clip_limit;
   std::array<int, 2> tile_grid_size;
 };
+
+struct StageNodeCfg
+{
+  std::string name;
+  std::vector<std::string> inputs;  /** @brief names of the nodes feeding this one, "input" is the source image */
+  std::vector<std::string> methods; /** @brief 2d methods applied in order to the single input */
+  std::string combine;              /** @brief AND, OR or XOR of all the inputs, leave empty when using methods */
+};
+
+struct StageGraphCfg
+{
+  std::vector<StageNodeCfg> nodes;
+  std::string output; /** @brief name of the node whose image is passed to the contour detection */
+};
 }  // namespace config_2d
 
 namespace config_3d
@@ -115,8 +135,29 @@ struct NormalEstimationCfg
   double search_radius = 0.02;
   double kdtree_epsilon = 1e-5;
   std::array<double, 3> viewpoint_xyz = { 0.0, 0.0, 100.0 };
+  std::string method = "radius"; /** @brief "radius" searches the downsampled cloud, "organized" a pixel window */
+  int window_size = 7;            /** @brief pixels per side of the window used by the "organized" method */
+};
+
+struct DeduplicationCfg
+{
+  bool enable = false;      /** @brief fuses the curves of a bundle already seen by a previous bundle */
+  double voxel_size = 0.01; /** @brief in meters, points in or next to a voxel of another bundle are duplicates */
+  double min_overlap = 0.8; /** @brief fraction of duplicate points above which a whole curve is fused */
 };
 }  // namespace config_3d
+
+namespace config_exec
+{
+struct ExecutorCfg
+{
+  int num_threads = 1;                 /** @brief worker threads, 0 uses one per available cpu */
+  std::vector<int> cpu_affinity = {};  /** @brief cpus the workers are pinned to, empty disables pinning */
+  int opencv_threads = -1; /** @brief threads for OpenCV's parallel_for_, -1 splits the available cpus among workers */
+  int openmp_threads = -1; /** @brief threads for OpenMP regions in each worker, -1 splits the available cpus */
+  std::map<std::string, int> stage_limits = {}; /** @brief max concurrent tasks per stage, ("2d" or "3d") */
+};
+}  // namespace config_exec
 }  // namespace region_detection_core
 
 #endif /* INCLUDE_CONFIG_TYPES_H_ */
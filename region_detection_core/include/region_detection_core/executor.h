@@ -0,0 +1,182 @@
+/*
+ * @file executor.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_EXECUTOR_H_
+#define INCLUDE_REGION_DETECTION_CORE_EXECUTOR_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <log4cxx/logger.h>
+
+#include "region_detection_core/config_types.h"
+
+namespace region_detection_core
+{
+/**
+ * @class region_detection_core::Executor
+ * @brief Fixed size thread pool that owns the cpu budget of the detector.  The workers are pinned to the configured
+ * cpus and the OpenCV and OpenMP thread counts are derived from the same budget so that nested parallelism does not
+ * oversubscribe the host.
+ */
+class Executor
+{
+  struct StageSlots;
+
+public:
+  /**
+   * @class region_detection_core::Executor::StageGuard
+   * @brief Holds a concurrency slot of a stage and releases it when it goes out of scope
+   */
+  class StageGuard
+  {
+  public:
+    StageGuard() = default;
+    StageGuard(StageGuard&& other) : slots_(other.slots_) { other.slots_ = nullptr; }
+    StageGuard(const StageGuard&) = delete;
+    StageGuard& operator=(const StageGuard&) = delete;
+    ~StageGuard();
+
+  private:
+    friend class Executor;
+    explicit StageGuard(StageSlots* slots) : slots_(slots) {}
+    StageSlots* slots_ = nullptr;
+  };
+
+  Executor(const config_exec::ExecutorCfg& config = config_exec::ExecutorCfg(), log4cxx::LoggerPtr logger = nullptr);
+  virtual ~Executor();
+
+  /**
+   * @brief checks the configuration values
+   * @param config  The configuration to check
+   * @param err_msg (Output) Description of the first invalid value found
+   * @return True when valid, false otherwise
+   */
+  static bool validate(const config_exec::ExecutorCfg& config, std::string& err_msg);
+
+  /**
+   * @brief ids of the cpus this process may run on, read from its affinity mask which also reflects the cgroup cpuset
+   * of a container
+   */
+  static std::vector<int> getAvailableCpus();
+
+  /**
+   * @brief true when called from one of the worker threads of any executor
+   */
+  static bool isWorkerThread();
+
+  std::size_t getNumThreads() const;
+  int getOpenCVThreads() const;
+  int getOpenMPThreads() const;
+
+  /**
+   * @brief queues a task, tasks submitted from a worker thread run inline in order to prevent nested waits from
+   * starving the pool
+   * @param task  A callable with no arguments
+   * @return A future holding the result of the task
+   */
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> submit(F&& task);
+
+  /**
+   * @brief runs all the tasks and waits for them to finish, the first exception thrown by a task is rethrown after
+   * all of them have completed.
+   * @param tasks The tasks to run
+   */
+  void runAll(const std::vector<std::function<void()>>& tasks);
+
+  /**
+   * @brief blocks until a slot of the stage becomes available, stages without a configured limit return immediately
+   * @param stage The stage name
+   * @return A guard that releases the slot on destruction
+   */
+  StageGuard acquireStage(const std::string& stage);
+
+private:
+  struct StageSlots
+  {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int available;
+  };
+
+  void workerLoop();
+  void applyThreadSettings();
+
+  log4cxx::LoggerPtr logger_;
+  config_exec::ExecutorCfg config_;
+  int opencv_threads_;
+  int openmp_threads_;
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> queue_;
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  bool stop_;
+
+  std::map<std::string, std::unique_ptr<StageSlots>> stage_slots_;
+};
+
+template <typename F>
+std::future<typename std::result_of<F()>::type> Executor::submit(F&& task)
+{
+  using R = typename std::result_of<F()>::type;
+  auto packaged_task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+  std::future<R> result = packaged_task->get_future();
+  if (workers_.empty() || isWorkerThread())
+  {
+    (*packaged_task)();
+    return result;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_.emplace_back([packaged_task]() { (*packaged_task)(); });
+  }
+  queue_cv_.notify_one();
+  return result;
+}
+
+} /* namespace region_detection_core */
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_EXECUTOR_H_ */
@@ -0,0 +1,91 @@
+/*
+ * @file perf_counters.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_PERF_COUNTERS_H_
+#define INCLUDE_REGION_DETECTION_CORE_PERF_COUNTERS_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace region_detection_core
+{
+/**
+ * @class region_detection_core::PerfCounters
+ * @brief Hardware counters of the calling thread read through linux perf events.  The cycles, instructions,
+ * cache misses and branch misses are counted as a group, the events the cpu or the kernel do not support are left out.
+ * The work done by the threads of the opencv and openmp pools is not counted.
+ */
+class PerfCounters
+{
+public:
+  typedef std::map<std::string, std::uint64_t> Counts;
+
+  /**
+   * @brief opens the counters of the calling thread
+   * @param enable  When false the counters are not opened and stop() returns no counts
+   */
+  explicit PerfCounters(bool enable = true);
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  /**
+   * @brief false when disabled or when perf events are not available, e.g. not running on linux or restricted by
+   * kernel.perf_event_paranoid
+   */
+  bool isOpen() const;
+
+  /**
+   * @brief resets and starts the counters
+   */
+  void start();
+
+  /**
+   * @brief stops the counters
+   * @return  The counts since start() by event name, empty when the counters are not open
+   */
+  Counts stop();
+
+private:
+  int group_fd_ = -1;
+  std::vector<std::pair<std::string, int>> events_; /** @brief name and file descriptor of each open event */
+};
+
+}  // namespace region_detection_core
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_PERF_COUNTERS_H_ */
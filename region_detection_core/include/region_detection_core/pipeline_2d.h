@@ -0,0 +1,538 @@
+/*
+ * @file pipeline_2d.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_PIPELINE_2D_H_
+#define INCLUDE_REGION_DETECTION_CORE_PIPELINE_2D_H_
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "region_detection_core/region_detector.h"
+
+namespace region_detection_core
+{
+namespace detail
+{
+/**
+ * @brief Guo-Hall thinning of a binary image with values of 0 and 255, shared with the THINNING method
+ */
+void thinningGuoHall(cv::Mat& im);
+}  // namespace detail
+
+namespace pipeline_2d
+{
+/*
+ * Stages of a pipeline, each one is built from the opencv configuration and mirrors the 2d method of the same name.
+ * Pointwise stages map every pixel of a single channel 8 bit image independently and are folded into a single lookup
+ * table with their pointwise neighbours, the others process the whole image.  The output of a stage shares the
+ * buffer of its input when the pipeline owns it so the stages must support working in place.
+ */
+
+struct Grayscale
+{
+  static constexpr bool POINTWISE = false;
+  static const char* name() { return "GRAYSCALE"; }
+
+  explicit Grayscale(const RegionDetectionConfig::OpenCVCfg&) {}
+
+  bool operator()(const cv::Mat& input, cv::Mat& output) const
+  {
+    if (input.channels() == 1)
+    {
+      output = input;
+      return true;
+    }
+    cv::cvtColor(input, output, cv::COLOR_BGR2GRAY, 1);
+    return true;
+  }
+};
+
+struct Invert
+{
+  static constexpr bool POINTWISE = true;
+  static const char* name() { return "INVERT"; }
+
+  explicit Invert(const RegionDetectionConfig::OpenCVCfg&) {}
+
+  uchar map(uchar value) const { return 255 - value; }
+};
+
+struct Threshold
+{
+  static constexpr bool POINTWISE = true;
+  static const char* name() { return "THRESHOLD"; }
+
+  explicit Threshold(const RegionDetectionConfig::OpenCVCfg& config)
+    : value_(config.threshold.value)
+    , max_value_(config_2d::ThresholdCfg::MAX_BINARY_VALUE)
+    , type_(config.threshold.type)
+  {
+    if (type_ < cv::THRESH_BINARY || type_ > cv::THRESH_TOZERO_INV)
+    {
+      throw std::runtime_error("Threshold type " + std::to_string(type_) + " is not supported by the 2d pipeline");
+    }
+  }
+
+  uchar map(uchar value) const
+  {
+    const bool above = value > value_;
+    switch (type_)
+    {
+      case cv::THRESH_BINARY:
+        return above ? cv::saturate_cast<uchar>(max_value_) : 0;
+      case cv::THRESH_BINARY_INV:
+        return above ? 0 : cv::saturate_cast<uchar>(max_value_);
+      case cv::THRESH_TRUNC:
+        return above ? cv::saturate_cast<uchar>(value_) : value;
+      case cv::THRESH_TOZERO:
+        return above ? value : 0;
+      default:
+        return above ? 0 : value;
+    }
+  }
+
+private:
+  int value_;
+  int max_value_;
+  int type_;
+};
+
+template <int MORPH_OP>
+struct Morphology
+{
+  static constexpr bool POINTWISE = false;
+  static const char* name() { return MORPH_OP == cv::MORPH_ERODE ? "EROSION" : "DILATION"; }
+
+  /**
+   * @brief the element is validated and built once, its shape is taken from the dilation settings for both
+   * operations like the EROSION and DILATION methods do
+   */
+  explicit Morphology(const RegionDetectionConfig::OpenCVCfg& config)
+  {
+    const config_2d::MorphologicalCfg& morph_cfg = MORPH_OP == cv::MORPH_ERODE ? config.erosion : config.dilation;
+    if (config.dilation.kernel_size <= 0 || config.dilation.elem < cv::MORPH_RECT ||
+        config.dilation.elem > cv::MORPH_ELLIPSE)
+    {
+      throw std::runtime_error(std::string("Invalid ") + name() + " element");
+    }
+    element_ = cv::getStructuringElement(config.dilation.elem,
+                                         cv::Size(2 * morph_cfg.kernel_size + 1, 2 * morph_cfg.kernel_size + 1),
+                                         cv::Point(morph_cfg.kernel_size, morph_cfg.kernel_size));
+  }
+
+  bool operator()(const cv::Mat& input, cv::Mat& output) const
+  {
+    if (MORPH_OP == cv::MORPH_ERODE)
+    {
+      cv::erode(input, output, element_);
+    }
+    else
+    {
+      cv::dilate(input, output, element_);
+    }
+    return true;
+  }
+
+private:
+  cv::Mat element_;
+};
+
+using Erosion = Morphology<cv::MORPH_ERODE>;
+using Dilation = Morphology<cv::MORPH_DILATE>;
+
+struct Canny
+{
+  static constexpr bool POINTWISE = false;
+  static const char* name() { return "CANNY"; }
+
+  explicit Canny(const RegionDetectionConfig::OpenCVCfg& config)
+    : lower_threshold_(config.canny.lower_threshold)
+    , upper_threshold_(config.canny.upper_threshold)
+    , aperture_size_(std::max(2 * config.canny.aperture_size + 1, 3))
+  {
+  }
+
+  bool operator()(const cv::Mat& input, cv::Mat& output) const
+  {
+    // canny does not work in place
+    cv::Mat edges;
+    cv::Canny(input, edges, lower_threshold_, upper_threshold_, aperture_size_, true);
+    output = edges;
+    return true;
+  }
+
+private:
+  int lower_threshold_;
+  int upper_threshold_;
+  int aperture_size_;
+};
+
+struct Thinning
+{
+  static constexpr bool POINTWISE = false;
+  static const char* name() { return "THINNING"; }
+
+  explicit Thinning(const RegionDetectionConfig::OpenCVCfg&) {}
+
+  bool operator()(const cv::Mat& input, cv::Mat& output) const
+  {
+    if (input.type() != CV_8UC1)
+    {
+      return false;
+    }
+    if (output.data != input.data)
+    {
+      input.copyTo(output);
+    }
+    detail::thinningGuoHall(output);
+    return true;
+  }
+};
+
+/**
+ * @brief consecutive pointwise stages folded into a lookup table
+ */
+template <typename... Ps>
+class Lut
+{
+public:
+  explicit Lut(const RegionDetectionConfig::OpenCVCfg& config)
+  {
+    const std::tuple<Ps...> stages{ Ps(config)... };
+    for (int value = 0; value < 256; value++)
+    {
+      table_[value] = mapAll(stages, static_cast<uchar>(value), std::index_sequence_for<Ps...>());
+    }
+  }
+
+  uchar map(uchar value) const { return table_[value]; }
+
+  bool operator()(const cv::Mat& input, cv::Mat& output) const
+  {
+    if (input.type() != CV_8UC1)
+    {
+      return false;
+    }
+    output.create(input.size(), CV_8UC1);
+    const bool continuous = input.isContinuous() && output.isContinuous();
+    const int rows = continuous ? 1 : input.rows;
+    const int cols = continuous ? input.rows * input.cols : input.cols;
+    for (int r = 0; r < rows; r++)
+    {
+      const uchar* src = input.ptr<uchar>(r);
+      uchar* dst = output.ptr<uchar>(r);
+      for (int c = 0; c < cols; c++)
+      {
+        dst[c] = table_[src[c]];
+      }
+    }
+    return true;
+  }
+
+private:
+  template <std::size_t... I>
+  static uchar mapAll(const std::tuple<Ps...>& stages, uchar value, std::index_sequence<I...>)
+  {
+    using expand = int[];
+    (void)expand{ 0, (value = std::get<I>(stages).map(value), 0)... };
+    return value;
+  }
+
+  std::array<uchar, 256> table_;
+};
+
+/**
+ * @brief grayscale conversion followed by pointwise stages in a single pass over the color image, the gray level is
+ * computed with the same fixed point BT.601 weights as OpenCV
+ */
+template <typename... Ps>
+class GrayscaleLut
+{
+public:
+  explicit GrayscaleLut(const RegionDetectionConfig::OpenCVCfg& config) : lut_(config) {}
+
+  bool operator()(const cv::Mat& input, cv::Mat& output) const
+  {
+    if (input.type() == CV_8UC1)
+    {
+      return lut_(input, output);
+    }
+    if (input.depth() != CV_8U || (input.channels() != 3 && input.channels() != 4))
+    {
+      return false;
+    }
+
+    static constexpr int SHIFT = 14;
+    static constexpr int B2Y = 1868;
+    static constexpr int G2Y = 9617;
+    static constexpr int R2Y = 4899;
+    const int channels = input.channels();
+    cv::Mat gray(input.size(), CV_8UC1);
+    for (int r = 0; r < input.rows; r++)
+    {
+      const uchar* src = input.ptr<uchar>(r);
+      uchar* dst = gray.ptr<uchar>(r);
+      for (int c = 0; c < input.cols; c++, src += channels)
+      {
+        const int gray = (src[0] * B2Y + src[1] * G2Y + src[2] * R2Y + (1 << (SHIFT - 1))) >> SHIFT;
+        dst[c] = lut_.map(static_cast<uchar>(gray));
+      }
+    }
+    output = gray;
+    return true;
+  }
+
+private:
+  Lut<Ps...> lut_;
+};
+
+namespace detail
+{
+template <typename... Ts>
+struct TypeList
+{
+};
+
+/** @brief pointwise stages waiting to be folded, FROM_COLOR is set when they follow a grayscale conversion */
+template <bool FROM_COLOR, typename... Ps>
+struct PendingLut
+{
+};
+
+template <typename List, typename T>
+struct Append;
+
+template <typename... Ts, typename T>
+struct Append<TypeList<Ts...>, T>
+{
+  using type = TypeList<Ts..., T>;
+};
+
+template <typename Pending, typename P>
+struct AddPointwise;
+
+template <bool FROM_COLOR, typename... Ps, typename P>
+struct AddPointwise<PendingLut<FROM_COLOR, Ps...>, P>
+{
+  using type = PendingLut<FROM_COLOR, Ps..., P>;
+};
+
+template <typename Done, typename Pending>
+struct Flush;
+
+template <typename Done>
+struct Flush<Done, PendingLut<false>>
+{
+  using type = Done;
+};
+
+template <typename Done>
+struct Flush<Done, PendingLut<true>>
+{
+  using type = typename Append<Done, Grayscale>::type;
+};
+
+template <typename Done, typename P, typename... Ps>
+struct Flush<Done, PendingLut<false, P, Ps...>>
+{
+  using type = typename Append<Done, Lut<P, Ps...>>::type;
+};
+
+template <typename Done, typename P, typename... Ps>
+struct Flush<Done, PendingLut<true, P, Ps...>>
+{
+  using type = typename Append<Done, GrayscaleLut<P, Ps...>>::type;
+};
+
+/**
+ * @brief folds the pointwise runs of a chain of stages, the result is a TypeList of the stages actually run
+ */
+template <typename Done, typename Pending, typename... Stages>
+struct Fuse
+{
+  using type = typename Flush<Done, Pending>::type;
+};
+
+template <typename Done, typename Pending, typename S, typename... Rest>
+struct Fuse<Done, Pending, S, Rest...>
+{
+  using FlushedDone = typename Flush<Done, Pending>::type;
+  using Next = typename std::conditional<
+      std::is_same<S, Grayscale>::value,
+      Fuse<FlushedDone, PendingLut<true>, Rest...>,
+      typename std::conditional<S::POINTWISE,
+                                Fuse<Done, typename AddPointwise<Pending, S>::type, Rest...>,
+                                Fuse<typename Append<FlushedDone, S>::type, PendingLut<false>, Rest...>>::type>::type;
+  using type = typename Next::type;
+};
+
+template <typename List>
+struct ToTuple;
+
+template <typename... Ts>
+struct ToTuple<TypeList<Ts...>>
+{
+  using type = std::tuple<Ts...>;
+};
+
+template <typename... Ts>
+std::tuple<Ts...> makeStages(const RegionDetectionConfig::OpenCVCfg& config, TypeList<Ts...>)
+{
+  return std::tuple<Ts...>(Ts(config)...);
+}
+}  // namespace detail
+
+/**
+ * @class region_detection_core::pipeline_2d::Pipeline
+ * @brief 2d methods fixed at compile time, e.g. Pipeline<Grayscale, Erosion, Invert, Threshold, Thinning>.  The
+ * parameters are read and validated once from the configuration and the pointwise stages are fused so that the chain
+ * runs without the runtime dispatch of the methods list.  It produces the same images as the methods of the same names
+ * and can be installed in a RegionDetector with set2dPipeline.
+ */
+template <typename... Stages>
+class Pipeline
+{
+public:
+  using FusedStages = typename detail::Fuse<detail::TypeList<>, detail::PendingLut<false>, Stages...>::type;
+
+  /**
+   * @brief throws std::runtime_error when a stage does not support its configuration
+   */
+  explicit Pipeline(const RegionDetectionConfig::OpenCVCfg& config) : stages_(detail::makeStages(config, FusedStages()))
+  {
+  }
+
+  /**
+   * @brief names of the equivalent 2d methods, in order
+   */
+  static std::vector<std::string> getMethods() { return { Stages::name()... }; }
+
+  /**
+   * @param input   The image, it is not modified
+   * @param output  (Output) The result
+   * @return False when a stage does not support the image type
+   */
+  bool operator()(cv::Mat input, cv::Mat& output) const
+  {
+    cv::Mat current = input;
+    try
+    {
+      if (!apply(input, current, std::make_index_sequence<std::tuple_size<StageTuple>::value>()))
+      {
+        return false;
+      }
+    }
+    catch (cv::Exception&)
+    {
+      return false;
+    }
+    output = current;
+    return true;
+  }
+
+private:
+  using StageTuple = typename detail::ToTuple<FusedStages>::type;
+
+  template <std::size_t... I>
+  bool apply(const cv::Mat& input, cv::Mat& current, std::index_sequence<I...>) const
+  {
+    bool success = true;
+    using expand = int[];
+    (void)expand{ 0, (success = success && applyStage(std::get<I>(stages_), input, current), 0)... };
+    return success;
+  }
+
+  template <typename StageT>
+  static bool applyStage(const StageT& stage, const cv::Mat& input, cv::Mat& current)
+  {
+    // the first stage writes into a new buffer since the input may be shared with other stages
+    cv::Mat result = current.data == input.data ? cv::Mat() : current;
+    if (!stage(current, result))
+    {
+      return false;
+    }
+    current = result;
+    return true;
+  }
+
+  StageTuple stages_;
+};
+
+/**
+ * @brief replaces the 2d methods of the detector with a pipeline built from its configuration
+ * @param detector  The detector
+ * @param err_msg   (Output) The reason of the failure
+ * @return False when the configuration uses a stage graph, lists other methods than the pipeline stages or is not
+ * supported by them
+ */
+template <typename PipelineT>
+bool set2dPipeline(RegionDetector& detector, std::string& err_msg)
+{
+  const RegionDetectionConfig::OpenCVCfg& config = detector.getConfig().opencv_cfg;
+  if (!config.graph.nodes.empty())
+  {
+    err_msg = "The 2d pipeline can not replace a stage graph";
+    return false;
+  }
+  if (PipelineT::getMethods() != config.methods)
+  {
+    err_msg = "The 2d pipeline stages do not match the configured methods";
+    return false;
+  }
+
+  try
+  {
+    detector.set2dStage(PipelineT(config), PipelineT::getMethods());
+  }
+  catch (std::runtime_error& ex)
+  {
+    err_msg = ex.what();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace pipeline_2d
+}  // namespace region_detection_core
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_PIPELINE_2D_H_ */
@@ -0,0 +1,103 @@
+/*
+ * @file region_coverage.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_REGION_COVERAGE_H_
+#define INCLUDE_REGION_DETECTION_CORE_REGION_COVERAGE_H_
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <Eigen/Core>
+
+#include "region_detection_core/cloud_planes.h"
+
+namespace region_detection_core
+{
+/**
+ * @brief least squares plane of a curve
+ * @param curve     The points
+ * @param centroid  Set to the mean of the points, the plane goes through it
+ * @param axes      Set to the principal axes in increasing order of spread, the first one is the plane normal
+ * @return False when the curve has fewer than 3 points
+ */
+bool fitCurvePlane(const pcl::PointCloud<pcl::PointXYZ>& curve, Eigen::Vector3d& centroid, Eigen::Matrix3d& axes);
+
+/**
+ * @class region_detection_core::RegionCoverage
+ * @brief Closed regions found in some views, used to mark the pixels of another view that see the same areas.  Each
+ * region is approximated by the plane fitted to its curve and the curve's outline on that plane.
+ */
+class RegionCoverage
+{
+public:
+  /**
+   * @brief adds a closed curve, curves with fewer than 3 points are ignored
+   */
+  void addRegion(const pcl::PointCloud<pcl::PointXYZ>& closed_curve);
+
+  bool empty() const { return regions_.empty(); }
+  std::size_t size() const { return regions_.size(); }
+  void clear() { regions_.clear(); }
+
+  /**
+   * @brief marks the pixels of an organized cloud whose points lie inside one of the regions
+   * @param planes          The cloud, in the frame of the regions
+   * @param max_plane_dist  Largest distance of a point from the plane of a region, in meters
+   * @param margin          Pixels the marked areas are grown by
+   * @return A CV_8UC1 mask the size of the cloud, empty when no pixel is marked or the cloud is not organized
+   */
+  cv::Mat mask(const CloudPlanes& planes, double max_plane_dist, int margin) const;
+
+private:
+  struct Region
+  {
+    Eigen::Vector3f centroid;
+    Eigen::Vector3f normal;
+    Eigen::Vector3f u;  // in plane axes
+    Eigen::Vector3f v;
+    std::vector<cv::Point2f> outline;
+    cv::Point2f lower;  // bounds of the outline
+    cv::Point2f upper;
+  };
+
+  std::vector<Region> regions_;
+};
+
+}  // namespace region_detection_core
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_REGION_COVERAGE_H_ */
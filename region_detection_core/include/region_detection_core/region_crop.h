@@ -73,11 +73,19 @@ public:
 
   void setConfig(const RegionCropConfig& config);
   void setRegion(const EigenPose3dVector& closed_region);
+
+  /**
+   * @brief sets the region along with its plane, e.g. RegionDetector::RegionInfo::plane, the hull is then projected
+   * onto it instead of estimating the direction with the configured method
+   */
+  void setRegion(const EigenPose3dVector& closed_region, const Eigen::Hyperplane<double, 3>& plane);
   void setInput(const typename pcl::PointCloud<PointT>::ConstPtr& cloud);
   std::vector<int> filter(bool reverse = false);
 
 private:
   EigenPose3dVector closed_region_;
+  Eigen::Hyperplane<double, 3> plane_;
+  bool use_plane_;
   RegionCropConfig config_;
   typename pcl::PointCloud<PointT>::ConstPtr input_;
 };
@@ -36,6 +36,10 @@
 #ifndef INCLUDE_REGION_DETECTOR_H_
 #define INCLUDE_REGION_DETECTOR_H_
 
+#include <functional>
+#include <map>
+#include <memory>
+
 #include <log4cxx/logger.h>
 
 #include <opencv2/core.hpp>
@@ -47,10 +51,17 @@
 #include <Eigen/Geometry>
 #include <Eigen/StdVector>
 
+#include "region_detection_core/chain_contour.h"
 #include "region_detection_core/config_types.h"
+#include "region_detection_core/perf_counters.h"
+#include "region_detection_core/region_coverage.h"
+#include "region_detection_core/stage_graph.h"
 
 namespace region_detection_core
 {
+class BinaryImage;
+class Executor;
+
 enum class Methods2D : int
 {
   GRAYSCALE = 0,
@@ -96,6 +107,10 @@ struct RegionDetectionConfig
     config_2d::RangeCfg range;
     config_2d::HSVCfg hsv;
     config_2d::CLAHECfg clahe;
+    config_2d::StageGraphCfg graph; /** @brief when not empty it is used instead of the methods list */
+
+    /** @brief keeps binary images packed at one bit per pixel through the morphology and contour stages */
+    bool packed_binary = false;
 
     bool debug_mode_enable = false;
     std::string debug_window_name = "DEBUG_REGION_DETECTION";
@@ -115,6 +130,7 @@ struct RegionDetectionConfig
   {
     config_3d::StatisticalRemovalCfg stat_removal;
     config_3d::NormalEstimationCfg normal_est;
+    config_3d::DeduplicationCfg dedup;
 
     double max_merge_dist = 0.01;          /** @brief in meters */
     double closed_curve_max_dist = 0.01;   /** @brief in meters */
@@ -126,6 +142,40 @@ struct RegionDetectionConfig
     bool debug_mode_enable = false; /** @brief not used at the moment */
   } pcl_cfg;
 
+  struct IncrementalCfg
+  {
+    bool enable = false;            /** @brief reuses the results of the previous call for the unchanged data */
+    int tile_size = 32;             /** @brief size in pixels of the tiles the images are compared by */
+    int image_threshold = 0;        /** @brief largest channel difference of an unchanged pixel */
+    double depth_threshold = 0.001; /** @brief largest z difference of an unchanged point, in meters */
+  } incremental_cfg;
+
+  struct CrossViewCfg
+  {
+    bool enable = false;           /** @brief masks the closed regions of the previous bundles out of the next ones */
+    double max_plane_dist = 0.005; /** @brief largest distance of a point from the plane of a region, in meters */
+    int margin = 3;                /** @brief pixels the masked areas are grown by */
+  } cross_view_cfg;
+
+  struct OutputCfg
+  {
+    bool closed_regions = true; /** @brief poses of the closed regions */
+    bool open_regions = true;   /** @brief poses of the open regions */
+    bool images = true;         /** @brief contours drawn on each bundle, only needed by RegionResults::images */
+    bool contours = true;       /** @brief pixel contours of each bundle */
+    bool normals = true;        /** @brief curve normals of each bundle, always computed when poses are requested */
+    bool perf_counters = false; /** @brief hardware counters of each stage in the stage stats, linux only */
+  } output_cfg;
+
+  struct BackendCfg
+  {
+    std::string search = "kdtree"; /** @brief nearest point lookups of the 3d stages, "kdtree" or "brute_force" */
+    std::string profile_file = ""; /** @brief autotuning profile, its settings replace the search and the automatic
+                                      opencv thread count */
+  } backend_cfg;
+
+  config_exec::ExecutorCfg executor_cfg;
+
   static RegionDetectionConfig loadFromFile(const std::string& yaml_file);
   static RegionDetectionConfig load(const std::string& yaml_str);
 };
@@ -146,16 +196,96 @@ public:
   typedef std::vector<DataBundle, Eigen::aligned_allocator<DataBundle>> DataBundleVec;
 
   typedef std::vector<Eigen::Isometry3d, Eigen::aligned_allocator<Eigen::Isometry3d>> EigenPose3dVector;
+  struct StageStats
+  {
+    std::vector<double> durations; /** @brief seconds, one sample per bundle for the "2d" and "3d" stages */
+
+    /** @brief "cycles", "instructions", "cache_misses" and "branch_misses" of each sample, only filled when
+     * OutputCfg::perf_counters is enabled */
+    std::map<std::string, std::vector<std::uint64_t>> counters;
+  };
+
+  /**
+   * @brief where a closed region comes from and the plane fitted to it
+   */
+  struct RegionInfo
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    int bundle = -1;                    /** @brief source bundle, -1 for the regions merged from open curves */
+    std::vector<cv::Point> pixels;      /** @brief polygon in the bundle image, empty for the merged regions */
+    Eigen::Hyperplane<double, 3> plane; /** @brief fitted plane, its normal is on the side of the poses' z axes */
+  };
+  typedef std::vector<RegionInfo, Eigen::aligned_allocator<RegionInfo>> RegionInfoVector;
+
   struct RegionResults
   {
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
     std::vector<EigenPose3dVector> closed_regions_poses;
     std::vector<EigenPose3dVector> open_regions_poses;
+    RegionInfoVector closed_regions_info; /** @brief one per closed region, in the order of the poses */
 
     // additional results
     std::vector<cv::Mat> images;
+    std::vector<std::vector<std::vector<cv::Point>>> contours; /** @brief pixel contours found in each bundle */
+    std::map<std::string, StageStats> stage_stats; /** @brief timing of the "2d", "3d", "merge" and "poses" stages */
+
+    bool succeeded = false; /** @brief same as the value returned by compute, true when closed regions were found */
+    std::string err_msg;    /** @brief why it failed: a failed bundle, a cancellation or no closed regions found */
+
+    /**
+     * @brief empties the results but keeps their storage so that they can be reused
+     */
+    void clear();
+  };
+
+  /**
+   * @brief curves and normals found in a single data bundle
+   */
+  struct BundleCurves
+  {
+    cv::Mat image;
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> closed_curves;
+    std::vector<std::vector<cv::Point>> closed_pixels; /** @brief pixel polygon of each closed curve */
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> open_curves;
+    std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr> normals;
+    std::vector<std::vector<cv::Point>> contours;
+    std::map<std::string, double> durations; /** @brief seconds spent in the "2d" and "3d" stages */
+    std::map<std::string, PerfCounters::Counts> counters; /** @brief hardware counters of the "2d" and "3d" stages */
+
+    /**
+     * @brief deep copy of the curves
+     */
+    BundleCurves clone() const;
+  };
+
+  /**
+   * @brief optional hooks used to follow and stop a computation, they are called from the worker threads
+   */
+  struct ComputeMonitor
+  {
+    /** @brief polled before each stage, returning true stops the computation */
+    std::function<bool()> is_canceled;
+
+    /** @brief called when the "curves", "merge" and "poses" stages start */
+    std::function<void(const std::string& stage)> on_stage;
+
+    /** @brief called once the curves of a bundle are found */
+    std::function<void(std::size_t bundle, const BundleCurves& curves)> on_bundle_curves;
+
+    /**
+     * @brief called with the poses of each closed region of a bundle as soon as the bundles before it are done, in
+     * the order of the results.  These early poses only use the normals of their own bundle, the results recompute
+     * them with the normals of all the bundles.  The regions merged from open curves are only in the results.  The
+     * calls are serialized but can come from any worker thread.
+     */
+    std::function<void(std::size_t bundle, const EigenPose3dVector& poses)> on_closed_region;
   };
 
+  /**
+   * @brief custom 2d stage that turns the input image into the mask passed to the contour detection
+   */
+  using Stage2D = std::function<bool(cv::Mat input, cv::Mat& output)>;
+
   RegionDetector(const RegionDetectionConfig& config, log4cxx::LoggerPtr logger = nullptr);
   RegionDetector(log4cxx::LoggerPtr logger = nullptr);
   virtual ~RegionDetector();
@@ -166,6 +296,21 @@ public:
   bool configureFromFile(const std::string& yaml_file);
   const RegionDetectionConfig& getConfig();
 
+  /**
+   * @brief replaces the configured 2d methods, e.g. with a compiled pipeline_2d::Pipeline.  The stage is called
+   * concurrently for several bundles, the incremental mode reruns it on the whole image.
+   * @param stage   The stage, an empty function restores the configured methods
+   * @param methods Names of the equivalent 2d methods when known, the contour detection traces the lines of the mask
+   *                when they end with THINNING
+   */
+  void set2dStage(Stage2D stage, std::vector<std::string> methods = {});
+
+  /**
+   * @brief selects the results produced by the following calls, the products that are not requested are skipped
+   * @param outputs The results to produce
+   */
+  void setOutputs(const RegionDetectionConfig::OutputCfg& outputs);
+
   /**
    * @brief computes contours from images
    * @param input             Input image
@@ -188,15 +333,84 @@ public:
   /**
    * @brief computes contours
    * @param input   A vector of data structures containing point clouds and images
-   * @param regions (Output) the detected regions
+   * @param regions (Output) the detected regions, previous results are cleared
    * @return True on success, false otherwise
    */
-  bool compute(const DataBundleVec& input, RegionDetector::RegionResults& regions);
+  bool compute(const DataBundleVec& input,
+               RegionDetector::RegionResults& regions,
+               const ComputeMonitor& monitor = ComputeMonitor());
+
+  /**
+   * @brief same as above but takes ownership of the input so that its images and clouds are moved instead of copied.
+   * The image buffers may be kept by the detector and should not be written to by the caller afterwards, images that
+   * wrap external memory are copied instead.
+   */
+  bool compute(DataBundleVec&& input,
+               RegionDetector::RegionResults& regions,
+               const ComputeMonitor& monitor = ComputeMonitor());
+
+  /**
+   * @brief takes ownership of the input and returns the results, RegionResults::succeeded and RegionResults::err_msg
+   * tell whether closed regions were found and why not
+   */
+  RegionResults compute(DataBundleVec&& input, const ComputeMonitor& monitor = ComputeMonitor());
+
+  /**
+   * @brief first half of compute, finds the curves of each bundle independently
+   * @param input   A vector of data structures containing point clouds and images
+   * @param curves  (Output) The curves of each bundle, in the same order as the input
+   * @param monitor Hooks to follow and cancel the computation
+   * @return True when all the bundles succeeded, false otherwise or when canceled
+   */
+  bool computeCurves(const DataBundleVec& input,
+                     std::vector<BundleCurves>& curves,
+                     const ComputeMonitor& monitor = ComputeMonitor());
+
+  /**
+   * @brief same as above but takes ownership of the input
+   */
+  bool computeCurves(DataBundleVec&& input,
+                     std::vector<BundleCurves>& curves,
+                     const ComputeMonitor& monitor = ComputeMonitor());
+
+  /**
+   * @brief second half of compute, merges the curves of all the bundles and computes the region poses.  The curves
+   * may come from several detectors as long as they share the same configuration.
+   * @param curves  The curves of each bundle
+   * @param regions (Output) the detected regions, previous results are cleared
+   * @param monitor Hooks to follow and cancel the computation
+   * @return True when closed regions were found, false otherwise or when canceled
+   */
+  bool computeRegions(const std::vector<BundleCurves>& curves,
+                      RegionDetector::RegionResults& regions,
+                      const ComputeMonitor& monitor = ComputeMonitor());
+
+  /**
+   * @brief same as above but takes ownership of the curves so that their images and contours are moved into the results
+   */
+  bool computeRegions(std::vector<BundleCurves>&& curves,
+                      RegionDetector::RegionResults& regions,
+                      const ComputeMonitor& monitor = ComputeMonitor());
 
   static log4cxx::LoggerPtr createDefaultInfoLogger(const std::string& logger_name);
   static log4cxx::LoggerPtr createDefaultDebugLogger(const std::string& logger_name);
 
 private:
+  // the owned arguments point to the input when the caller gave up its ownership and are nullptr otherwise
+  bool compute(const DataBundleVec& input,
+               DataBundleVec* owned_input,
+               RegionDetector::RegionResults& regions,
+               const ComputeMonitor& monitor);
+  bool computeCurves(const DataBundleVec& input,
+                     DataBundleVec* owned_input,
+                     std::vector<BundleCurves>& curves,
+                     const ComputeMonitor& monitor,
+                     std::string* err_msg = nullptr);
+  bool computeRegions(const std::vector<BundleCurves>& curves,
+                      std::vector<BundleCurves>* owned_curves,
+                      RegionDetector::RegionResults& regions,
+                      const ComputeMonitor& monitor);
+
   /**
    * @class region_detection_core::RegionDetector::Result
    * @brief Convenience class that can be evaluated as a bool and contains an error message, used internally
@@ -233,6 +447,54 @@ private:
     std::string msg;
   };
 
+  /**
+   * @brief curves found by the 2d stages in pixel coordinates, the closed curves come first
+   */
+  struct PixelCurves
+  {
+    std::vector<ChainContour> contours;
+    std::size_t num_closed = 0;
+  };
+
+  /**
+   * @brief config values that each cached stage output depends on, a stage is rerun when its key changes
+   */
+  struct StageKeys
+  {
+    std::string mask;     /** @brief 2d methods */
+    std::string contours; /** @brief contour tracing and pixel curves processing */
+    std::string points;   /** @brief 3d outlier removal and normals */
+    std::string curves;   /** @brief 3d splitting */
+
+    bool operator==(const StageKeys& other) const
+    {
+      return mask == other.mask && contours == other.contours && points == other.points && curves == other.curves;
+    }
+  };
+
+  /**
+   * @brief data and results of the previous call for a bundle, used by the incremental mode
+   */
+  struct BundleCache
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    bool valid = false;
+    StageKeys keys;
+    cv::Mat image;
+    pcl::PCLPointCloud2 cloud_blob;
+    Eigen::Isometry3d transform;
+    cv::Mat mask;
+    cv::Mat covered; /** @brief pixels masked out by the regions of the previous bundles */
+    PixelCurves pixel_curves;
+
+    // 3d points and normals of each pixel curve before splitting
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> points;
+    std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr> normals;
+    BundleCurves curves;
+  };
+
+  static StageKeys makeStageKeys(const RegionDetectionConfig& cfg);
+
   // 2d methods
   void updateDebugWindow(const cv::Mat& im) const;
 
@@ -248,11 +510,113 @@ private:
   RegionDetector::Result apply2dEqualizeHist(cv::Mat input, cv::Mat& output) const;
   RegionDetector::Result apply2dCLAHE(cv::Mat input, cv::Mat& output) const;
 
+  RegionDetector::Result createDilationElement(cv::Mat& element) const;
+  RegionDetector::Result createErosionElement(cv::Mat& element) const;
+  RegionDetector::Result applyPackedMorphology(Methods2D method, BinaryImage& image) const;
+
+  /**
+   * @brief applies the methods in order
+   * @param packed_output (Output) Set when the last methods were computed on the packed image, it holds the same
+   * pixels as the output
+   */
+  Result apply2dMethods(const std::vector<std::string>& methods,
+                        cv::Mat input,
+                        cv::Mat& output,
+                        BinaryImage* packed_output = nullptr) const;
+  Result compute2dGraph(cv::Mat input, cv::Mat& output) const;
+
+  /**
+   * @brief same as compute2d, the packed output is only set by the configured methods
+   */
+  bool compute2dMask(cv::Mat input, cv::Mat& output, BinaryImage* packed_output) const;
+
   Result compute2dContours(cv::Mat input, std::vector<std::vector<cv::Point>>& contours_indices, cv::Mat& output) const;
 
+  /**
+   * @brief traces the contours of the mask
+   * @param packed_mask The mask already packed, when empty or null the mask is packed if the config asks for it
+   */
+  Result traceContours(const cv::Mat& mask,
+                       std::vector<std::vector<cv::Point>>& contours_indices,
+                       cv::Mat& output,
+                       const BinaryImage* packed_mask = nullptr) const;
+  Result compute2dCurves(const cv::Mat& mask,
+                         PixelCurves& pixel_curves,
+                         cv::Mat& output,
+                         const BinaryImage* packed_mask = nullptr);
+
+  /**
+   * @brief true when the mask is a skeleton that is traced with traceSkeleton instead of cv::findContours, the curves
+   * are then already ordered
+   */
+  bool tracesSkeleton(const cv::Mat& mask) const;
+
+  /**
+   * @brief reruns the 2d methods only on the changed tiles when all of them are local operations
+   * @param image         The new image
+   * @param cache         Holds the 2d output of the previous image
+   * @param changed_tiles The tiles that differ from the previous image
+   * @param mask          (Output) The 2d output for the new image
+   */
+  Result computeIncremental2d(const cv::Mat& image,
+                              const BundleCache& cache,
+                              const std::vector<cv::Rect>& changed_tiles,
+                              cv::Mat& mask) const;
+
+  /**
+   * @brief distance in pixels over which the 2d methods propagate changes, -1 when a method depends on the whole image
+   * or a custom 2d stage is set
+   */
+  int get2dHalo() const;
+
   // 3d methods
 
-  Result extractContoursFromCloud(const std::vector<std::vector<cv::Point>>& contours_indices,
+  /**
+   * @brief computes the curves of a single bundle
+   * @param data        The bundle
+   * @param owned_data  Same as data when its image and cloud can be moved into the cache, nullptr otherwise
+   * @param curves      (Output) The curves found
+   * @param cache       Results of the previous call for this bundle, nullptr when the incremental mode is disabled
+   * @param coverage    Closed regions of the previous bundles whose pixels are left out of the contours, or nullptr
+   * @param monitor     Polled for cancellation between the 2d and 3d stages
+   */
+  Result computeBundleCurves(const DataBundle& data,
+                             DataBundle* owned_data,
+                             BundleCurves& curves,
+                             BundleCache* cache,
+                             const RegionCoverage* coverage,
+                             const ComputeMonitor& monitor = ComputeMonitor());
+
+  /**
+   * @brief extracts and cleans the 3d points of each pixel curve and computes their normals
+   * @param data          The bundle
+   * @param pixel_curves  The curves found by the 2d stages
+   * @param points        (Output) The 3d points of each pixel curve
+   * @param normals       (Output) The normals of each pixel curve, empty when no output needs them
+   */
+  Result compute3dPoints(const DataBundle& data,
+                         const PixelCurves& pixel_curves,
+                         std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& points,
+                         std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr>& normals);
+
+  /**
+   * @brief compute3dPoints for the "organized" normal estimation, samples the points and estimates their normals over
+   * pixel windows of a tiled copy of the bundle's cloud
+   */
+  Result computeOrganized3dPoints(const DataBundle& data,
+                                  const PixelCurves& pixel_curves,
+                                  std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& points,
+                                  std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr>& normals);
+
+  /**
+   * @brief splits the 3d points into the closed and open curves, the points are left unchanged.  The closed curves
+   * keep the polygon of their pixel contour.
+   */
+  Result split3dCurves(const std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& points,
+                       const PixelCurves& pixel_curves,
+                       BundleCurves& curves);
+
+  Result extractContoursFromCloud(const std::vector<ChainContour>& contours_indices,
                                   pcl::PointCloud<pcl::PointXYZ>::ConstPtr input,
                                   std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& contours_points);
 
@@ -286,6 +650,11 @@ private:
 
   log4cxx::LoggerPtr logger_;
   std::shared_ptr<RegionDetectionConfig> cfg_;
+  std::shared_ptr<Executor> executor_;
+  StageGraph stage_graph_;
+  Stage2D stage_2d_;
+  std::vector<std::string> stage_2d_methods_;
+  std::vector<BundleCache, Eigen::aligned_allocator<BundleCache>> bundle_caches_;
   std::size_t window_counter_;
 };
 
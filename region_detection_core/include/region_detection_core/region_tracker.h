@@ -0,0 +1,131 @@
+/*
+ * @file region_tracker.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_REGION_TRACKER_H_
+#define INCLUDE_REGION_DETECTION_CORE_REGION_TRACKER_H_
+
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "region_detection_core/region_detector.h"
+
+namespace region_detection_core
+{
+struct RegionTrackerConfig
+{
+  int redetect_interval = 10;         /** @brief frames between full detections, 1 detects on every frame */
+  int roi_margin = 20;                /** @brief pixels added around the previous contours to allow for motion */
+  double max_association_dist = 0.05; /** @brief largest centroid displacement of a tracked region, in meters */
+  int max_missed_frames = 3;          /** @brief a track is dropped after missing this many consecutive frames */
+};
+
+/**
+ * @class region_detection_core::RegionTracker
+ * @brief Runs the detector on a stream of frames, between full detections only the areas around the contours of the
+ * previous frame are searched and the regions found are associated to the existing tracks by their centroids
+ */
+class RegionTracker
+{
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  struct TrackedRegion
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    int id;
+    bool closed;
+    RegionDetector::EigenPose3dVector poses;
+    Eigen::Vector3d centroid;
+    int age = 0;    /** @brief frames since the region was first detected */
+    int missed = 0; /** @brief consecutive frames in which the region was not found */
+  };
+
+  struct TrackingResults
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    std::vector<TrackedRegion, Eigen::aligned_allocator<TrackedRegion>> regions; /** @brief regions found this frame */
+    bool full_detection = false; /** @brief true when the whole frame was searched */
+    RegionDetector::RegionResults detection;
+  };
+
+  RegionTracker(std::shared_ptr<RegionDetector> detector, const RegionTrackerConfig& config = RegionTrackerConfig());
+  virtual ~RegionTracker();
+
+  void setConfig(const RegionTrackerConfig& config);
+
+  /**
+   * @brief detects the regions in the next frame of the stream
+   * @param input   The data bundles of the frame, the clouds must be organized in order to search the regions of
+   * interest
+   * @param results (Output) The regions found with their track ids
+   * @return True when at least one region was found, false otherwise
+   */
+  bool update(const RegionDetector::DataBundleVec& input, TrackingResults& results);
+
+  /**
+   * @brief drops all the tracks, the next frame is searched in full
+   */
+  void reset();
+
+private:
+  /**
+   * @brief a cropped region of interest of one of the input bundles
+   */
+  struct RoiBundle
+  {
+    std::size_t bundle_index;
+    cv::Rect roi;
+  };
+
+  bool predictRois(const RegionDetector::DataBundleVec& input,
+                   RegionDetector::DataBundleVec& roi_input,
+                   std::vector<RoiBundle>& roi_bundles) const;
+  void updateContours(const std::vector<RoiBundle>& roi_bundles,
+                      std::size_t num_bundles,
+                      const RegionDetector::RegionResults& detection);
+  void associate(const RegionDetector::RegionResults& detection, TrackingResults& results);
+
+  std::shared_ptr<RegionDetector> detector_;
+  RegionTrackerConfig config_;
+  std::vector<TrackedRegion, Eigen::aligned_allocator<TrackedRegion>> tracks_;
+  std::vector<std::vector<std::vector<cv::Point>>> contours_; /** @brief pixel contours of each bundle, last frame */
+  std::size_t frames_since_detection_ = 0;
+  int next_id_ = 0;
+};
+
+} /* namespace region_detection_core */
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_REGION_TRACKER_H_ */
@@ -0,0 +1,58 @@
+/*
+ * @file skeleton_tracer.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_SKELETON_TRACER_H_
+#define INCLUDE_REGION_DETECTION_CORE_SKELETON_TRACER_H_
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace region_detection_core
+{
+/**
+ * @brief walks the non zero pixels of a one pixel wide skeleton, such as the output of the THINNING method, once and
+ * returns its branches as ordered polylines.  The branches are split at the endpoints and junctions, a junction pixel
+ * ends every branch meeting there, and the loops without junctions start and end at neighboring pixels.  A diagonal
+ * neighbor is only followed when neither of the pixels sharing a side with both is set, so the staircases left by the
+ * thinning are not taken for junctions.  Isolated pixels are dropped.
+ * @param skeleton  The skeleton, must be CV_8UC1
+ * @param polylines (Output) The branches found
+ * @return False when the image type is not supported
+ */
+bool traceSkeleton(const cv::Mat& skeleton, std::vector<std::vector<cv::Point>>& polylines);
+
+}  // namespace region_detection_core
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_SKELETON_TRACER_H_ */
@@ -0,0 +1,110 @@
+/*
+ * @file stage_graph.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_STAGE_GRAPH_H_
+#define INCLUDE_REGION_DETECTION_CORE_STAGE_GRAPH_H_
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "region_detection_core/config_types.h"
+
+namespace region_detection_core
+{
+enum class CombineOp : int
+{
+  NONE = 0,
+  AND,
+  OR,
+  XOR
+};
+
+/**
+ * @class region_detection_core::StageGraph
+ * @brief Execution plan of a 2d stage graph.  Nodes are grouped into levels where every node only depends on nodes
+ * of earlier levels so that the nodes of a level can run concurrently and each intermediate image is computed once.
+ */
+class StageGraph
+{
+public:
+  static const std::string INPUT_NODE;
+  static const std::size_t INPUT_INDEX = std::numeric_limits<std::size_t>::max();
+
+  struct Node
+  {
+    std::string name;
+    std::vector<std::size_t> inputs; /** @brief node indices, INPUT_INDEX for the source image */
+    std::vector<std::string> methods;
+    CombineOp combine = CombineOp::NONE;
+    std::size_t num_consumers = 0; /** @brief number of nodes using this node's image */
+  };
+
+  StageGraph();
+  virtual ~StageGraph();
+
+  /**
+   * @brief validates the graph structure and computes the execution levels
+   * @param config  The graph configuration
+   * @param err_msg (Output) the reason the graph is invalid
+   * @return  True on success, false otherwise
+   */
+  bool build(const config_2d::StageGraphCfg& config, std::string& err_msg);
+
+  bool empty() const;
+  const std::vector<Node>& getNodes() const;
+  const std::vector<std::vector<std::size_t>>& getLevels() const;
+  std::size_t getOutputIndex() const;
+
+  /**
+   * @brief combines single channel masks of the same size
+   * @param op      The combination operator
+   * @param inputs  The masks to combine, at least one
+   * @param output  (Output) the combined mask
+   * @param err_msg (Output) error description
+   * @return  True on success, false otherwise
+   */
+  static bool combine(CombineOp op, const std::vector<cv::Mat>& inputs, cv::Mat& output, std::string& err_msg);
+
+private:
+  std::vector<Node> nodes_;
+  std::vector<std::vector<std::size_t>> levels_;
+  std::size_t output_index_;
+};
+
+} /* namespace region_detection_core */
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_STAGE_GRAPH_H_ */
@@ -0,0 +1,137 @@
+/*
+ * @file tiled_cloud.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_CORE_TILED_CLOUD_H_
+#define INCLUDE_REGION_DETECTION_CORE_TILED_CLOUD_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "region_detection_core/cloud_planes.h"
+
+namespace region_detection_core
+{
+/**
+ * @class region_detection_core::TiledCloud
+ * @brief Organized cloud stored in tiles of TILE_SIZE x TILE_SIZE points, the points of each tile are in Morton
+ * order.  A pixel window of the cloud is then read from a few contiguous blocks instead of striding over whole rows of
+ * the sensor.  Only the coordinates are kept, as three floats per point.
+ */
+class TiledCloud
+{
+public:
+  static const int TILE_BITS = 3;
+  static const int TILE_SIZE = 1 << TILE_BITS;
+
+  struct Point
+  {
+    float x;
+    float y;
+    float z;
+
+    bool isFinite() const { return std::isfinite(x) && std::isfinite(y) && std::isfinite(z); }
+  };
+
+  TiledCloud();
+
+  /**
+   * @brief copies the coordinates of an organized cloud into the tiles
+   * @param planes  The cloud
+   * @return False when the cloud is not organized
+   */
+  bool build(const CloudPlanes& planes);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  /**
+   * @brief point at the given column and row
+   */
+  const Point& at(int x, int y) const { return points_[index(x, y)]; }
+
+  /**
+   * @brief visits the points of the window of (2 * half_size + 1) pixels per side centered at the given column and row,
+   * tile by tile and clipped to the cloud
+   * @param visitor Called as visitor(x, y, point)
+   */
+  template <typename Visitor>
+  void forEachInWindow(int x, int y, int half_size, Visitor&& visitor) const
+  {
+    int x0 = std::max(0, x - half_size), x1 = std::min(width_ - 1, x + half_size);
+    int y0 = std::max(0, y - half_size), y1 = std::min(height_ - 1, y + half_size);
+    for (int tile_y = y0 >> TILE_BITS; tile_y <= y1 >> TILE_BITS; tile_y++)
+    {
+      for (int tile_x = x0 >> TILE_BITS; tile_x <= x1 >> TILE_BITS; tile_x++)
+      {
+        const Point* tile = &points_[static_cast<std::size_t>(tile_y * tiles_per_row_ + tile_x) << (2 * TILE_BITS)];
+        int py0 = std::max(y0, tile_y << TILE_BITS), py1 = std::min(y1, ((tile_y + 1) << TILE_BITS) - 1);
+        int px0 = std::max(x0, tile_x << TILE_BITS), px1 = std::min(x1, ((tile_x + 1) << TILE_BITS) - 1);
+        for (int py = py0; py <= py1; py++)
+        {
+          for (int px = px0; px <= px1; px++)
+          {
+            visitor(px, py, tile[morton(px & (TILE_SIZE - 1), py & (TILE_SIZE - 1))]);
+          }
+        }
+      }
+    }
+  }
+
+private:
+  /**
+   * @brief interleaves the bits of the coordinates inside a tile, x takes the even bits
+   */
+  static int morton(int x, int y)
+  {
+    static const std::uint8_t SPREAD[TILE_SIZE] = { 0, 1, 4, 5, 16, 17, 20, 21 };
+    return SPREAD[x] | (SPREAD[y] << 1);
+  }
+
+  std::size_t index(int x, int y) const
+  {
+    std::size_t tile = static_cast<std::size_t>((y >> TILE_BITS) * tiles_per_row_ + (x >> TILE_BITS));
+    return (tile << (2 * TILE_BITS)) + morton(x & (TILE_SIZE - 1), y & (TILE_SIZE - 1));
+  }
+
+  int width_;
+  int height_;
+  int tiles_per_row_;
+  std::vector<Point> points_;
+};
+
+}  // namespace region_detection_core
+
+#endif /* INCLUDE_REGION_DETECTION_CORE_TILED_CLOUD_H_ */
@@ -0,0 +1,229 @@
+/*
+ * @file autotuner.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include <boost/format.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include "region_detection_core/autotuner.h"
+#include "region_detection_core/executor.h"
+
+static const std::vector<std::string> SEARCH_BACKENDS = { "kdtree", "brute_force" };
+
+namespace region_detection_core
+{
+bool AutotuneProfile::load(const std::string& yaml_file, AutotuneProfile& profile, std::string& err_msg)
+{
+  try
+  {
+    YAML::Node root = YAML::LoadFile(yaml_file);
+    profile.search = root["search"].as<std::string>();
+    profile.opencv_threads = root["opencv_threads"].as<int>();
+    profile.cpus = root["cpus"].as<int>();
+    profile.timings = root["timings"].as<std::map<std::string, double>>(std::map<std::string, double>());
+  }
+  catch (YAML::Exception& e)
+  {
+    err_msg = boost::str(boost::format("Failed to load autotuning profile %s: %s") % yaml_file % e.what());
+    return false;
+  }
+
+  if (std::find(SEARCH_BACKENDS.begin(), SEARCH_BACKENDS.end(), profile.search) == SEARCH_BACKENDS.end())
+  {
+    err_msg = boost::str(boost::format("Invalid search backend '%s' in profile %s") % profile.search % yaml_file);
+    return false;
+  }
+  return true;
+}
+
+bool AutotuneProfile::save(const std::string& yaml_file, std::string& err_msg) const
+{
+  YAML::Node root;
+  root["search"] = search;
+  root["opencv_threads"] = opencv_threads;
+  root["cpus"] = cpus;
+  root["timings"] = timings;
+
+  std::ofstream file(yaml_file);
+  if (!file)
+  {
+    err_msg = boost::str(boost::format("Failed to open %s for writing") % yaml_file);
+    return false;
+  }
+  file << root << std::endl;
+  return true;
+}
+
+Autotuner::Autotuner(log4cxx::LoggerPtr logger)
+  : logger_(logger ? logger : RegionDetector::createDefaultInfoLogger("Autotuner"))
+{
+}
+
+bool Autotuner::benchmark(const RegionDetectionConfig& config,
+                          const RegionDetector::DataBundleVec& samples,
+                          const std::vector<std::string>& stages,
+                          int repetitions,
+                          double& seconds,
+                          std::vector<std::size_t>& region_sizes)
+{
+  RegionDetector detector(logger_);
+  if (!detector.configure(config))
+  {
+    return false;
+  }
+
+  seconds = std::numeric_limits<double>::max();
+  RegionDetector::RegionResults results;
+  for (int i = 0; i < repetitions; i++)
+  {
+    if (!detector.compute(samples, results))
+    {
+      LOG4CXX_ERROR(logger_, "Detection failed while benchmarking");
+      return false;
+    }
+
+    double run_seconds = 0.0;
+    for (const std::string& stage : stages)
+    {
+      auto stats = results.stage_stats.find(stage);
+      if (stats != results.stage_stats.end())
+      {
+        for (double d : stats->second.durations)
+        {
+          run_seconds += d;
+        }
+      }
+    }
+    seconds = std::min(seconds, run_seconds);
+  }
+
+  region_sizes.clear();
+  for (const auto& poses : results.closed_regions_poses)
+  {
+    region_sizes.push_back(poses.size());
+  }
+  for (const auto& poses : results.open_regions_poses)
+  {
+    region_sizes.push_back(poses.size());
+  }
+  return true;
+}
+
+bool Autotuner::run(const RegionDetectionConfig& config,
+                    const RegionDetector::DataBundleVec& samples,
+                    AutotuneProfile& profile,
+                    int repetitions)
+{
+  if (samples.empty() || repetitions < 1)
+  {
+    LOG4CXX_ERROR(logger_, "Autotuning needs at least one sample and one repetition");
+    return false;
+  }
+
+  // every run starts from scratch and the profile in use is not applied to the candidates
+  RegionDetectionConfig candidate_cfg = config;
+  candidate_cfg.incremental_cfg.enable = false;
+  candidate_cfg.opencv_cfg.debug_mode_enable = false;
+  candidate_cfg.backend_cfg.profile_file.clear();
+
+  profile = AutotuneProfile();
+  profile.cpus = static_cast<int>(Executor::getAvailableCpus().size());
+  profile.search = candidate_cfg.backend_cfg.search;
+
+  // the configured settings are the reference the results of the candidates are compared against
+  double seconds;
+  std::vector<std::size_t> reference_sizes, region_sizes;
+  if (!benchmark(candidate_cfg, samples, { "2d" }, 1, seconds, reference_sizes))
+  {
+    return false;
+  }
+
+  // opencv threads, doubled up to the number of cpus
+  std::vector<int> thread_counts;
+  for (int n = 1; n < profile.cpus; n *= 2)
+  {
+    thread_counts.push_back(n);
+  }
+  thread_counts.push_back(profile.cpus);
+
+  double best_seconds = std::numeric_limits<double>::max();
+  for (int n : thread_counts)
+  {
+    candidate_cfg.executor_cfg.opencv_threads = n;
+    if (!benchmark(candidate_cfg, samples, { "2d" }, repetitions, seconds, region_sizes))
+    {
+      return false;
+    }
+    profile.timings["opencv_threads/" + std::to_string(n)] = seconds;
+    LOG4CXX_INFO(logger_, "opencv threads " << n << ": " << seconds << " s");
+    if (region_sizes == reference_sizes && seconds < best_seconds)
+    {
+      best_seconds = seconds;
+      profile.opencv_threads = n;
+    }
+  }
+  candidate_cfg.executor_cfg.opencv_threads = profile.opencv_threads;
+
+  // search backends
+  best_seconds = std::numeric_limits<double>::max();
+  for (const std::string& search : SEARCH_BACKENDS)
+  {
+    candidate_cfg.backend_cfg.search = search;
+    if (!benchmark(candidate_cfg, samples, { "3d", "merge", "poses" }, repetitions, seconds, region_sizes))
+    {
+      return false;
+    }
+    profile.timings["search/" + search] = seconds;
+    LOG4CXX_INFO(logger_, "search " << search << ": " << seconds << " s");
+    if (region_sizes != reference_sizes)
+    {
+      LOG4CXX_WARN(logger_, "Search backend " << search << " changed the regions found, skipping it");
+      continue;
+    }
+    if (seconds < best_seconds)
+    {
+      best_seconds = seconds;
+      profile.search = search;
+    }
+  }
+
+  LOG4CXX_INFO(logger_,
+               "Fastest settings, search: " << profile.search << ", opencv threads: " << profile.opencv_threads);
+  return true;
+}
+
+}  // namespace region_detection_core
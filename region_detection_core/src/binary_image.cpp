@@ -0,0 +1,512 @@
+/*
+ * @file binary_image.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+
+#include <opencv2/imgproc.hpp>
+
+#include "region_detection_core/binary_image.h"
+
+namespace
+{
+const int WORD_BITS = 64;
+
+// chain code directions, counterclockwise starting from the east neighbor
+const int DIR_DX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+const int DIR_DY[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+
+struct ElementSpan
+{
+  int dy;
+  int left;
+  int right;
+};
+
+bool getElementSpans(const cv::Mat& element, cv::Point anchor, std::vector<ElementSpan>& spans)
+{
+  if (element.empty() || element.type() != CV_8UC1)
+  {
+    return false;
+  }
+
+  if (anchor.x < 0 || anchor.y < 0)
+  {
+    anchor = cv::Point(element.cols / 2, element.rows / 2);
+  }
+
+  spans.clear();
+  for (int r = 0; r < element.rows; r++)
+  {
+    const uchar* row = element.ptr<uchar>(r);
+    const uchar* first = std::find_if(row, row + element.cols, [](uchar v) { return v != 0; });
+    if (first == row + element.cols)
+    {
+      continue;
+    }
+    const uchar* last = std::find_if(first, row + element.cols, [](uchar v) { return v == 0; });
+    if (std::find_if(last, row + element.cols, [](uchar v) { return v != 0; }) != row + element.cols)
+    {
+      return false;
+    }
+    spans.push_back(ElementSpan{ r - anchor.y, static_cast<int>(first - row) - anchor.x,
+                                 static_cast<int>(last - row) - 1 - anchor.x });
+  }
+  return true;
+}
+
+/**
+ * @brief out[x] = in[x + offset], bits outside the row are read as 0
+ */
+void gatherRow(const std::uint64_t* in, int words, int offset, std::uint64_t* out)
+{
+  int word_offset = offset >= 0 ? offset / WORD_BITS : -((-offset + WORD_BITS - 1) / WORD_BITS);
+  int bit_offset = offset - word_offset * WORD_BITS;
+  auto word_at = [in, words](int w) -> std::uint64_t { return (w >= 0 && w < words) ? in[w] : 0; };
+  for (int w = 0; w < words; w++)
+  {
+    int src = w + word_offset;
+    std::uint64_t v = word_at(src) >> bit_offset;
+    if (bit_offset > 0)
+    {
+      v |= word_at(src + 1) << (WORD_BITS - bit_offset);
+    }
+    out[w] = v;
+  }
+}
+
+/**
+ * @brief ORs the row gathered at every offset in [left, right], the span is covered by doubling so that a kernel of
+ * width n takes log2(n) shifts.  The accumulator has leading words for the bits that end up left of the row origin.
+ */
+void dilateRow(const std::uint64_t* in, int words, int left, int right, std::uint64_t* out,
+               std::vector<std::uint64_t>& acc, std::vector<std::uint64_t>& tmp)
+{
+  int margin = left < 0 ? (-left + WORD_BITS - 1) / WORD_BITS : 0;
+  int acc_words = words + margin;
+  acc.assign(acc_words, 0);
+  tmp.resize(acc_words);
+  std::copy(in, in + words, acc.begin() + margin);
+
+  int width = right - left + 1;
+  int covered = 1;
+  while (covered < width)
+  {
+    int step = std::min(covered, width - covered);
+    gatherRow(acc.data(), acc_words, step, tmp.data());
+    for (int w = 0; w < acc_words; w++)
+    {
+      acc[w] |= tmp[w];
+    }
+    covered += step;
+  }
+  gatherRow(acc.data(), acc_words, left + margin * WORD_BITS, tmp.data());
+  std::copy(tmp.begin(), tmp.begin() + words, out);
+}
+
+}  // namespace
+
+namespace region_detection_core
+{
+BinaryImage::BinaryImage() : rows_(0), cols_(0), words_per_row_(0), binary_(true), on_value_(255) {}
+
+BinaryImage::BinaryImage(int rows, int cols) : BinaryImage() { create(rows, cols); }
+
+void BinaryImage::create(int rows, int cols)
+{
+  rows_ = rows;
+  cols_ = cols;
+  words_per_row_ = (cols + WORD_BITS - 1) / WORD_BITS;
+  data_.assign(static_cast<std::size_t>(rows_) * words_per_row_, 0);
+}
+
+bool BinaryImage::pack(const cv::Mat& src, BinaryImage& dst)
+{
+  if (src.type() != CV_8UC1)
+  {
+    return false;
+  }
+
+  dst.create(src.rows, src.cols);
+  uchar on_value = 0;
+  bool binary = true;
+  for (int y = 0; y < src.rows; y++)
+  {
+    const uchar* pixels = src.ptr<uchar>(y);
+    std::uint64_t* row = dst.rowPtr(y);
+    for (int w = 0; w < dst.words_per_row_; w++)
+    {
+      const uchar* chunk = pixels + w * WORD_BITS;
+      int n = std::min(WORD_BITS, src.cols - w * WORD_BITS);
+      std::uint64_t word = 0;
+      for (int b = 0; b < n; b++)
+      {
+        word |= static_cast<std::uint64_t>(chunk[b] != 0) << b;
+      }
+
+      // checking the values only for the words that have set bits
+      if (word != 0)
+      {
+        for (int b = 0; b < n; b++)
+        {
+          if (chunk[b] != 0)
+          {
+            on_value = on_value == 0 ? chunk[b] : on_value;
+            binary = binary && chunk[b] == on_value;
+          }
+        }
+      }
+      row[w] = word;
+    }
+  }
+  dst.binary_ = binary;
+  dst.on_value_ = on_value == 0 ? 255 : on_value;
+  return true;
+}
+
+void BinaryImage::unpack(cv::Mat& dst) const
+{
+  dst.create(rows_, cols_, CV_8UC1);
+  for (int y = 0; y < rows_; y++)
+  {
+    const std::uint64_t* row = rowPtr(y);
+    uchar* pixels = dst.ptr<uchar>(y);
+    for (int x = 0; x < cols_; x++)
+    {
+      pixels[x] = ((row[x / WORD_BITS] >> (x % WORD_BITS)) & 1) ? on_value_ : 0;
+    }
+  }
+}
+
+bool BinaryImage::supportsElement(const cv::Mat& element)
+{
+  std::vector<ElementSpan> spans;
+  return getElementSpans(element, cv::Point(-1, -1), spans);
+}
+
+bool BinaryImage::supportsContours(int mode, int method)
+{
+  return (mode == CV_RETR_EXTERNAL || mode == CV_RETR_LIST) &&
+         (method == CV_CHAIN_APPROX_NONE || method == CV_CHAIN_APPROX_SIMPLE);
+}
+
+bool BinaryImage::empty() const { return data_.empty(); }
+
+int BinaryImage::rows() const { return rows_; }
+
+int BinaryImage::cols() const { return cols_; }
+
+bool BinaryImage::isBinary() const { return binary_; }
+
+bool BinaryImage::get(int x, int y) const
+{
+  if (x < 0 || y < 0 || x >= cols_ || y >= rows_)
+  {
+    return false;
+  }
+  return (rowPtr(y)[x / WORD_BITS] >> (x % WORD_BITS)) & 1;
+}
+
+bool BinaryImage::dilate(const cv::Mat& element, cv::Point anchor, BinaryImage& dst) const
+{
+  std::vector<ElementSpan> spans;
+  if (!getElementSpans(element, anchor, spans))
+  {
+    return false;
+  }
+
+  // each distinct horizontal span is applied once to every row, the rows are then ORed vertically
+  std::map<std::pair<int, int>, std::vector<std::uint64_t>> horizontal;
+  std::vector<std::uint64_t> acc, tmp;
+  for (const ElementSpan& span : spans)
+  {
+    std::vector<std::uint64_t>& h = horizontal[std::make_pair(span.left, span.right)];
+    if (!h.empty())
+    {
+      continue;
+    }
+    h.resize(data_.size());
+    for (int y = 0; y < rows_; y++)
+    {
+      dilateRow(rowPtr(y), words_per_row_, span.left, span.right, &h[y * words_per_row_], acc, tmp);
+    }
+  }
+
+  BinaryImage result(rows_, cols_);
+  for (const ElementSpan& span : spans)
+  {
+    const std::vector<std::uint64_t>& h = horizontal.at(std::make_pair(span.left, span.right));
+    for (int y = std::max(0, -span.dy); y < std::min(rows_, rows_ - span.dy); y++)
+    {
+      const std::uint64_t* src = &h[(y + span.dy) * words_per_row_];
+      std::uint64_t* out = result.rowPtr(y);
+      for (int w = 0; w < words_per_row_; w++)
+      {
+        out[w] |= src[w];
+      }
+    }
+  }
+  result.clearPadding();
+  result.binary_ = binary_;
+  result.on_value_ = on_value_;
+  std::swap(dst, result);
+  return true;
+}
+
+bool BinaryImage::erode(const cv::Mat& element, cv::Point anchor, BinaryImage& dst) const
+{
+  // erosion is the complement of the dilation of the complement, the outside becomes unset in the complement
+  BinaryImage inverted;
+  complement(inverted);
+  if (!inverted.dilate(element, anchor, inverted))
+  {
+    return false;
+  }
+  inverted.complement(dst);
+  return true;
+}
+
+bool BinaryImage::open(const cv::Mat& element, cv::Point anchor, BinaryImage& dst) const
+{
+  return erode(element, anchor, dst) && dst.dilate(element, anchor, dst);
+}
+
+bool BinaryImage::close(const cv::Mat& element, cv::Point anchor, BinaryImage& dst) const
+{
+  return dilate(element, anchor, dst) && dst.erode(element, anchor, dst);
+}
+
+bool BinaryImage::findContours(std::vector<std::vector<cv::Point>>& contours,
+                               std::vector<cv::Vec4i>& hierarchy,
+                               int mode,
+                               int method) const
+{
+  contours.clear();
+  hierarchy.clear();
+  if (!supportsContours(mode, method))
+  {
+    return false;
+  }
+
+  // pixels visited by the border following are flagged in a bitplane so that the scan can skip whole words, their
+  // signed border ids are kept in a label per pixel
+  std::vector<std::uint64_t> marked(data_.size(), 0);
+  std::vector<int> labels(static_cast<std::size_t>(rows_) * cols_, 1);
+  auto get_label = [&](int x, int y) -> int { return labels[static_cast<std::size_t>(y) * cols_ + x]; };
+  auto set_label = [&](int x, int y, int label) {
+    marked[y * words_per_row_ + x / WORD_BITS] |= std::uint64_t(1) << (x % WORD_BITS);
+    labels[static_cast<std::size_t>(y) * cols_ + x] = label;
+  };
+
+  // next pixel from x that starts an outer border, starts a hole border or was already visited
+  auto next_event = [&](int y, int x) -> int {
+    const std::uint64_t* row = rowPtr(y);
+    const std::uint64_t* marked_row = &marked[y * words_per_row_];
+    for (int w = x / WORD_BITS; w < words_per_row_; w++)
+    {
+      std::uint64_t cur = row[w];
+      std::uint64_t left = (cur << 1) | (w > 0 ? row[w - 1] >> (WORD_BITS - 1) : 0);
+      std::uint64_t right = (cur >> 1) | (w + 1 < words_per_row_ ? row[w + 1] << (WORD_BITS - 1) : 0);
+      std::uint64_t events = (cur & ~left) | (cur & ~right) | marked_row[w];
+      if (w == x / WORD_BITS)
+      {
+        events &= ~std::uint64_t(0) << (x % WORD_BITS);
+      }
+      if (events != 0)
+      {
+        return w * WORD_BITS + __builtin_ctzll(events);
+      }
+    }
+    return -1;
+  };
+
+  auto trace_border = [&](cv::Point p0, int start_dir, int nbd, std::vector<cv::Point>& points) {
+    points.push_back(p0);
+
+    // clockwise search for the first set neighbor
+    int dir1 = -1;
+    for (int k = 0; k < 8 && dir1 < 0; k++)
+    {
+      int d = (start_dir - k + 8) % 8;
+      dir1 = get(p0.x + DIR_DX[d], p0.y + DIR_DY[d]) ? d : -1;
+    }
+    if (dir1 < 0)
+    {
+      set_label(p0.x, p0.y, -nbd);
+      return;
+    }
+
+    cv::Point p1(p0.x + DIR_DX[dir1], p0.y + DIR_DY[dir1]);
+    cv::Point p3 = p0;
+    int prev_dir = dir1;
+    while (true)
+    {
+      // counterclockwise search starting after the previous pixel
+      bool east_is_unset = false;
+      int dir4 = prev_dir;
+      for (int k = 1; k <= 8; k++)
+      {
+        dir4 = (prev_dir + k) % 8;
+        if (get(p3.x + DIR_DX[dir4], p3.y + DIR_DY[dir4]))
+        {
+          break;
+        }
+        east_is_unset = east_is_unset || dir4 == 0;
+      }
+
+      if (east_is_unset)
+      {
+        set_label(p3.x, p3.y, -nbd);
+      }
+      else if (get_label(p3.x, p3.y) == 1)
+      {
+        set_label(p3.x, p3.y, nbd);
+      }
+
+      cv::Point p4(p3.x + DIR_DX[dir4], p3.y + DIR_DY[dir4]);
+      if (p4 == p0 && p3 == p1)
+      {
+        break;
+      }
+      points.push_back(p4);
+      prev_dir = (dir4 + 4) % 8;
+      p3 = p4;
+    }
+  };
+
+  auto approximate = [method](std::vector<cv::Point>& points) {
+    if (method != CV_CHAIN_APPROX_SIMPLE || points.size() < 3)
+    {
+      return;
+    }
+
+    // keeping only the points where the chain code changes
+    std::vector<cv::Point> corners;
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+      cv::Point in = points[i] - points[(i + points.size() - 1) % points.size()];
+      cv::Point out = points[(i + 1) % points.size()] - points[i];
+      if (in != out)
+      {
+        corners.push_back(points[i]);
+      }
+    }
+    points.swap(corners);
+  };
+
+  // the frame is border 1 and is considered a hole
+  struct Border
+  {
+    bool hole;
+    int parent;
+  };
+  std::vector<Border> borders = { Border{ true, 0 }, Border{ true, 0 } };
+  int nbd = 1;
+  for (int y = 0; y < rows_; y++)
+  {
+    int lnbd = 1;
+    for (int x = next_event(y, 0); x >= 0; x = x + 1 < cols_ ? next_event(y, x + 1) : -1)
+    {
+      int label = get_label(x, y);
+      bool outer = label == 1 && !get(x - 1, y);
+      bool hole = !outer && label >= 1 && !get(x + 1, y);
+      if (outer || hole)
+      {
+        nbd++;
+        if (hole && label > 1)
+        {
+          lnbd = label;
+        }
+
+        const Border& last = borders[lnbd];
+        Border border{ hole, last.hole == hole ? last.parent : lnbd };
+        borders.push_back(border);
+
+        std::vector<cv::Point> points;
+        trace_border(cv::Point(x, y), hole ? 0 : 4, nbd, points);
+        if (mode == CV_RETR_LIST || (!border.hole && border.parent == 1))
+        {
+          approximate(points);
+          contours.push_back(std::move(points));
+        }
+      }
+
+      label = get_label(x, y);
+      if (label != 1)
+      {
+        lnbd = std::abs(label);
+      }
+    }
+  }
+
+  // opencv lists the borders from the last one found
+  std::reverse(contours.begin(), contours.end());
+  for (int i = 0; i < static_cast<int>(contours.size()); i++)
+  {
+    hierarchy.push_back(cv::Vec4i(i + 1 < static_cast<int>(contours.size()) ? i + 1 : -1, i - 1, -1, -1));
+  }
+  return true;
+}
+
+void BinaryImage::complement(BinaryImage& dst) const
+{
+  BinaryImage result = *this;
+  for (std::uint64_t& word : result.data_)
+  {
+    word = ~word;
+  }
+  result.clearPadding();
+  std::swap(dst, result);
+}
+
+void BinaryImage::clearPadding()
+{
+  int used_bits = cols_ % WORD_BITS;
+  if (used_bits == 0)
+  {
+    return;
+  }
+  std::uint64_t mask = (std::uint64_t(1) << used_bits) - 1;
+  for (int y = 0; y < rows_; y++)
+  {
+    rowPtr(y)[words_per_row_ - 1] &= mask;
+  }
+}
+
+const std::uint64_t* BinaryImage::rowPtr(int y) const { return &data_[static_cast<std::size_t>(y) * words_per_row_]; }
+
+std::uint64_t* BinaryImage::rowPtr(int y) { return &data_[static_cast<std::size_t>(y) * words_per_row_]; }
+
+} /* namespace region_detection_core */
@@ -0,0 +1,147 @@
+/*
+ * @file chain_contour.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits>
+
+#include "region_detection_core/chain_contour.h"
+
+namespace region_detection_core
+{
+const std::uint8_t ChainContour::NUM_DIRECTIONS;
+const std::uint8_t ChainContour::ESCAPE_16;
+const std::uint8_t ChainContour::ESCAPE_32;
+const cv::Point ChainContour::DIRECTIONS[ChainContour::NUM_DIRECTIONS] = {
+  cv::Point(1, 0),  cv::Point(1, -1), cv::Point(0, -1), cv::Point(-1, -1),
+  cv::Point(-1, 0), cv::Point(-1, 1), cv::Point(0, 1),  cv::Point(1, 1)
+};
+
+/**
+ * @brief chain code of a step to an 8-connected neighbor, 8 for any other step including a repeated point
+ */
+static std::uint8_t directionCode(const cv::Point& step)
+{
+  // indexed by (dy + 1) * 3 + (dx + 1)
+  static const std::uint8_t CODES[9] = { 3, 2, 1, 4, 8, 0, 5, 6, 7 };
+  if (step.x < -1 || step.x > 1 || step.y < -1 || step.y > 1)
+  {
+    return 8;
+  }
+  return CODES[(step.y + 1) * 3 + (step.x + 1)];
+}
+
+ChainContour::ChainContour() : size_(0) {}
+
+ChainContour::ChainContour(const std::vector<cv::Point>& points) : size_(0)
+{
+  codes_.reserve(points.size());
+  for (const cv::Point& p : points)
+  {
+    push_back(p);
+  }
+}
+
+void ChainContour::push_back(const cv::Point& p)
+{
+  if (size_ == 0)
+  {
+    front_ = p;
+    back_ = p;
+    size_ = 1;
+    return;
+  }
+
+  cv::Point step = p - back_;
+  std::uint8_t code = directionCode(step);
+  if (code < NUM_DIRECTIONS)
+  {
+    codes_.push_back(code);
+  }
+  else if (step.x >= std::numeric_limits<std::int16_t>::min() && step.x <= std::numeric_limits<std::int16_t>::max() &&
+           step.y >= std::numeric_limits<std::int16_t>::min() && step.y <= std::numeric_limits<std::int16_t>::max())
+  {
+    std::int16_t delta[2] = { static_cast<std::int16_t>(step.x), static_cast<std::int16_t>(step.y) };
+    codes_.push_back(ESCAPE_16);
+    codes_.insert(codes_.end(),
+                  reinterpret_cast<const std::uint8_t*>(delta),
+                  reinterpret_cast<const std::uint8_t*>(delta) + sizeof(delta));
+  }
+  else
+  {
+    std::int32_t delta[2] = { step.x, step.y };
+    codes_.push_back(ESCAPE_32);
+    codes_.insert(codes_.end(),
+                  reinterpret_cast<const std::uint8_t*>(delta),
+                  reinterpret_cast<const std::uint8_t*>(delta) + sizeof(delta));
+  }
+  back_ = p;
+  size_++;
+}
+
+void ChainContour::clear()
+{
+  codes_.clear();
+  size_ = 0;
+}
+
+bool ChainContour::empty() const { return size_ == 0; }
+
+std::size_t ChainContour::size() const { return size_; }
+
+std::size_t ChainContour::byteSize() const { return codes_.size(); }
+
+cv::Point ChainContour::front() const { return front_; }
+
+cv::Point ChainContour::back() const { return back_; }
+
+std::vector<cv::Point> ChainContour::toPoints() const
+{
+  std::vector<cv::Point> points;
+  points.reserve(size_);
+  Decoder decoder(*this);
+  cv::Point p;
+  while (decoder.next(p))
+  {
+    points.push_back(p);
+  }
+  return points;
+}
+
+bool ChainContour::operator==(const ChainContour& other) const
+{
+  return size_ == other.size_ && (size_ == 0 || front_ == other.front_) && codes_ == other.codes_;
+}
+
+bool ChainContour::operator!=(const ChainContour& other) const { return !(*this == other); }
+
+}  // namespace region_detection_core
@@ -0,0 +1,240 @@
+/*
+ * @file cloud_planes.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "region_detection_core/cloud_planes.h"
+
+/**
+ * @brief sums of the points near a center, relative to it
+ */
+struct SpanSums
+{
+  double n = 0.0;
+  double x = 0.0;
+  double y = 0.0;
+  double z = 0.0;
+  double xx = 0.0;
+  double xy = 0.0;
+  double xz = 0.0;
+  double yy = 0.0;
+  double yz = 0.0;
+  double zz = 0.0;
+};
+
+/**
+ * @brief adds the points of a row span within max_dist_sqr of the center.  The invalid points fail the distance test
+ * since any comparison with nan or infinity is false, so the validity bits are not needed.  The loop only becomes
+ * vectorized with OpenMP's simd reduction and without trapping math, see CMakeLists.txt
+ */
+static void accumulateSpan(const float* px,
+                           const float* py,
+                           const float* pz,
+                           int count,
+                           const Eigen::Vector3f& center,
+                           float max_dist_sqr,
+                           SpanSums& sums)
+{
+  const float cx = center.x(), cy = center.y(), cz = center.z();
+  float n = 0.0f, x = 0.0f, y = 0.0f, z = 0.0f, xx = 0.0f, xy = 0.0f, xz = 0.0f, yy = 0.0f, yz = 0.0f, zz = 0.0f;
+#pragma omp simd reduction(+ : n, x, y, z, xx, xy, xz, yy, yz, zz)
+  for (int i = 0; i < count; i++)
+  {
+    float dx = px[i] - cx, dy = py[i] - cy, dz = pz[i] - cz;
+    bool inside = dx * dx + dy * dy + dz * dz <= max_dist_sqr;
+    dx = inside ? dx : 0.0f;
+    dy = inside ? dy : 0.0f;
+    dz = inside ? dz : 0.0f;
+    n += inside ? 1.0f : 0.0f;
+    x += dx;
+    y += dy;
+    z += dz;
+    xx += dx * dx;
+    xy += dx * dy;
+    xz += dx * dz;
+    yy += dy * dy;
+    yz += dy * dz;
+    zz += dz * dz;
+  }
+  sums.n += n;
+  sums.x += x;
+  sums.y += y;
+  sums.z += z;
+  sums.xx += xx;
+  sums.xy += xy;
+  sums.xz += xz;
+  sums.yy += yy;
+  sums.yz += yz;
+  sums.zz += zz;
+}
+
+namespace region_detection_core
+{
+CloudPlanes::CloudPlanes() : width_(0), height_(0) {}
+
+bool CloudPlanes::build(const pcl::PCLPointCloud2& cloud)
+{
+  if (cloud.data.size() < static_cast<std::size_t>(cloud.row_step) * cloud.height)
+  {
+    return false;
+  }
+
+  // offsets of the coordinates inside each point
+  int offsets[3] = { -1, -1, -1 };
+  const char* names[3] = { "x", "y", "z" };
+  for (const pcl::PCLPointField& field : cloud.fields)
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      if (field.name == names[i] && field.datatype == pcl::PCLPointField::FLOAT32 &&
+          field.offset + sizeof(float) <= cloud.point_step)
+      {
+        offsets[i] = field.offset;
+      }
+    }
+  }
+  if (std::any_of(offsets, offsets + 3, [](int offset) { return offset < 0; }))
+  {
+    return false;
+  }
+
+  width_ = cloud.width;
+  height_ = cloud.height;
+  std::size_t num_points = static_cast<std::size_t>(width_) * height_;
+  x_.resize(num_points);
+  y_.resize(num_points);
+  z_.resize(num_points);
+  std::vector<float>* planes[3] = { &x_, &y_, &z_ };
+  for (int row = 0; row < height_; row++)
+  {
+    const std::uint8_t* src = &cloud.data[static_cast<std::size_t>(row) * cloud.row_step];
+    std::size_t dst = static_cast<std::size_t>(row) * width_;
+    for (int col = 0; col < width_; col++, src += cloud.point_step, dst++)
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        std::memcpy(&(*planes[i])[dst], src + offsets[i], sizeof(float));
+      }
+    }
+  }
+  updateValid();
+  return true;
+}
+
+void CloudPlanes::transform(const Eigen::Isometry3d& transform)
+{
+  const Eigen::Matrix3f r = transform.linear().cast<float>();
+  const Eigen::Vector3f t = transform.translation().cast<float>();
+  float* x = x_.data();
+  float* y = y_.data();
+  float* z = z_.data();
+  const std::size_t num_points = size();
+  for (std::size_t i = 0; i < num_points; i++)
+  {
+    float px = x[i], py = y[i], pz = z[i];
+    x[i] = r(0, 0) * px + r(0, 1) * py + r(0, 2) * pz + t(0);
+    y[i] = r(1, 0) * px + r(1, 1) * py + r(1, 2) * pz + t(1);
+    z[i] = r(2, 0) * px + r(2, 1) * py + r(2, 2) * pz + t(2);
+  }
+
+  // overflowing points become invalid
+  updateValid();
+}
+
+void CloudPlanes::updateValid()
+{
+  const std::size_t num_points = size();
+  valid_.assign((num_points + 63) / 64, 0);
+  for (std::size_t block = 0; block < valid_.size(); block++)
+  {
+    std::size_t begin = block * 64, end = std::min(num_points, begin + 64);
+    std::uint64_t bits = 0;
+    for (std::size_t i = begin; i < end; i++)
+    {
+      // v - v is 0 only for finite values
+      bool finite = (x_[i] - x_[i]) == 0.0f && (y_[i] - y_[i]) == 0.0f && (z_[i] - z_[i]) == 0.0f;
+      bits |= static_cast<std::uint64_t>(finite) << (i - begin);
+    }
+    valid_[block] = bits;
+  }
+}
+
+std::size_t CloudPlanes::countValid() const
+{
+  std::size_t count = 0;
+  for (std::uint64_t bits : valid_)
+  {
+    for (; bits; bits &= bits - 1)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+CloudPlanes::Moments
+CloudPlanes::windowMoments(int x, int y, int half_size, const Eigen::Vector3f& center, float max_dist) const
+{
+  int x0 = std::max(0, x - half_size), x1 = std::min(width_ - 1, x + half_size);
+  int y0 = std::max(0, y - half_size), y1 = std::min(height_ - 1, y + half_size);
+  SpanSums sums;
+  for (int row = y0; row <= y1; row++)
+  {
+    const std::size_t offset = static_cast<std::size_t>(row) * width_ + x0;
+    accumulateSpan(&x_[offset], &y_[offset], &z_[offset], x1 - x0 + 1, center, max_dist * max_dist, sums);
+  }
+
+  Moments moments;
+  moments.count = static_cast<int>(sums.n);
+  moments.sum << sums.x, sums.y, sums.z;
+  moments.sum_sqr << sums.xx, sums.xy, sums.xz, sums.xy, sums.yy, sums.yz, sums.xz, sums.yz, sums.zz;
+  return moments;
+}
+
+void CloudPlanes::toPointCloud(pcl::PointCloud<pcl::PointXYZ>& cloud) const
+{
+  cloud.width = width_;
+  cloud.height = height_;
+  cloud.points.resize(size());
+  for (std::size_t i = 0; i < size(); i++)
+  {
+    cloud.points[i].x = x_[i];
+    cloud.points[i].y = y_[i];
+    cloud.points[i].z = z_[i];
+  }
+  cloud.is_dense = countValid() == size();
+}
+
+}  // namespace region_detection_core
@@ -0,0 +1,299 @@
+/*
+ * @file executor.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <opencv2/core.hpp>
+
+#include <boost/format.hpp>
+
+#include "region_detection_core/executor.h"
+
+static thread_local bool IS_WORKER_THREAD = false;
+
+namespace region_detection_core
+{
+Executor::StageGuard::~StageGuard()
+{
+  if (!slots_)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(slots_->mutex);
+    slots_->available++;
+  }
+  slots_->cv.notify_one();
+}
+
+Executor::Executor(const config_exec::ExecutorCfg& config, log4cxx::LoggerPtr logger)
+  : logger_(logger ? logger : log4cxx::Logger::getLogger("Executor")), config_(config), stop_(false)
+{
+  std::string err_msg;
+  if (!validate(config_, err_msg))
+  {
+    throw std::runtime_error(err_msg);
+  }
+
+  // the cpu budget is either the configured affinity mask or the cpus available to the process
+  int available_cpus = config_.cpu_affinity.empty() ? static_cast<int>(getAvailableCpus().size()) :
+                                                       static_cast<int>(config_.cpu_affinity.size());
+  available_cpus = std::max(1, available_cpus);
+  int num_threads = config_.num_threads > 0 ? config_.num_threads : available_cpus;
+
+  // threads left to each worker for the parallel regions inside opencv and pcl
+  int threads_per_worker = std::max(1, available_cpus / num_threads);
+  opencv_threads_ = config_.opencv_threads >= 0 ? config_.opencv_threads : threads_per_worker;
+  openmp_threads_ = config_.openmp_threads > 0 ? config_.openmp_threads : threads_per_worker;
+
+  // opencv keeps a single process wide pool
+  cv::setNumThreads(opencv_threads_);
+
+  for (const auto& kv : config_.stage_limits)
+  {
+    std::unique_ptr<StageSlots> slots(new StageSlots());
+    slots->available = kv.second;
+    stage_slots_[kv.first] = std::move(slots);
+  }
+
+  workers_.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++)
+  {
+    workers_.emplace_back(&Executor::workerLoop, this);
+  }
+
+  LOG4CXX_DEBUG(logger_,
+                "Executor started " << num_threads << " workers over " << available_cpus << " cpus, opencv threads: "
+                                    << opencv_threads_ << ", openmp threads: " << openmp_threads_);
+}
+
+Executor::~Executor()
+{
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  for (std::thread& worker : workers_)
+  {
+    worker.join();
+  }
+}
+
+bool Executor::validate(const config_exec::ExecutorCfg& config, std::string& err_msg)
+{
+  if (config.num_threads < 0)
+  {
+    err_msg = boost::str(boost::format("Invalid number of executor threads %i") % config.num_threads);
+    return false;
+  }
+
+  if (config.opencv_threads < -1 || config.openmp_threads < -1 || config.openmp_threads == 0)
+  {
+    err_msg = boost::str(boost::format("Invalid library thread counts, opencv: %i, openmp: %i") %
+                         config.opencv_threads % config.openmp_threads);
+    return false;
+  }
+
+  const std::vector<int> available_cpus = getAvailableCpus();
+  for (int cpu : config.cpu_affinity)
+  {
+    if (std::find(available_cpus.begin(), available_cpus.end(), cpu) == available_cpus.end())
+    {
+      err_msg = boost::str(boost::format("Cpu %i in the affinity mask is not available to this process") % cpu);
+      return false;
+    }
+  }
+
+  for (const auto& kv : config.stage_limits)
+  {
+    if (kv.second <= 0)
+    {
+      err_msg = boost::str(boost::format("Stage %s concurrency limit must be greater than 0") % kv.first);
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<int> Executor::getAvailableCpus()
+{
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+  {
+    cpus.reserve(CPU_COUNT(&mask));
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+      if (CPU_ISSET(cpu, &mask))
+      {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+
+  // elsewhere every cpu of the machine is assumed to be available
+  if (cpus.empty())
+  {
+    const int num_cpus = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int cpu = 0; cpu < num_cpus; cpu++)
+    {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+bool Executor::isWorkerThread() { return IS_WORKER_THREAD; }
+
+std::size_t Executor::getNumThreads() const { return workers_.size(); }
+
+int Executor::getOpenCVThreads() const { return opencv_threads_; }
+
+int Executor::getOpenMPThreads() const { return openmp_threads_; }
+
+void Executor::runAll(const std::vector<std::function<void()>>& tasks)
+{
+  std::vector<std::future<void>> futures;
+  futures.reserve(tasks.size());
+  for (const std::function<void()>& task : tasks)
+  {
+    futures.push_back(submit(task));
+  }
+
+  // waiting on all of them before rethrowing since the tasks may reference the caller's stack
+  std::exception_ptr first_error = nullptr;
+  for (std::future<void>& f : futures)
+  {
+    try
+    {
+      f.get();
+    }
+    catch (...)
+    {
+      if (!first_error)
+      {
+        first_error = std::current_exception();
+      }
+    }
+  }
+
+  if (first_error)
+  {
+    std::rethrow_exception(first_error);
+  }
+}
+
+Executor::StageGuard Executor::acquireStage(const std::string& stage)
+{
+  auto it = stage_slots_.find(stage);
+  if (it == stage_slots_.end())
+  {
+    return StageGuard();
+  }
+
+  StageSlots* slots = it->second.get();
+  std::unique_lock<std::mutex> lock(slots->mutex);
+  slots->cv.wait(lock, [slots]() { return slots->available > 0; });
+  slots->available--;
+  return StageGuard(slots);
+}
+
+void Executor::applyThreadSettings()
+{
+#ifdef __linux__
+  if (!config_.cpu_affinity.empty())
+  {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : config_.cpu_affinity)
+    {
+      CPU_SET(cpu, &cpu_set);
+    }
+
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+    if (err != 0)
+    {
+      LOG4CXX_WARN(logger_, "Failed to set the affinity of an executor thread, error code " << err);
+    }
+  }
+#else
+  if (!config_.cpu_affinity.empty())
+  {
+    LOG4CXX_WARN(logger_, "Cpu affinity is only supported on linux, ignoring");
+  }
+#endif
+
+#ifdef _OPENMP
+  // the openmp thread count is a per thread setting
+  omp_set_num_threads(openmp_threads_);
+#endif
+}
+
+void Executor::workerLoop()
+{
+  IS_WORKER_THREAD = true;
+  applyThreadSettings();
+
+  while (true)
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_ && queue_.empty())
+      {
+        return;
+      }
+      task = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    task();
+  }
+}
+
+} /* namespace region_detection_core */
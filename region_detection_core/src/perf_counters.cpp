@@ -0,0 +1,148 @@
+/*
+ * @file perf_counters.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "region_detection_core/perf_counters.h"
+
+namespace region_detection_core
+{
+#ifdef __linux__
+static const std::vector<std::pair<std::string, std::uint64_t>> HARDWARE_EVENTS = {
+  { "cycles", PERF_COUNT_HW_CPU_CYCLES },
+  { "instructions", PERF_COUNT_HW_INSTRUCTIONS },
+  { "cache_misses", PERF_COUNT_HW_CACHE_MISSES },
+  { "branch_misses", PERF_COUNT_HW_BRANCH_MISSES }
+};
+
+/**
+ * @brief opens a hardware event of the calling thread on any cpu, the first one opened leads the group
+ */
+static int openEvent(std::uint64_t config, int group_fd)
+{
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.disabled = group_fd < 0 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+#endif
+
+PerfCounters::PerfCounters(bool enable)
+{
+#ifdef __linux__
+  if (!enable)
+  {
+    return;
+  }
+
+  for (const auto& event : HARDWARE_EVENTS)
+  {
+    int fd = openEvent(event.second, group_fd_);
+    if (fd < 0)
+    {
+      continue;
+    }
+    if (group_fd_ < 0)
+    {
+      group_fd_ = fd;
+    }
+    events_.emplace_back(event.first, fd);
+  }
+#else
+  (void)enable;
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  for (const auto& event : events_)
+  {
+    close(event.second);
+  }
+#endif
+}
+
+bool PerfCounters::isOpen() const { return group_fd_ >= 0; }
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+  if (isOpen())
+  {
+    ioctl(group_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+}
+
+PerfCounters::Counts PerfCounters::stop()
+{
+  Counts counts;
+#ifdef __linux__
+  if (!isOpen())
+  {
+    return counts;
+  }
+  ioctl(group_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  // the group is read as the number of events followed by their values in the order they were opened
+  std::vector<std::uint64_t> values(events_.size() + 1, 0);
+  ssize_t bytes = read(group_fd_, values.data(), values.size() * sizeof(std::uint64_t));
+  if (bytes < static_cast<ssize_t>(sizeof(std::uint64_t)) || values[0] != events_.size())
+  {
+    return counts;
+  }
+  for (std::size_t i = 0; i < events_.size(); i++)
+  {
+    counts[events_[i].first] = values[i + 1];
+  }
+#endif
+  return counts;
+}
+
+}  // namespace region_detection_core
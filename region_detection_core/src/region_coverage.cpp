@@ -0,0 +1,158 @@
+/*
+ * @file region_coverage.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <opencv2/imgproc.hpp>
+
+#include <Eigen/Eigenvalues>
+
+#include "region_detection_core/region_coverage.h"
+
+namespace region_detection_core
+{
+bool fitCurvePlane(const pcl::PointCloud<pcl::PointXYZ>& curve, Eigen::Vector3d& centroid, Eigen::Matrix3d& axes)
+{
+  if (curve.size() < 3)
+  {
+    return false;
+  }
+
+  Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+  for (const pcl::PointXYZ& p : curve)
+  {
+    sum += Eigen::Vector3d(p.x, p.y, p.z);
+  }
+  centroid = sum / curve.size();
+  Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+  for (const pcl::PointXYZ& p : curve)
+  {
+    Eigen::Vector3d d = Eigen::Vector3d(p.x, p.y, p.z) - centroid;
+    covariance += d * d.transpose();
+  }
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver;
+  solver.computeDirect(covariance);
+  axes = solver.eigenvectors();
+  return true;
+}
+
+void RegionCoverage::addRegion(const pcl::PointCloud<pcl::PointXYZ>& closed_curve)
+{
+  // plane of the curve
+  Eigen::Vector3d centroid;
+  Eigen::Matrix3d axes;
+  if (!fitCurvePlane(closed_curve, centroid, axes))
+  {
+    return;
+  }
+
+  Region region;
+  region.centroid = centroid.cast<float>();
+  region.normal = axes.col(0).cast<float>();
+  region.u = axes.col(2).cast<float>();
+  region.v = region.normal.cross(region.u);
+
+  // outline on the plane
+  region.outline.reserve(closed_curve.size());
+  region.lower = cv::Point2f(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+  region.upper = cv::Point2f(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+  for (const pcl::PointXYZ& p : closed_curve)
+  {
+    Eigen::Vector3f d = Eigen::Vector3f(p.x, p.y, p.z) - region.centroid;
+    cv::Point2f q(d.dot(region.u), d.dot(region.v));
+    region.outline.push_back(q);
+    region.lower = cv::Point2f(std::min(region.lower.x, q.x), std::min(region.lower.y, q.y));
+    region.upper = cv::Point2f(std::max(region.upper.x, q.x), std::max(region.upper.y, q.y));
+  }
+  regions_.push_back(std::move(region));
+}
+
+cv::Mat RegionCoverage::mask(const CloudPlanes& planes, double max_plane_dist, int margin) const
+{
+  if (regions_.empty() || planes.height() <= 1)
+  {
+    return cv::Mat();
+  }
+
+  cv::Mat covered = cv::Mat::zeros(planes.height(), planes.width(), CV_8UC1);
+  const float max_dist = static_cast<float>(max_plane_dist);
+  bool any_covered = false;
+  std::size_t i = 0;
+  for (int row = 0; row < planes.height(); row++)
+  {
+    std::uint8_t* covered_row = covered.ptr<std::uint8_t>(row);
+    for (int col = 0; col < planes.width(); col++, i++)
+    {
+      if (!planes.isValid(i))
+      {
+        continue;
+      }
+
+      const Eigen::Vector3f p(planes.x()[i], planes.y()[i], planes.z()[i]);
+      for (const Region& region : regions_)
+      {
+        Eigen::Vector3f d = p - region.centroid;
+        if (std::abs(d.dot(region.normal)) > max_dist)
+        {
+          continue;
+        }
+        cv::Point2f q(d.dot(region.u), d.dot(region.v));
+        if (q.x < region.lower.x || q.y < region.lower.y || q.x > region.upper.x || q.y > region.upper.y)
+        {
+          continue;
+        }
+        if (cv::pointPolygonTest(region.outline, q, false) >= 0)
+        {
+          covered_row[col] = 255;
+          any_covered = true;
+          break;
+        }
+      }
+    }
+  }
+
+  if (!any_covered)
+  {
+    return cv::Mat();
+  }
+  if (margin > 0)
+  {
+    cv::dilate(covered, covered, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * margin + 1, 2 * margin + 1)));
+  }
+  return covered;
+}
+
+}  // namespace region_detection_core
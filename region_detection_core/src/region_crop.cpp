@@ -56,12 +56,47 @@ static const double EPSILON = 1e-8;
 
 typedef std::vector<Eigen::Isometry3d, Eigen::aligned_allocator<Eigen::Isometry3d>> EigenPose3dVector_HIDDEN;
 
-pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromNormals(EigenPose3dVector_HIDDEN region_3d)
+pcl::PointCloud<pcl::PointXYZ>::Ptr convertPosesToCloud(const EigenPose3dVector_HIDDEN& region_3d)
 {
   using namespace pcl;
-  using namespace Eigen;
+  PointCloud<PointXYZ>::Ptr region_cloud_3d = boost::make_shared<PointCloud<PointXYZ>>();
+  std::transform(
+      region_3d.begin(), region_3d.end(), std::back_inserter(*region_cloud_3d), [](const Eigen::Isometry3d& pose) {
+        PointXYZ p;
+        p.getArray3fMap() = pose.translation().array().cast<float>();
+        return p;
+      });
+  return region_cloud_3d;
+}
 
+pcl::ModelCoefficients::Ptr createPlaneCoefficients(const Eigen::Vector3d& normal_vec, double d)
+{
+  pcl::ModelCoefficients::Ptr coefficients = boost::make_shared<pcl::ModelCoefficients>();
+  coefficients->values.resize(4);
+  coefficients->values[0] = normal_vec(0);
+  coefficients->values[1] = normal_vec(1);
+  coefficients->values[2] = normal_vec(2);
+  coefficients->values[3] = d;
+  return coefficients;
+}
+
+pcl::PointCloud<pcl::PointXYZ>::Ptr projectOntoPlane(const pcl::PointCloud<pcl::PointXYZ>::Ptr& region_cloud_3d,
+                                                     const pcl::ModelCoefficients::Ptr& coefficients)
+{
+  using namespace pcl;
   PointCloud<PointXYZ>::Ptr planar_hull = boost::make_shared<PointCloud<PointXYZ>>();
+  pcl::ProjectInliers<PointXYZ> project_inliers;
+  project_inliers.setModelType(pcl::SACMODEL_NORMAL_PLANE);
+  project_inliers.setInputCloud(region_cloud_3d);
+  project_inliers.setModelCoefficients(coefficients);
+  project_inliers.filter(*planar_hull);
+  return planar_hull;
+}
+
+pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromNormals(EigenPose3dVector_HIDDEN region_3d)
+{
+  using namespace pcl;
+  using namespace Eigen;
 
   // compute plane normal from averages
   pcl::Normal plane_normal;
@@ -91,30 +126,9 @@ pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromNormals(EigenPose3dVect
 
   // defining plane
   double d = -centroid.dot(normal_vec);
-  pcl::ModelCoefficients::Ptr coefficients = boost::make_shared<pcl::ModelCoefficients>();
-  coefficients->values.resize(4);
-  coefficients->values[0] = normal_vec(0);
-  coefficients->values[1] = normal_vec(1);
-  coefficients->values[2] = normal_vec(2);
-  coefficients->values[3] = d;
-
-  // converting to point cloud
-  PointCloud<PointXYZ>::Ptr region_cloud_3d = boost::make_shared<PointCloud<PointXYZ>>();
-  std::transform(
-      region_3d.begin(), region_3d.end(), std::back_inserter(*region_cloud_3d), [](const Eigen::Isometry3d& pose) {
-        PointXYZ p;
-        p.getArray3fMap() = pose.translation().array().cast<float>();
-        return p;
-      });
 
   // projecting onto plane
-  pcl::ProjectInliers<PointXYZ> project_inliers;
-  project_inliers.setModelType(pcl::SACMODEL_NORMAL_PLANE);
-  project_inliers.setInputCloud(region_cloud_3d);
-  project_inliers.setModelCoefficients(coefficients);
-  project_inliers.filter(*planar_hull);
-
-  return planar_hull;
+  return projectOntoPlane(convertPosesToCloud(region_3d), createPlaneCoefficients(normal_vec, d));
 }
 
 pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromPlane(const EigenPose3dVector_HIDDEN& region_3d)
@@ -122,16 +136,7 @@ pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromPlane(const EigenPose3d
   using namespace pcl;
   using namespace Eigen;
 
-  PointCloud<PointXYZ>::Ptr planar_hull = boost::make_shared<PointCloud<PointXYZ>>();
-
-  // converting to point cloud
-  PointCloud<PointXYZ>::Ptr region_cloud_3d = boost::make_shared<PointCloud<PointXYZ>>();
-  std::transform(
-      region_3d.begin(), region_3d.end(), std::back_inserter(*region_cloud_3d), [](const Eigen::Isometry3d& pose) {
-        PointXYZ p;
-        p.getArray3fMap() = pose.translation().array().cast<float>();
-        return p;
-      });
+  PointCloud<PointXYZ>::Ptr region_cloud_3d = convertPosesToCloud(region_3d);
 
   // computing moi
   PointXYZ min_point, max_point, center_point;
@@ -158,13 +163,7 @@ pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromPlane(const EigenPose3d
   seg.segment(indices, *coefficients);
 
   // projecting onto plane
-  pcl::ProjectInliers<PointXYZ> project_inliers;
-  project_inliers.setModelType(pcl::SACMODEL_NORMAL_PLANE);
-  project_inliers.setInputCloud(region_cloud_3d);
-  project_inliers.setModelCoefficients(coefficients);
-  project_inliers.filter(*planar_hull);
-
-  return planar_hull;
+  return projectOntoPlane(region_cloud_3d, coefficients);
 }
 
 pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromZVector(const EigenPose3dVector_HIDDEN& region_3d)
@@ -172,16 +171,7 @@ pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromZVector(const EigenPose
   using namespace pcl;
   using namespace Eigen;
 
-  PointCloud<PointXYZ>::Ptr planar_hull = boost::make_shared<PointCloud<PointXYZ>>();
-
-  // converting to point cloud
-  PointCloud<PointXYZ>::Ptr region_cloud_3d = boost::make_shared<PointCloud<PointXYZ>>();
-  std::transform(
-      region_3d.begin(), region_3d.end(), std::back_inserter(*region_cloud_3d), [](const Eigen::Isometry3d& pose) {
-        PointXYZ p;
-        p.getArray3fMap() = pose.translation().array().cast<float>();
-        return p;
-      });
+  PointCloud<PointXYZ>::Ptr region_cloud_3d = convertPosesToCloud(region_3d);
 
   // computing moi
   Eigen::Vector3f center, x_axis, y_axis, z_axis;
@@ -194,21 +184,9 @@ pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromZVector(const EigenPose
   // defining plane
   Vector3f normal_vec = z_axis.normalized();
   double d = -center.dot(normal_vec);
-  pcl::ModelCoefficients::Ptr coefficients = boost::make_shared<pcl::ModelCoefficients>();
-  coefficients->values.resize(4);
-  coefficients->values[0] = normal_vec(0);
-  coefficients->values[1] = normal_vec(1);
-  coefficients->values[2] = normal_vec(2);
-  coefficients->values[3] = d;
 
   // projecting onto plane
-  pcl::ProjectInliers<PointXYZ> project_inliers;
-  project_inliers.setModelType(pcl::SACMODEL_NORMAL_PLANE);
-  project_inliers.setInputCloud(region_cloud_3d);
-  project_inliers.setModelCoefficients(coefficients);
-  project_inliers.filter(*planar_hull);
-
-  return planar_hull;
+  return projectOntoPlane(region_cloud_3d, createPlaneCoefficients(normal_vec.cast<double>(), d));
 }
 
 pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromUserVector(const EigenPose3dVector_HIDDEN& region_3d,
@@ -217,16 +195,7 @@ pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromUserVector(const EigenP
   using namespace pcl;
   using namespace Eigen;
 
-  PointCloud<PointXYZ>::Ptr planar_hull = boost::make_shared<PointCloud<PointXYZ>>();
-
-  // converting to point cloud
-  PointCloud<PointXYZ>::Ptr region_cloud_3d = boost::make_shared<PointCloud<PointXYZ>>();
-  std::transform(
-      region_3d.begin(), region_3d.end(), std::back_inserter(*region_cloud_3d), [](const Eigen::Isometry3d& pose) {
-        PointXYZ p;
-        p.getArray3fMap() = pose.translation().array().cast<float>();
-        return p;
-      });
+  PointCloud<PointXYZ>::Ptr region_cloud_3d = convertPosesToCloud(region_3d);
 
   // computing moi
   Eigen::Vector3f center;
@@ -238,21 +207,15 @@ pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromUserVector(const EigenP
   // defining plane
   Vector3f normal_vec = user_vec.normalized().cast<float>();
   double d = -center.dot(normal_vec);
-  pcl::ModelCoefficients::Ptr coefficients = boost::make_shared<pcl::ModelCoefficients>();
-  coefficients->values.resize(4);
-  coefficients->values[0] = normal_vec(0);
-  coefficients->values[1] = normal_vec(1);
-  coefficients->values[2] = normal_vec(2);
-  coefficients->values[3] = d;
 
   // projecting onto plane
-  pcl::ProjectInliers<PointXYZ> project_inliers;
-  project_inliers.setModelType(pcl::SACMODEL_NORMAL_PLANE);
-  project_inliers.setInputCloud(region_cloud_3d);
-  project_inliers.setModelCoefficients(coefficients);
-  project_inliers.filter(*planar_hull);
+  return projectOntoPlane(region_cloud_3d, createPlaneCoefficients(normal_vec.cast<double>(), d));
+}
 
-  return planar_hull;
+pcl::PointCloud<pcl::PointXYZ>::Ptr computePlanarHullFromGivenPlane(const EigenPose3dVector_HIDDEN& region_3d,
+                                                                   const Eigen::Hyperplane<double, 3>& plane)
+{
+  return projectOntoPlane(convertPosesToCloud(region_3d), createPlaneCoefficients(plane.normal(), plane.offset()));
 }
 
 template <typename PointT>
@@ -281,7 +244,7 @@ void scaleCloud(const double scale_factor, typename pcl::PointCloud<PointT>& clo
 namespace region_detection_core
 {
 template <typename PointT>
-RegionCrop<PointT>::RegionCrop() : input_(nullptr)
+RegionCrop<PointT>::RegionCrop() : use_plane_(false), input_(nullptr)
 {
 }
 
@@ -304,6 +267,21 @@ inline void RegionCrop<PointT>::setRegion(const EigenPose3dVector_HIDDEN& closed
     throw std::runtime_error("region end points are too far from each other, region isn't closed");
   }
   closed_region_ = closed_region;
+  use_plane_ = false;
+}
+
+template <typename PointT>
+inline void RegionCrop<PointT>::setRegion(const EigenPose3dVector_HIDDEN& closed_region,
+                                          const Eigen::Hyperplane<double, 3>& plane)
+{
+  setRegion(closed_region);
+  if (plane.normal().norm() < EPSILON)
+  {
+    throw std::runtime_error("region plane has no normal");
+  }
+  plane_ = plane;
+  plane_.normalize();
+  use_plane_ = true;
 }
 
 template <typename PointT>
@@ -349,24 +327,32 @@ std::vector<int> region_detection_core::RegionCrop<PointT>::filter(bool reverse)
   // creating planar hull
   PointCloud<PointXYZ>::Ptr planar_hull = boost::make_shared<PointCloud<PointXYZ>>();
 
-  switch (config_.dir_estimation_method)
+  // a plane given with the region replaces the direction estimation
+  if (use_plane_)
+  {
+    planar_hull = computePlanarHullFromGivenPlane(closed_region_, plane_);
+  }
+  else
   {
-    case DirectionEstMethods::NORMAL_AVGR:
-      planar_hull = computePlanarHullFromNormals(closed_region_);
-      break;
-    case DirectionEstMethods::PLANE_NORMAL:
-      planar_hull = computePlanarHullFromPlane(closed_region_);
-      break;
-    case DirectionEstMethods::POSE_Z_AXIS:
-      planar_hull = computePlanarHullFromZVector(closed_region_);
-      break;
-    case DirectionEstMethods::USER_DEFINED:
-      planar_hull = computePlanarHullFromUserVector(closed_region_, config_.user_dir);
-      break;
-    default:
-      std::string err_msg = boost::str(boost::format("Direction Estimation Method %i is not supported") %
-                                       static_cast<int>(config_.dir_estimation_method));
-      throw std::runtime_error(err_msg);
+    switch (config_.dir_estimation_method)
+    {
+      case DirectionEstMethods::NORMAL_AVGR:
+        planar_hull = computePlanarHullFromNormals(closed_region_);
+        break;
+      case DirectionEstMethods::PLANE_NORMAL:
+        planar_hull = computePlanarHullFromPlane(closed_region_);
+        break;
+      case DirectionEstMethods::POSE_Z_AXIS:
+        planar_hull = computePlanarHullFromZVector(closed_region_);
+        break;
+      case DirectionEstMethods::USER_DEFINED:
+        planar_hull = computePlanarHullFromUserVector(closed_region_, config_.user_dir);
+        break;
+      default:
+        std::string err_msg = boost::str(boost::format("Direction Estimation Method %i is not supported") %
+                                         static_cast<int>(config_.dir_estimation_method));
+        throw std::runtime_error(err_msg);
+    }
   }
 
   // scaling planar hull
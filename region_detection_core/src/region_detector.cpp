@@ -33,6 +33,17 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
 #include <yaml-cpp/yaml.h>
 
 #include <opencv2/highgui.hpp>
@@ -46,7 +57,8 @@
 
 #include <pcl/common/transforms.h>
 #include <pcl/filters/voxel_grid.h>
-#include <pcl/kdtree/kdtree_flann.h>
+#include <pcl/search/brute_force.h>
+#include <pcl/search/kdtree.h>
 #include <pcl/features/normal_3d.h>
 #include <pcl/conversions.h>
 #include <pcl/filters/statistical_outlier_removal.h>
@@ -54,11 +66,18 @@
 #include <pcl/filters/extract_indices.h>
 
 #include "region_detection_core/region_detector.h"
+#include "region_detection_core/autotuner.h"
+#include "region_detection_core/binary_image.h"
+#include "region_detection_core/chain_contour.h"
+#include "region_detection_core/cloud_planes.h"
+#include "region_detection_core/executor.h"
+#include "region_detection_core/pipeline_2d.h"
+#include "region_detection_core/skeleton_tracer.h"
+#include "region_detection_core/tiled_cloud.h"
 
 static const std::map<int, int> DILATION_TYPES = { { 0, cv::MORPH_RECT },
                                                    { 1, cv::MORPH_CROSS },
                                                    { 2, cv::MORPH_ELLIPSE } };
-static cv::RNG RANDOM_NUM_GEN(12345);
 static const int MIN_PIXEL_DISTANCE = 1;  // used during interpolation in pixel space
 static const double MIN_POINT_DIST = 1e-8;
 
@@ -95,6 +114,10 @@ std::vector<T> linspace(T a, T b, size_t N)
   return xs;
 }
 
+namespace region_detection_core
+{
+namespace detail
+{
 /**
  * Perform one thinning iteration.
  * Normally you wouldn't call this function directly from your code.
@@ -150,30 +173,20 @@ void thinningGuoHall(cv::Mat& im)
 
   im *= 255;
 }
+}  // namespace detail
+}  // namespace region_detection_core
 
-pcl::PointCloud<pcl::PointXYZ> convert2DContourToCloud(const std::vector<cv::Point>& contour_2d)
+void addPixelToCloud(const cv::Point& p_2d, pcl::PointCloud<pcl::PointXYZ>& contour_3d)
 {
-  pcl::PointCloud<pcl::PointXYZ> contour_3d;
-  pcl::PointXYZ p_3d;
-  for (const auto& p_2d : contour_2d)
-  {
-    p_3d.x = p_2d.x;
-    p_3d.y = p_2d.y;
-    p_3d.z = 0.0;
-    contour_3d.push_back(p_3d);
-  }
-  return contour_3d;
+  contour_3d.push_back(pcl::PointXYZ(p_2d.x, p_2d.y, 0.0));
 }
 
-std::vector<cv::Point> convertCloudTo2DContour(const pcl::PointCloud<pcl::PointXYZ>& contour_3d)
+region_detection_core::ChainContour convertCloudToChainContour(const pcl::PointCloud<pcl::PointXYZ>& contour_3d)
 {
-  std::vector<cv::Point> contour_2d;
-  cv::Point p_2d;
+  region_detection_core::ChainContour contour_2d;
   for (const auto& p_3d : contour_3d)
   {
-    p_2d.x = p_3d.x;
-    p_2d.y = p_3d.y;
-    contour_2d.push_back(p_2d);
+    contour_2d.push_back(cv::Point(static_cast<int>(p_3d.x), static_cast<int>(p_3d.y)));
   }
   return contour_2d;
 }
@@ -202,6 +215,108 @@ void removeInfinite(pcl::PointCloud<PointT>& cloud)
   copyPointCloud(finite_cloud, cloud);
 }
 
+/**
+ * @brief removes the nan and infinite points of a curve and optionally its statistical outliers
+ */
+template <class PointT>
+void cleanCurve(pcl::PointCloud<PointT>& curve, const region_detection_core::config_3d::StatisticalRemovalCfg& cfg)
+{
+  std::vector<int> nan_indices = {};
+  curve.is_dense = false;
+  pcl::removeNaNFromPointCloud(curve, curve, nan_indices);
+  removeInfinite(curve);
+
+  if (cfg.enable)
+  {
+    pcl::StatisticalOutlierRemoval<PointT> sor;
+    sor.setInputCloud(curve.makeShared());
+    sor.setMeanK(cfg.kmeans);
+    sor.setStddevMulThresh(cfg.stddev);
+    sor.filter(curve);
+  }
+}
+
+void cleanNormals(std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr>& normals)
+{
+  for (auto& cn : normals)
+  {
+    std::vector<int> removed_indices;
+    cn->is_dense = false;
+    pcl::removeNaNNormalsFromPointCloud(*cn, *cn, removed_indices);
+    removeInfinite(*cn);
+  }
+}
+
+/**
+ * @brief fits a plane to the points of the pixel window around (x, y) that are within the search radius of the point
+ * pn, the normal is oriented towards the viewpoint and left as nan when there are too few neighbors
+ */
+void estimateWindowNormal(const region_detection_core::CloudPlanes& planes,
+                          int x,
+                          int y,
+                          const region_detection_core::config_3d::NormalEstimationCfg& cfg,
+                          pcl::PointNormal& pn)
+{
+  using namespace Eigen;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  pn.normal_x = pn.normal_y = pn.normal_z = pn.curvature = nan;
+  if (!planes.isValid(static_cast<std::size_t>(y) * planes.width() + x))
+  {
+    return;
+  }
+
+  const Vector3f center(pn.x, pn.y, pn.z);
+  region_detection_core::CloudPlanes::Moments moments =
+      planes.windowMoments(x, y, cfg.window_size / 2, center, static_cast<float>(cfg.search_radius));
+  if (moments.count < 3)
+  {
+    return;
+  }
+
+  Vector3d mean = moments.sum / moments.count;
+  Matrix3d covariance = moments.sum_sqr / moments.count - mean * mean.transpose();
+  SelfAdjointEigenSolver<Matrix3d> solver;
+  solver.computeDirect(covariance);
+  Vector3d normal = solver.eigenvectors().col(0);
+  Vector3d viewpoint(cfg.viewpoint_xyz[0], cfg.viewpoint_xyz[1], cfg.viewpoint_xyz[2]);
+  if (normal.dot(viewpoint - center.cast<double>()) < 0.0)
+  {
+    normal = -normal;
+  }
+  double eigen_sum = solver.eigenvalues().sum();
+  pn.normal_x = static_cast<float>(normal.x());
+  pn.normal_y = static_cast<float>(normal.y());
+  pn.normal_z = static_cast<float>(normal.z());
+  pn.curvature = eigen_sum > 0.0 ? static_cast<float>(solver.eigenvalues()(0) / eigen_sum) : 0.0f;
+}
+
+/**
+ * @brief keeps the points of an ordered curve that are at least min_dist away from the previous point kept, the last
+ * point is always kept
+ */
+void decimateOrderedCloud(pcl::PointCloud<pcl::PointXYZ>& cloud, double min_dist)
+{
+  if (cloud.size() < 3)
+  {
+    return;
+  }
+
+  std::size_t num_kept = 1;
+  for (std::size_t i = 1; i < cloud.size() - 1; i++)
+  {
+    const pcl::PointXYZ& last = cloud[num_kept - 1];
+    double dx = cloud[i].x - last.x;
+    double dy = cloud[i].y - last.y;
+    double dz = cloud[i].z - last.z;
+    if (std::sqrt(dx * dx + dy * dy + dz * dz) >= min_dist)
+    {
+      cloud[num_kept++] = cloud[i];
+    }
+  }
+  cloud[num_kept++] = cloud.back();
+  cloud.resize(num_kept);
+}
+
 void dowsampleCloud(pcl::PointCloud<pcl::PointXYZ>& cloud, double leafsize = 1.0)
 {
   using namespace pcl;
@@ -223,6 +338,396 @@ concaveHullSimplification(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr closed_
   return simplified_polygon;
 }
 
+/**
+ * @brief creates the nearest point search selected by the backend config
+ */
+pcl::search::Search<pcl::PointXYZ>::Ptr createSearch(const std::string& backend, double epsilon)
+{
+  if (backend == "brute_force")
+  {
+    return boost::make_shared<pcl::search::BruteForce<pcl::PointXYZ>>(true);
+  }
+
+  auto tree = boost::make_shared<pcl::search::KdTree<pcl::PointXYZ>>(true);
+  tree->setEpsilon(epsilon);
+  return tree;
+}
+
+double secondsSince(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief compares two images of the same size and type tile by tile, the changed tiles of each row are merged into a
+ * single rectangle
+ */
+std::vector<cv::Rect> findChangedTiles(const cv::Mat& previous, const cv::Mat& current, int tile_size, int threshold)
+{
+  std::vector<cv::Rect> changed_tiles;
+  for (int y = 0; y < current.rows; y += tile_size)
+  {
+    cv::Rect run;
+    for (int x = 0; x < current.cols; x += tile_size)
+    {
+      cv::Rect tile(x, y, std::min(tile_size, current.cols - x), std::min(tile_size, current.rows - y));
+      if (cv::norm(previous(tile), current(tile), cv::NORM_INF) > threshold)
+      {
+        run = run.area() > 0 ? (run | tile) : tile;
+        continue;
+      }
+
+      if (run.area() > 0)
+      {
+        changed_tiles.push_back(run);
+        run = cv::Rect();
+      }
+    }
+
+    if (run.area() > 0)
+    {
+      changed_tiles.push_back(run);
+    }
+  }
+  return changed_tiles;
+}
+
+/**
+ * @brief true when the layout of the clouds differs or when the z value of any point changed more than the threshold,
+ * clouds without a float z field are compared byte by byte
+ */
+bool cloudChanged(const pcl::PCLPointCloud2& previous, const pcl::PCLPointCloud2& current, double depth_threshold)
+{
+  if (previous.width != current.width || previous.height != current.height ||
+      previous.point_step != current.point_step || previous.row_step != current.row_step ||
+      previous.fields.size() != current.fields.size() || previous.data.size() != current.data.size())
+  {
+    return true;
+  }
+
+  auto z_field = std::find_if(current.fields.begin(), current.fields.end(), [](const pcl::PCLPointField& field) {
+    return field.name == "z" && field.datatype == pcl::PCLPointField::FLOAT32;
+  });
+  if (z_field == current.fields.end())
+  {
+    return previous.data != current.data;
+  }
+
+  for (std::size_t row = 0; row < current.height; row++)
+  {
+    for (std::size_t col = 0; col < current.width; col++)
+    {
+      std::size_t offset = row * current.row_step + col * current.point_step + z_field->offset;
+      float z_previous, z_current;
+      std::memcpy(&z_previous, &previous.data[offset], sizeof(float));
+      std::memcpy(&z_current, &current.data[offset], sizeof(float));
+      if (std::isnan(z_previous) != std::isnan(z_current) || std::abs(z_current - z_previous) > depth_threshold)
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief true when both images are empty or have the same size, type and values
+ */
+bool sameMask(const cv::Mat& a, const cv::Mat& b)
+{
+  if (a.empty() || b.empty())
+  {
+    return a.empty() && b.empty();
+  }
+  return a.size() == b.size() && a.type() == b.type() && cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+/**
+ * @class CurveVoxels
+ * @brief Voxels occupied by the curves of each bundle, hashed by their integer coordinates.  A voxel belongs to the
+ * first bundle that adds a point to it and keeps the points of that bundle added with a curve id.
+ */
+class CurveVoxels
+{
+public:
+  struct PointRef
+  {
+    std::size_t curve;
+    std::size_t index;
+    Eigen::Vector3f p;
+  };
+
+  explicit CurveVoxels(double voxel_size) : inv_size_(1.0 / voxel_size) {}
+
+  void add(const pcl::PointCloud<pcl::PointXYZ>& curve, int bundle, std::size_t curve_id = NO_CURVE)
+  {
+    for (std::size_t i = 0; i < curve.size(); i++)
+    {
+      Voxel& voxel = voxels_.emplace(key(voxelOf(curve[i])), Voxel{ bundle, {} }).first->second;
+      if (curve_id != NO_CURVE && voxel.bundle == bundle)
+      {
+        voxel.points.push_back(PointRef{ curve_id, i, curve[i].getVector3fMap() });
+      }
+    }
+  }
+
+  /**
+   * @brief true when the point's voxel or one of its neighbors belongs to another bundle
+   */
+  bool coveredByOther(const pcl::PointXYZ& p, int bundle) const
+  {
+    Eigen::Vector3i v = voxelOf(p);
+    for (int dx = -1; dx <= 1; dx++)
+    {
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+          auto it = voxels_.find(key(v + Eigen::Vector3i(dx, dy, dz)));
+          if (it != voxels_.end() && it->second.bundle != bundle)
+          {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief closest point added with a curve id by another bundle in the point's voxel or its neighbors
+   * @return nullptr when there is none
+   */
+  const PointRef* nearestOther(const pcl::PointXYZ& p, int bundle) const
+  {
+    const PointRef* nearest = nullptr;
+    float min_dist = std::numeric_limits<float>::max();
+    Eigen::Vector3i v = voxelOf(p);
+    for (int dx = -1; dx <= 1; dx++)
+    {
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+          auto it = voxels_.find(key(v + Eigen::Vector3i(dx, dy, dz)));
+          if (it == voxels_.end() || it->second.bundle == bundle)
+          {
+            continue;
+          }
+          for (const PointRef& ref : it->second.points)
+          {
+            float dist = (ref.p - p.getVector3fMap()).squaredNorm();
+            if (dist < min_dist)
+            {
+              min_dist = dist;
+              nearest = &ref;
+            }
+          }
+        }
+      }
+    }
+    return nearest;
+  }
+
+  /**
+   * @brief fraction of the curve's points covered by other bundles, an empty curve counts as covered
+   */
+  double coveredFraction(const pcl::PointCloud<pcl::PointXYZ>& curve, int bundle, std::vector<bool>& covered) const
+  {
+    covered.resize(curve.size());
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < curve.size(); i++)
+    {
+      covered[i] = coveredByOther(curve[i], bundle);
+      count += covered[i];
+    }
+    return curve.empty() ? 1.0 : static_cast<double>(count) / curve.size();
+  }
+
+  static const std::size_t NO_CURVE = std::numeric_limits<std::size_t>::max();
+
+private:
+  struct Voxel
+  {
+    int bundle;
+    std::vector<PointRef> points;
+  };
+
+  Eigen::Vector3i voxelOf(const pcl::PointXYZ& p) const
+  {
+    return Eigen::Vector3i(static_cast<int>(std::floor(p.x * inv_size_)),
+                           static_cast<int>(std::floor(p.y * inv_size_)),
+                           static_cast<int>(std::floor(p.z * inv_size_)));
+  }
+
+  // 21 bits per axis
+  static std::uint64_t key(const Eigen::Vector3i& v)
+  {
+    const std::uint64_t MASK = (1 << 21) - 1;
+    return (static_cast<std::uint64_t>(v.x()) & MASK) | ((static_cast<std::uint64_t>(v.y()) & MASK) << 21) |
+           ((static_cast<std::uint64_t>(v.z()) & MASK) << 42);
+  }
+
+  double inv_size_;
+  std::unordered_map<std::uint64_t, Voxel> voxels_;
+};
+
+/**
+ * @brief fuses the curves that mostly lie on the curves of a previous bundle into them and trims the overlapping runs
+ * off the open curves, so that each edge seen from several bundles is only merged once.  The closed curves are
+ * checked first and are either kept or fused whole.  Each point taken off a curve is averaged into the nearest kept
+ * point of another bundle, the kept curves that get fused points are replaced by copies.
+ * @param closed_kept   Set to the input indices of the closed curves that are kept, in order
+ * @return The number of curves fused whole
+ */
+std::size_t deduplicateCurves(std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& closed_curves,
+                              const std::vector<int>& closed_bundles,
+                              std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& open_curves,
+                              const std::vector<int>& open_bundles,
+                              const region_detection_core::config_3d::DeduplicationCfg& cfg,
+                              std::vector<std::size_t>& closed_kept)
+{
+  CurveVoxels voxels(cfg.voxel_size);
+  std::size_t num_dropped = 0;
+  std::vector<bool> covered;
+
+  // the closed curves kept come first
+  std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> kept;
+  std::vector<std::vector<std::pair<Eigen::Vector3f, int>>> fused;  // sum and count of the points fused per kept point
+  auto keep = [&](const pcl::PointCloud<pcl::PointXYZ>::Ptr& curve, int bundle) {
+    voxels.add(*curve, bundle, kept.size());
+    kept.push_back(curve);
+    fused.emplace_back();
+  };
+  auto fuse = [&](const pcl::PointCloud<pcl::PointXYZ>& curve, int bundle) {
+    for (std::size_t j = 0; j < curve.size(); j++)
+    {
+      const CurveVoxels::PointRef* ref = covered[j] ? voxels.nearestOther(curve[j], bundle) : nullptr;
+      if (!ref)
+      {
+        continue;
+      }
+      std::vector<std::pair<Eigen::Vector3f, int>>& sums = fused[ref->curve];
+      if (sums.empty())
+      {
+        sums.resize(kept[ref->curve]->size(), std::make_pair(Eigen::Vector3f::Zero().eval(), 0));
+      }
+      sums[ref->index].first += curve[j].getVector3fMap();
+      sums[ref->index].second++;
+    }
+  };
+
+  closed_kept.clear();
+  for (std::size_t i = 0; i < closed_curves.size(); i++)
+  {
+    if (voxels.coveredFraction(*closed_curves[i], closed_bundles[i], covered) >= cfg.min_overlap)
+    {
+      fuse(*closed_curves[i], closed_bundles[i]);
+      num_dropped++;
+      continue;
+    }
+    keep(closed_curves[i], closed_bundles[i]);
+    closed_kept.push_back(i);
+  }
+
+  for (std::size_t i = 0; i < open_curves.size(); i++)
+  {
+    const pcl::PointCloud<pcl::PointXYZ>& curve = *open_curves[i];
+    double fraction = voxels.coveredFraction(curve, open_bundles[i], covered);
+    if (fraction >= cfg.min_overlap)
+    {
+      fuse(curve, open_bundles[i]);
+      num_dropped++;
+      continue;
+    }
+    if (fraction == 0.0)
+    {
+      keep(open_curves[i], open_bundles[i]);
+      continue;
+    }
+
+    // the covered points are fused before the runs are added, the uncovered runs are left for the merge to join with
+    // the curves they continue
+    fuse(curve, open_bundles[i]);
+    pcl::PointCloud<pcl::PointXYZ>::Ptr run;
+    for (std::size_t j = 0; j <= curve.size(); j++)
+    {
+      if (j < curve.size() && !covered[j])
+      {
+        if (!run)
+        {
+          run = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+        }
+        run->push_back(curve[j]);
+      }
+      else if (run)
+      {
+        if (run->size() > 1)
+        {
+          keep(run, open_bundles[i]);
+        }
+        run.reset();
+      }
+    }
+  }
+
+  // averaging, the input curves are shared with the bundles and left as they are
+  for (std::size_t k = 0; k < kept.size(); k++)
+  {
+    if (fused[k].empty())
+    {
+      continue;
+    }
+    pcl::PointCloud<pcl::PointXYZ>::Ptr curve = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>(*kept[k]);
+    for (std::size_t j = 0; j < curve->size(); j++)
+    {
+      const std::pair<Eigen::Vector3f, int>& sum = fused[k][j];
+      if (sum.second > 0)
+      {
+        (*curve)[j].getVector3fMap() = (sum.first + (*curve)[j].getVector3fMap()) / (sum.second + 1);
+      }
+    }
+    kept[k] = curve;
+  }
+
+  closed_curves.assign(kept.begin(), kept.begin() + closed_kept.size());
+  open_curves.assign(kept.begin() + closed_kept.size(), kept.end());
+  return num_dropped;
+}
+
+/**
+ * @brief plane fitted to the points of a closed region with its normal flipped to the side of the poses' z axes
+ */
+Eigen::Hyperplane<double, 3> fitRegionPlane(const pcl::PointCloud<pcl::PointXYZ>& curve,
+                                            const region_detection_core::RegionDetector::EigenPose3dVector& poses)
+{
+  Eigen::Vector3d z_sum = Eigen::Vector3d::Zero();
+  for (const Eigen::Isometry3d& pose : poses)
+  {
+    z_sum += pose.linear().col(2);
+  }
+
+  Eigen::Vector3d centroid;
+  Eigen::Matrix3d axes;
+  if (!region_detection_core::fitCurvePlane(curve, centroid, axes))
+  {
+    // too few points, the poses give the orientation
+    Eigen::Vector3d origin = Eigen::Vector3d::Zero();
+    if (!poses.empty())
+    {
+      origin = poses.front().translation();
+    }
+    Eigen::Vector3d normal = z_sum.norm() > 0 ? Eigen::Vector3d(z_sum.normalized()) : Eigen::Vector3d::UnitZ();
+    return Eigen::Hyperplane<double, 3>(normal, origin);
+  }
+  Eigen::Vector3d normal = axes.col(0);
+  if (normal.dot(z_sum) < 0)
+  {
+    normal = -normal;
+  }
+  return Eigen::Hyperplane<double, 3>(normal, centroid);
+}
+
 namespace region_detection_core
 {
 RegionDetectionConfig RegionDetectionConfig::loadFromFile(const std::string& yaml_file)
@@ -259,6 +764,8 @@ RegionDetectionConfig RegionDetectionConfig::load(const std::string& yaml_str)
 
     opencv_cfg.contour.method = opencv_node["contour"]["method"].as<int>();
     opencv_cfg.contour.mode = opencv_node["contour"]["mode"].as<int>();
+    opencv_cfg.contour.trace_skeleton =
+        opencv_node["contour"]["trace_skeleton"].as<bool>(opencv_cfg.contour.trace_skeleton);
 
     opencv_cfg.range.low = opencv_node["range"]["low"].as<int>();
     opencv_cfg.range.high = opencv_node["range"]["high"].as<int>();
@@ -304,6 +811,81 @@ RegionDetectionConfig RegionDetectionConfig::load(const std::string& yaml_str)
     std::vector<double> viewpoint_vals = pcl_node["normal_est"]["viewpoint_xyz"].as<std::vector<double>>();
     pcl_cfg.normal_est.downsampling_radius = pcl_node["normal_est"]["downsampling_radius"].as<double>();
     std::copy(viewpoint_vals.begin(), viewpoint_vals.end(), pcl_cfg.normal_est.viewpoint_xyz.begin());
+    pcl_cfg.normal_est.method = pcl_node["normal_est"]["method"].as<std::string>(pcl_cfg.normal_est.method);
+    pcl_cfg.normal_est.window_size = pcl_node["normal_est"]["window_size"].as<int>(pcl_cfg.normal_est.window_size);
+    pcl_cfg.dedup.enable = pcl_node["dedup"]["enable"].as<bool>(pcl_cfg.dedup.enable);
+    pcl_cfg.dedup.voxel_size = pcl_node["dedup"]["voxel_size"].as<double>(pcl_cfg.dedup.voxel_size);
+    pcl_cfg.dedup.min_overlap = pcl_node["dedup"]["min_overlap"].as<double>(pcl_cfg.dedup.min_overlap);
+
+    // optional sections
+    opencv_cfg.packed_binary = opencv_node["packed_binary"].as<bool>(false);
+
+    YAML::Node graph_node = opencv_node["graph"];
+    if (graph_node)
+    {
+      opencv_cfg.graph.output = graph_node["output"].as<std::string>();
+      for (const YAML::Node& node : graph_node["nodes"])
+      {
+        config_2d::StageNodeCfg node_cfg;
+        node_cfg.name = node["name"].as<std::string>();
+        node_cfg.inputs = node["inputs"].as<std::vector<std::string>>();
+        node_cfg.methods = node["methods"].as<std::vector<std::string>>(std::vector<std::string>());
+        node_cfg.combine = node["combine"].as<std::string>("");
+        opencv_cfg.graph.nodes.push_back(node_cfg);
+      }
+    }
+
+    YAML::Node incremental_node = root["incremental"];
+    if (incremental_node)
+    {
+      RegionDetectionConfig::IncrementalCfg& incremental_cfg = cfg.incremental_cfg;
+      incremental_cfg.enable = incremental_node["enable"].as<bool>(incremental_cfg.enable);
+      incremental_cfg.tile_size = incremental_node["tile_size"].as<int>(incremental_cfg.tile_size);
+      incremental_cfg.image_threshold = incremental_node["image_threshold"].as<int>(incremental_cfg.image_threshold);
+      incremental_cfg.depth_threshold =
+          incremental_node["depth_threshold"].as<double>(incremental_cfg.depth_threshold);
+    }
+
+    YAML::Node cross_view_node = root["cross_view"];
+    if (cross_view_node)
+    {
+      RegionDetectionConfig::CrossViewCfg& cross_view_cfg = cfg.cross_view_cfg;
+      cross_view_cfg.enable = cross_view_node["enable"].as<bool>(cross_view_cfg.enable);
+      cross_view_cfg.max_plane_dist = cross_view_node["max_plane_dist"].as<double>(cross_view_cfg.max_plane_dist);
+      cross_view_cfg.margin = cross_view_node["margin"].as<int>(cross_view_cfg.margin);
+    }
+
+    YAML::Node outputs_node = root["outputs"];
+    if (outputs_node)
+    {
+      RegionDetectionConfig::OutputCfg& output_cfg = cfg.output_cfg;
+      output_cfg.closed_regions = outputs_node["closed_regions"].as<bool>(output_cfg.closed_regions);
+      output_cfg.open_regions = outputs_node["open_regions"].as<bool>(output_cfg.open_regions);
+      output_cfg.images = outputs_node["images"].as<bool>(output_cfg.images);
+      output_cfg.contours = outputs_node["contours"].as<bool>(output_cfg.contours);
+      output_cfg.normals = outputs_node["normals"].as<bool>(output_cfg.normals);
+      output_cfg.perf_counters = outputs_node["perf_counters"].as<bool>(output_cfg.perf_counters);
+    }
+
+    YAML::Node backends_node = root["backends"];
+    if (backends_node)
+    {
+      RegionDetectionConfig::BackendCfg& backend_cfg = cfg.backend_cfg;
+      backend_cfg.search = backends_node["search"].as<std::string>(backend_cfg.search);
+      backend_cfg.profile_file = backends_node["profile_file"].as<std::string>(backend_cfg.profile_file);
+    }
+
+    YAML::Node executor_node = root["executor"];
+    if (executor_node)
+    {
+      config_exec::ExecutorCfg& executor_cfg = cfg.executor_cfg;
+      executor_cfg.num_threads = executor_node["num_threads"].as<int>(executor_cfg.num_threads);
+      executor_cfg.cpu_affinity = executor_node["cpu_affinity"].as<std::vector<int>>(executor_cfg.cpu_affinity);
+      executor_cfg.opencv_threads = executor_node["opencv_threads"].as<int>(executor_cfg.opencv_threads);
+      executor_cfg.openmp_threads = executor_node["openmp_threads"].as<int>(executor_cfg.openmp_threads);
+      executor_cfg.stage_limits =
+          executor_node["stage_limits"].as<std::map<std::string, int>>(executor_cfg.stage_limits);
+    }
   }
   return cfg;
 }
@@ -313,10 +895,8 @@ pcl::PointCloud<pcl::PointXYZ> RegionDetector::sequence(pcl::PointCloud<pcl::Poi
   using namespace pcl;
   std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> sequenced_points_vec;
 
-  // build reordering kd tree
-  pcl::KdTreeFLANN<pcl::PointXYZ> sequencing_kdtree;
-  sequencing_kdtree.setEpsilon(epsilon);
-  sequencing_kdtree.setSortedResults(true);
+  // build reordering search
+  pcl::search::Search<pcl::PointXYZ>::Ptr sequencing_search = createSearch(cfg_->backend_cfg.search, epsilon);
 
   auto& cloud = *points;
   std::vector<int> sequenced_indices, unsequenced_indices;
@@ -351,14 +931,13 @@ pcl::PointCloud<pcl::PointXYZ> RegionDetector::sequence(pcl::PointCloud<pcl::Poi
 
     // set tree inputs;
     IndicesConstPtr cloud_indices = boost::make_shared<const std::vector<int>>(unsequenced_indices);
-    sequencing_kdtree.setInputCloud(points, cloud_indices);
-    sequencing_kdtree.setSortedResults(true);
+    sequencing_search->setInputCloud(points, cloud_indices);
 
     // find next point
     const int k_points = 1;
     std::vector<int> k_indices(k_points);
     std::vector<float> k_sqr_distances(k_points);
-    int points_found = sequencing_kdtree.nearestKSearch(search_point, k_points, k_indices, k_sqr_distances);
+    int points_found = sequencing_search->nearestKSearch(search_point, k_points, k_indices, k_sqr_distances);
     if (points_found < k_points)
     {
       std::string err_msg = boost::str(boost::format("NearestKSearch Search did not find any points close to [%f, %f, "
@@ -537,22 +1116,201 @@ log4cxx::LoggerPtr RegionDetector::createDefaultDebugLogger(const std::string& l
   return logger;
 }
 
-bool RegionDetector::configure(const RegionDetectionConfig& config)
+RegionDetector::StageKeys RegionDetector::makeStageKeys(const RegionDetectionConfig& cfg)
 {
-  cfg_ = std::make_shared<RegionDetectionConfig>(config);
-  return cfg_ != nullptr;
-}
+  const RegionDetectionConfig::OpenCVCfg& opencv_cfg = cfg.opencv_cfg;
+  const RegionDetectionConfig::PCL2DCfg& pcl2d_cfg = cfg.pcl_2d_cfg;
+  const RegionDetectionConfig::PCLCfg& pcl_cfg = cfg.pcl_cfg;
+  const RegionDetectionConfig::OutputCfg& output_cfg = cfg.output_cfg;
+  auto join = [](std::ostream& os, const std::vector<std::string>& names) {
+    for (const std::string& name : names)
+    {
+      os << name << ",";
+    }
+    os << ";";
+  };
 
-bool RegionDetector::configureFromFile(const std::string& yaml_file)
-{
-  return configure(RegionDetectionConfig::loadFromFile(yaml_file));
+  std::ostringstream mask;
+  mask.precision(17);
+  join(mask, opencv_cfg.methods);
+  mask << opencv_cfg.threshold.value << " " << opencv_cfg.threshold.type << " " << opencv_cfg.dilation.elem << " "
+       << opencv_cfg.dilation.kernel_size << " " << opencv_cfg.erosion.elem << " " << opencv_cfg.erosion.kernel_size
+       << " " << opencv_cfg.canny.lower_threshold << " " << opencv_cfg.canny.upper_threshold << " "
+       << opencv_cfg.canny.aperture_size << " " << opencv_cfg.range.low << " " << opencv_cfg.range.high << " "
+       << opencv_cfg.hsv.h[0] << " " << opencv_cfg.hsv.h[1] << " " << opencv_cfg.hsv.s[0] << " " << opencv_cfg.hsv.s[1]
+       << " " << opencv_cfg.hsv.v[0] << " " << opencv_cfg.hsv.v[1] << " " << opencv_cfg.clahe.clip_limit << " "
+       << opencv_cfg.clahe.tile_grid_size[0] << " " << opencv_cfg.clahe.tile_grid_size[1] << " "
+       << opencv_cfg.packed_binary << ";";
+  for (const config_2d::StageNodeCfg& node : opencv_cfg.graph.nodes)
+  {
+    mask << node.name << ":" << node.combine << ":";
+    join(mask, node.inputs);
+    join(mask, node.methods);
+  }
+  mask << opencv_cfg.graph.output;
+
+  std::ostringstream contours;
+  contours.precision(17);
+  contours << opencv_cfg.contour.mode << " " << opencv_cfg.contour.method << " " << opencv_cfg.contour.trace_skeleton
+           << " " << pcl2d_cfg.downsampling_radius << " "
+           << pcl2d_cfg.split_dist << " " << pcl2d_cfg.closed_curve_max_dist << " "
+           << pcl2d_cfg.simplification_min_points << " " << pcl2d_cfg.simplification_alpha << " "
+           << (output_cfg.images || opencv_cfg.debug_mode_enable) << " " << output_cfg.contours << " "
+           << cfg.backend_cfg.search;
+
+  std::ostringstream points;
+  points.precision(17);
+  const config_3d::NormalEstimationCfg& normal_est = pcl_cfg.normal_est;
+  points << pcl_cfg.stat_removal.enable << " " << pcl_cfg.stat_removal.kmeans << " " << pcl_cfg.stat_removal.stddev
+         << " " << (output_cfg.normals || output_cfg.closed_regions || output_cfg.open_regions) << " "
+         << normal_est.downsampling_radius << " " << normal_est.search_radius << " " << normal_est.kdtree_epsilon << " "
+         << normal_est.viewpoint_xyz[0] << " " << normal_est.viewpoint_xyz[1] << " " << normal_est.viewpoint_xyz[2]
+         << " " << cfg.backend_cfg.search << " " << normal_est.method << " " << normal_est.window_size;
+
+  std::ostringstream curves;
+  curves.precision(17);
+  curves << pcl_cfg.split_dist;
+
+  RegionDetector::StageKeys keys;
+  keys.mask = mask.str();
+  keys.contours = contours.str();
+  keys.points = points.str();
+  keys.curves = curves.str();
+  return keys;
 }
 
-bool RegionDetector::configure(const std::string& yaml_str) { return configure(RegionDetectionConfig::load(yaml_str)); }
-
-log4cxx::LoggerPtr RegionDetector::getLogger() { return logger_; }
+bool RegionDetector::configure(const RegionDetectionConfig& input_config)
+{
+  std::string err_msg;
 
-const RegionDetectionConfig& RegionDetector::getConfig() { return *cfg_; }
+  // the settings pinned by an autotuning profile replace the configured ones
+  RegionDetectionConfig config = input_config;
+  if (!config.backend_cfg.profile_file.empty())
+  {
+    AutotuneProfile profile;
+    int cpus = static_cast<int>(Executor::getAvailableCpus().size());
+    if (!AutotuneProfile::load(config.backend_cfg.profile_file, profile, err_msg))
+    {
+      LOG4CXX_ERROR(logger_, err_msg);
+      return false;
+    }
+
+    if (profile.cpus != cpus)
+    {
+      LOG4CXX_WARN(logger_,
+                   "Autotuning profile " << config.backend_cfg.profile_file << " was made on a machine with "
+                                         << profile.cpus << " cpus, ignoring it");
+    }
+    else
+    {
+      config.backend_cfg.search = profile.search;
+      if (config.executor_cfg.opencv_threads < 0)
+      {
+        config.executor_cfg.opencv_threads = profile.opencv_threads;
+      }
+      LOG4CXX_DEBUG(logger_,
+                    "Using autotuned search " << profile.search << " and opencv threads "
+                                              << config.executor_cfg.opencv_threads);
+    }
+  }
+
+  if (config.backend_cfg.search != "kdtree" && config.backend_cfg.search != "brute_force")
+  {
+    LOG4CXX_ERROR(logger_, "Invalid search backend " << config.backend_cfg.search);
+    return false;
+  }
+
+  const config_3d::NormalEstimationCfg& normal_est = config.pcl_cfg.normal_est;
+  if ((normal_est.method != "radius" && normal_est.method != "organized") || normal_est.window_size < 3)
+  {
+    LOG4CXX_ERROR(logger_, "Invalid normal estimation method " << normal_est.method << " or window size");
+    return false;
+  }
+
+  if (!Executor::validate(config.executor_cfg, err_msg))
+  {
+    LOG4CXX_ERROR(logger_, err_msg);
+    return false;
+  }
+
+  if (config.incremental_cfg.enable && config.incremental_cfg.tile_size <= 0)
+  {
+    LOG4CXX_ERROR(logger_, "The incremental tile size must be greater than 0");
+    return false;
+  }
+
+  const config_3d::DeduplicationCfg& dedup = config.pcl_cfg.dedup;
+  if (dedup.enable && (dedup.voxel_size <= 0.0 || dedup.min_overlap <= 0.0 || dedup.min_overlap > 1.0))
+  {
+    LOG4CXX_ERROR(logger_, "The dedup voxel size must be greater than 0 and the min overlap within (0, 1]");
+    return false;
+  }
+
+  if (config.cross_view_cfg.enable && (config.cross_view_cfg.max_plane_dist <= 0.0 || config.cross_view_cfg.margin < 0))
+  {
+    LOG4CXX_ERROR(logger_, "The cross view plane distance must be greater than 0 and the margin not negative");
+    return false;
+  }
+
+  StageGraph stage_graph;
+  if (!stage_graph.build(config.opencv_cfg.graph, err_msg))
+  {
+    LOG4CXX_ERROR(logger_, err_msg);
+    return false;
+  }
+
+  for (const StageGraph::Node& node : stage_graph.getNodes())
+  {
+    for (const std::string& method_name : node.methods)
+    {
+      if (METHOD_CODES_MAPPINGS.count(method_name) == 0)
+      {
+        LOG4CXX_ERROR(logger_, "2D Method " << method_name << " in stage graph node " << node.name << " is not valid");
+        return false;
+      }
+    }
+  }
+
+  // the pool is only restarted when its settings change
+  const config_exec::ExecutorCfg& executor_cfg = config.executor_cfg;
+  bool restart_executor = !executor_ || !cfg_ || executor_cfg.num_threads != cfg_->executor_cfg.num_threads ||
+                          executor_cfg.cpu_affinity != cfg_->executor_cfg.cpu_affinity ||
+                          executor_cfg.opencv_threads != cfg_->executor_cfg.opencv_threads ||
+                          executor_cfg.openmp_threads != cfg_->executor_cfg.openmp_threads ||
+                          executor_cfg.stage_limits != cfg_->executor_cfg.stage_limits;
+
+  cfg_ = std::make_shared<RegionDetectionConfig>(config);
+  stage_graph_ = stage_graph;
+
+  // the bundle caches are kept, each cached stage is rerun only when the config values it depends on changed
+  if (restart_executor)
+  {
+    executor_.reset();
+    executor_ = std::make_shared<Executor>(cfg_->executor_cfg, logger_);
+  }
+  return cfg_ != nullptr;
+}
+
+bool RegionDetector::configureFromFile(const std::string& yaml_file)
+{
+  return configure(RegionDetectionConfig::loadFromFile(yaml_file));
+}
+
+bool RegionDetector::configure(const std::string& yaml_str) { return configure(RegionDetectionConfig::load(yaml_str)); }
+
+log4cxx::LoggerPtr RegionDetector::getLogger() { return logger_; }
+
+const RegionDetectionConfig& RegionDetector::getConfig() { return *cfg_; }
+
+void RegionDetector::set2dStage(Stage2D stage, std::vector<std::string> methods)
+{
+  // the cached masks can not be checked against a custom stage
+  stage_2d_ = std::move(stage);
+  stage_2d_methods_ = stage_2d_ ? std::move(methods) : std::vector<std::string>();
+  bundle_caches_.clear();
+}
+
+void RegionDetector::setOutputs(const RegionDetectionConfig::OutputCfg& outputs) { cfg_->output_cfg = outputs; }
 
 void RegionDetector::updateDebugWindow(const cv::Mat& im) const
 {
@@ -585,9 +1343,11 @@ RegionDetector::Result RegionDetector::apply2dGrayscale(cv::Mat input, cv::Mat&
 {
   const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
 
+  // single channel images are expected, e.g. compressed images decoded as grayscale by the ros servers
   if (input.channels() == 1)
   {
-    LOG4CXX_WARN(logger_, "Input image is already of one channel, skipping Grayscale Conversion");
+    LOG4CXX_DEBUG(logger_, "Input image is already of one channel, skipping Grayscale Conversion");
+    output = input;
     return true;
   }
 
@@ -599,7 +1359,7 @@ RegionDetector::Result RegionDetector::apply2dGrayscale(cv::Mat input, cv::Mat&
 RegionDetector::Result RegionDetector::apply2dRange(cv::Mat input, cv::Mat& output) const
 {
   const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
-  cv::inRange(input.clone(), cv::Scalar(config.range.low), cv::Scalar(config.range.high), output);
+  cv::inRange(input, cv::Scalar(config.range.low), cv::Scalar(config.range.high), output);
   return true;
 }
 
@@ -650,7 +1410,7 @@ RegionDetector::Result RegionDetector::apply2dInvert(cv::Mat input, cv::Mat& out
 {
   const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
   cv::Mat inverted = cv::Scalar_<uint8_t>(255) - input;
-  output = inverted.clone();
+  output = inverted;
   LOG4CXX_ERROR(logger_, "2D analysis: Inversion");
   return true;
 }
@@ -663,7 +1423,7 @@ RegionDetector::Result RegionDetector::apply2dThreshold(cv::Mat input, cv::Mat&
   return true;
 }
 
-RegionDetector::Result RegionDetector::apply2dDilation(cv::Mat input, cv::Mat& output) const
+RegionDetector::Result RegionDetector::createDilationElement(cv::Mat& element) const
 {
   const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
   bool success;
@@ -687,15 +1447,13 @@ RegionDetector::Result RegionDetector::apply2dDilation(cv::Mat input, cv::Mat& o
     return Result(success, err_msg);
   }
   int dilation_type = DILATION_TYPES.at(config.dilation.elem);
-  cv::Mat element =
-      cv::getStructuringElement(dilation_type,
-                                cv::Size(2 * config.dilation.kernel_size + 1, 2 * config.dilation.kernel_size + 1),
-                                cv::Point(config.dilation.kernel_size, config.dilation.kernel_size));
-  cv::dilate(input, output, element);
+  element = cv::getStructuringElement(dilation_type,
+                                      cv::Size(2 * config.dilation.kernel_size + 1, 2 * config.dilation.kernel_size + 1),
+                                      cv::Point(config.dilation.kernel_size, config.dilation.kernel_size));
   return true;
 }
 
-RegionDetector::Result RegionDetector::apply2dErosion(cv::Mat input, cv::Mat& output) const
+RegionDetector::Result RegionDetector::createErosionElement(cv::Mat& element) const
 {
   const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
   bool success;
@@ -719,14 +1477,54 @@ RegionDetector::Result RegionDetector::apply2dErosion(cv::Mat input, cv::Mat& ou
     return Result(success, err_msg);
   }
   int dilation_type = DILATION_TYPES.at(config.dilation.elem);
-  cv::Mat element =
-      cv::getStructuringElement(dilation_type,
-                                cv::Size(2 * config.erosion.kernel_size + 1, 2 * config.erosion.kernel_size + 1),
-                                cv::Point(config.erosion.kernel_size, config.erosion.kernel_size));
+  element = cv::getStructuringElement(dilation_type,
+                                      cv::Size(2 * config.erosion.kernel_size + 1, 2 * config.erosion.kernel_size + 1),
+                                      cv::Point(config.erosion.kernel_size, config.erosion.kernel_size));
+  return true;
+}
+
+RegionDetector::Result RegionDetector::apply2dDilation(cv::Mat input, cv::Mat& output) const
+{
+  cv::Mat element;
+  Result res = createDilationElement(element);
+  if (!res)
+  {
+    return res;
+  }
+  cv::dilate(input, output, element);
+  return true;
+}
+
+RegionDetector::Result RegionDetector::apply2dErosion(cv::Mat input, cv::Mat& output) const
+{
+  cv::Mat element;
+  Result res = createErosionElement(element);
+  if (!res)
+  {
+    return res;
+  }
   cv::erode(input, output, element);
   return true;
 }
 
+RegionDetector::Result RegionDetector::applyPackedMorphology(Methods2D method, BinaryImage& image) const
+{
+  cv::Mat element;
+  Result res = method == Methods2D::DILATION ? createDilationElement(element) : createErosionElement(element);
+  if (!res)
+  {
+    return res;
+  }
+
+  bool success = method == Methods2D::DILATION ? image.dilate(element, cv::Point(-1, -1), image) :
+                                                  image.erode(element, cv::Point(-1, -1), image);
+  if (!success)
+  {
+    return Result(false, "structuring element is not supported by the packed binary image");
+  }
+  return true;
+}
+
 RegionDetector::Result RegionDetector::apply2dCanny(cv::Mat input, cv::Mat& output) const
 {
   const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
@@ -734,7 +1532,7 @@ RegionDetector::Result RegionDetector::apply2dCanny(cv::Mat input, cv::Mat& outp
   int aperture_size = 2 * config.canny.aperture_size + 1;
   aperture_size = aperture_size < 3 ? 3 : aperture_size;
   cv::Canny(input, detected_edges, config.canny.lower_threshold, config.canny.upper_threshold, aperture_size, true);
-  output = detected_edges.clone();
+  output = detected_edges;
   return true;
 }
 
@@ -742,31 +1540,71 @@ RegionDetector::Result RegionDetector::compute2dContours(cv::Mat input,
                                                          std::vector<std::vector<cv::Point>>& contours_indices,
                                                          cv::Mat& output) const
 {
-  const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
-
-  Result res = compute2d(input, output);
+  BinaryImage packed;
+  Result res = compute2dMask(input, output, &packed);
   if (!res)
   {
     return res;
   }
+  cv::Mat mask = output;
+  return traceContours(mask, contours_indices, output, &packed);
+}
+
+RegionDetector::Result RegionDetector::traceContours(const cv::Mat& mask,
+                                                     std::vector<std::vector<cv::Point>>& contours_indices,
+                                                     cv::Mat& output,
+                                                     const BinaryImage* packed_mask) const
+{
+  const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
 
   //  ======================== Contour Detection ========================
   std::vector<cv::Vec4i> hierarchy;
+  const bool skeleton = tracesSkeleton(mask);
   try
   {
-    cv::findContours(output.clone(), contours_indices, hierarchy, config.contour.mode, config.contour.method);
+    // the mask is only packed here when the 2d methods did not leave it packed
+    BinaryImage packed;
+    if (config.packed_binary && !skeleton && (!packed_mask || packed_mask->empty()) && BinaryImage::pack(mask, packed))
+    {
+      packed_mask = &packed;
+    }
+
+    if (skeleton)
+    {
+      // findContours would follow both sides of every line
+      traceSkeleton(mask, contours_indices);
+    }
+    else if (!config.packed_binary || !packed_mask || packed_mask->empty() ||
+             !packed_mask->findContours(contours_indices, hierarchy, config.contour.mode, config.contour.method))
+    {
+      cv::findContours(mask, contours_indices, hierarchy, config.contour.mode, config.contour.method);
+    }
   }
   catch (cv::Exception& ex)
   {
     return Result(false, boost::str(boost::format("Failed finding contours with error: %s") % ex.what()));
   }
 
-  cv::Mat drawing = cv::Mat::zeros(output.size(), CV_8UC3);
   LOG4CXX_INFO(logger_, "Contour analysis found " << contours_indices.size() << " contours");
+  if (!cfg_->output_cfg.images && !config.debug_mode_enable)
+  {
+    output = cv::Mat();
+    LOG4CXX_DEBUG(logger_, "Completed 2D analysis");
+    return true;
+  }
+
+  // local generator since the contours of several images may be drawn concurrently
+  cv::RNG random_num_gen(12345);
+  cv::Mat drawing = cv::Mat::zeros(mask.size(), CV_8UC3);
   for (int i = 0; i < contours_indices.size(); i++)
   {
     cv::Scalar color =
-        cv::Scalar(RANDOM_NUM_GEN.uniform(0, 255), RANDOM_NUM_GEN.uniform(0, 255), RANDOM_NUM_GEN.uniform(0, 255));
+        cv::Scalar(random_num_gen.uniform(0, 255), random_num_gen.uniform(0, 255), random_num_gen.uniform(0, 255));
+    if (skeleton)
+    {
+      cv::polylines(drawing, contours_indices[i], false, color, 2, 8);
+      continue;
+    }
     double area = cv::contourArea(contours_indices[i]);
     double arc_length = cv::arcLength(contours_indices[i], false);
     cv::drawContours(drawing, contours_indices, i, color, 2, 8, hierarchy, 0, cv::Point());
@@ -776,21 +1614,19 @@ RegionDetector::Result RegionDetector::compute2dContours(cv::Mat input,
   }
   updateDebugWindow(drawing);
 
-  output = drawing.clone();
+  output = drawing;
   LOG4CXX_DEBUG(logger_, "Completed 2D analysis");
   return true;
 }
 
-bool RegionDetector::compute2d(cv::Mat input, cv::Mat& output) const
+RegionDetector::Result RegionDetector::apply2dMethods(const std::vector<std::string>& methods,
+                                                      cv::Mat input,
+                                                      cv::Mat& output,
+                                                      BinaryImage* packed_output) const
 {
   namespace ph = std::placeholders;
   using Func2D = std::function<region_detection_core::RegionDetector::Result(cv::Mat, cv::Mat&)>;
 
-  bool success = false;
-  std::string err_msg;
-  output = input;
-  const RegionDetectionConfig::OpenCVCfg& config = cfg_->opencv_cfg;
-
   std::map<Methods2D, Func2D> function_mappings = {
     { Methods2D::GRAYSCALE, std::bind(&RegionDetector::apply2dGrayscale, this, ph::_1, ph::_2) },
     { Methods2D::INVERT, std::bind(&RegionDetector::apply2dInvert, this, ph::_1, ph::_2) },
@@ -801,7 +1637,8 @@ bool RegionDetector::compute2d(cv::Mat input, cv::Mat& output) const
     { Methods2D::THINNING,
       [](cv::Mat input, cv::Mat& output) -> Result {
         input.copyTo(output);
-        thinningGuoHall(output);
+        detail::thinningGuoHall(output);
+        return true;
       } },
     { Methods2D::RANGE, std::bind(&RegionDetector::apply2dRange, this, ph::_1, ph::_2) },
     { Methods2D::HSV, std::bind(&RegionDetector::apply2dHSV, this, ph::_1, ph::_2) },
@@ -810,19 +1647,63 @@ bool RegionDetector::compute2d(cv::Mat input, cv::Mat& output) const
     { Methods2D::CLAHE, std::bind(&RegionDetector::apply2dCLAHE, this, ph::_1, ph::_2) }
   };
 
-  for (std::string& method_name : cfg_->opencv_cfg.methods)
+  // binary images stay packed through consecutive morphological operations
+  BinaryImage packed;
+  auto unpack = [&packed](cv::Mat& image) {
+    cv::Mat unpacked;
+    packed.unpack(unpacked);
+    image = unpacked;
+    packed = BinaryImage();
+  };
+
+  cv::Mat current = input;
+  for (const std::string& method_name : methods)
   {
     if (METHOD_CODES_MAPPINGS.count(method_name) > 0)
     {
       try
       {
-        Result res = function_mappings.at(METHOD_CODES_MAPPINGS.at(method_name))(input, output);
+        Methods2D method = METHOD_CODES_MAPPINGS.at(method_name);
+        bool morphology = method == Methods2D::DILATION || method == Methods2D::EROSION;
+        if (cfg_->opencv_cfg.packed_binary && morphology && packed.empty())
+        {
+          BinaryImage candidate;
+          if (BinaryImage::pack(current, candidate) && candidate.isBinary())
+          {
+            packed = std::move(candidate);
+          }
+        }
+
+        if (morphology && !packed.empty())
+        {
+          Result res = applyPackedMorphology(method, packed);
+          if (!res)
+          {
+            return res;
+          }
+          if (cfg_->opencv_cfg.debug_mode_enable)
+          {
+            cv::Mat debug_image;
+            packed.unpack(debug_image);
+            updateDebugWindow(debug_image);
+          }
+          continue;
+        }
+
+        if (!packed.empty())
+        {
+          unpack(current);
+        }
+
+        // the first method writes into a new buffer since the input may be shared with other stages
+        cv::Mat result = current.data == input.data ? cv::Mat() : current;
+        Result res = function_mappings.at(method)(current, result);
         if (!res)
         {
           return res;
         }
-        input = output;
-        updateDebugWindow(output);
+        current = result;
+        updateDebugWindow(current);
       }
       catch (cv::Exception& e)
       {
@@ -835,268 +1716,1193 @@ bool RegionDetector::compute2d(cv::Mat input, cv::Mat& output) const
       LOG4CXX_ERROR(logger_, err_msg);
     }
   }
+  if (!packed.empty())
+  {
+    // the contour tracing can use the packed image as it is
+    cv::Mat unpacked;
+    packed.unpack(unpacked);
+    current = unpacked;
+    if (packed_output)
+    {
+      *packed_output = std::move(packed);
+    }
+  }
+  output = current;
   return true;
 }
 
-bool RegionDetector::compute2d(cv::Mat input,
-                               cv::Mat& output,
-                               std::vector<std::vector<cv::Point>>& contours_indices) const
-{
-  return compute2dContours(input, contours_indices, output);
-}
-
-bool RegionDetector::compute(const RegionDetector::DataBundleVec& input, RegionDetector::RegionResults& regions)
+RegionDetector::Result RegionDetector::compute2dGraph(cv::Mat input, cv::Mat& output) const
 {
-  using namespace pcl;
-  std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> closed_contours_points, open_contours_points;
-  pcl::PointCloud<pcl::PointNormal>::Ptr normals = boost::make_shared<pcl::PointCloud<pcl::PointNormal>>();
-
-  Result res;
-  window_counter_ = 0;
-  for (const DataBundle& data : input)
-  {
-    window_counter_++;
-
-    // ============================== Open CV =================================== //
-    LOG4CXX_DEBUG(logger_, "Computing 2d contours");
-    cv::Mat output;
-    std::vector<std::vector<cv::Point>> contours_indices;
-    res = compute2dContours(data.image, contours_indices, output);
-    regions.images.push_back(output);
-    if (!res)
+  const std::vector<StageGraph::Node>& nodes = stage_graph_.getNodes();
+  std::vector<cv::Mat> images(nodes.size());
+  std::vector<Result> results(nodes.size());
+  std::vector<std::size_t> pending_consumers(nodes.size());
+  std::transform(nodes.begin(), nodes.end(), pending_consumers.begin(), [](const StageGraph::Node& node) {
+    return node.num_consumers;
+  });
+
+  auto compute_node = [this, &input, &nodes, &images, &results](std::size_t idx) {
+    const StageGraph::Node& node = nodes[idx];
+    std::vector<cv::Mat> node_inputs;
+    for (std::size_t input_idx : node.inputs)
     {
-      return false;
+      node_inputs.push_back(input_idx == StageGraph::INPUT_INDEX ? input : images[input_idx]);
     }
 
-    // interpolating to fill gaps
-    for (std::size_t i = 0; i < contours_indices.size(); i++)
+    if (node.combine == CombineOp::NONE)
     {
-      std::vector<cv::Point> interpolated_indices;
-      const std::vector<cv::Point>& indices = contours_indices[i];
-      interpolated_indices.push_back(indices.front());
-      for (std::size_t j = 1; j < indices.size(); j++)
-      {
-        const cv::Point& p1 = indices[j - 1];
-        const cv::Point& p2 = indices[j];
-
-        int x_coord_dist = std::abs(p2.x - p1.x);
-        int y_coord_dist = std::abs(p2.y - p1.y);
-        int max_coord_dist = x_coord_dist > y_coord_dist ? x_coord_dist : y_coord_dist;
-        if (max_coord_dist <= MIN_PIXEL_DISTANCE)
-        {
-          interpolated_indices.push_back(p2);
-          continue;
-        }
-        int num_elements = max_coord_dist + 1;
-        std::vector<int> x_coord = linspace<int>(p1.x, p2.x, num_elements);
-        std::vector<int> y_coord = linspace<int>(p1.y, p2.y, num_elements);
-        cv::Point p;
-        for (std::size_t k = 0; k < num_elements; k++)
-        {
-          std::tie(p.x, p.y) = std::make_tuple(x_coord[k], y_coord[k]);
-          interpolated_indices.push_back(p);
-        }
-      }
-      contours_indices[i] = interpolated_indices;
+      results[idx] = apply2dMethods(node.methods, node_inputs.front(), images[idx]);
+      return;
     }
 
-    // ============================== PCL 2D (pixel coordinates z= 0) =================================== //
-    // converting to cloud type for further analysis
-    std::vector<PointCloud<PointXYZ>> contours_indices_clouds_vec;
-    for (std::size_t i = 0; i < contours_indices.size(); i++)
+    std::string err_msg;
+    if (!StageGraph::combine(node.combine, node_inputs, images[idx], err_msg))
     {
-      pcl::PointCloud<pcl::PointXYZ> contour_indices_cloud;
-      contour_indices_cloud = convert2DContourToCloud(contours_indices[i]);
-      contours_indices_clouds_vec.push_back(contour_indices_cloud);
+      results[idx] = Result(false, boost::str(boost::format("Stage graph node %s failed: %s") % node.name % err_msg));
+      LOG4CXX_ERROR(logger_, results[idx].msg);
+      return;
     }
+    updateDebugWindow(images[idx]);
+  };
 
-    // downsampling
-    const RegionDetectionConfig::PCL2DCfg& pcl2d_cfg = cfg_->pcl_2d_cfg;
-    int search_radius_2d = 4;
-    for (std::size_t i = 0; i < contours_indices_clouds_vec.size(); i++)
+  for (const std::vector<std::size_t>& level : stage_graph_.getLevels())
+  {
+    // the nodes in a level are independent, debug windows can only be updated from the calling thread
+    if (cfg_->opencv_cfg.debug_mode_enable || level.size() == 1)
     {
-      if (pcl2d_cfg.downsampling_radius > 0)
-      {
-        dowsampleCloud(contours_indices_clouds_vec[i], pcl2d_cfg.downsampling_radius);
-      }
+      std::for_each(level.begin(), level.end(), compute_node);
     }
-
-    // sequence
-    for (std::size_t i = 0; i < contours_indices_clouds_vec.size(); i++)
+    else
     {
-      contours_indices_clouds_vec[i] = sequence(contours_indices_clouds_vec[i].makeShared());
+      std::vector<std::function<void()>> tasks;
+      for (std::size_t idx : level)
+      {
+        tasks.push_back(std::bind(compute_node, idx));
+      }
+      executor_->runAll(tasks);
     }
 
-    // split
-    std::vector<PointCloud<PointXYZ>::Ptr> contours_indices_cloud_vec;
-    for (std::size_t i = 0; i < contours_indices_clouds_vec.size(); i++)
+    for (std::size_t idx : level)
     {
-      std::vector<PointCloud<PointXYZ>::Ptr> temp_indices_cloud_vec =
-          split(contours_indices_clouds_vec[i], pcl2d_cfg.split_dist);
-      contours_indices_cloud_vec.insert(
-          contours_indices_cloud_vec.end(), temp_indices_cloud_vec.begin(), temp_indices_cloud_vec.end());
+      if (!results[idx])
+      {
+        return results[idx];
+      }
     }
 
-    // find closed curves
-    std::vector<PointCloud<PointXYZ>::Ptr> closed_indices_curves_vec, open_indices_curves_vec;
-    findClosedCurves(contours_indices_cloud_vec,
-                     pcl2d_cfg.closed_curve_max_dist,
-                     closed_indices_curves_vec,
-                     open_indices_curves_vec);
-
-    // simplification of closed curves
-    for (std::size_t i = 0; i < closed_indices_curves_vec.size(); i++)
+    // releasing the intermediate images no longer needed
+    for (std::size_t idx : level)
     {
-      int pre_simplified_size = closed_indices_curves_vec[i]->size();
-      if (pre_simplified_size < pcl2d_cfg.simplification_min_points)
+      for (std::size_t input_idx : nodes[idx].inputs)
       {
-        continue;
+        if (input_idx != StageGraph::INPUT_INDEX && --pending_consumers[input_idx] == 0)
+        {
+          images[input_idx].release();
+        }
       }
-      closed_indices_curves_vec[i] =
-          concaveHullSimplification(closed_indices_curves_vec[i], pcl2d_cfg.simplification_alpha);
-      LOG4CXX_DEBUG(logger_,
-                    "Concave hull simplified cloud from " << pre_simplified_size << " to "
-                                                          << closed_indices_curves_vec[i]->size());
-      *closed_indices_curves_vec[i] = sequence(closed_indices_curves_vec[i]->makeShared());
-      closed_indices_curves_vec[i]->push_back(closed_indices_curves_vec[i]->front());
     }
+  }
 
-    // combining closed and open back into single vec
-    contours_indices_cloud_vec.clear();
-    contours_indices_cloud_vec.insert(
-        contours_indices_cloud_vec.end(), closed_indices_curves_vec.begin(), closed_indices_curves_vec.end());
-    contours_indices_cloud_vec.insert(
-        contours_indices_cloud_vec.end(), open_indices_curves_vec.begin(), open_indices_curves_vec.end());
+  output = images[stage_graph_.getOutputIndex()];
+  return true;
+}
+
+bool RegionDetector::compute2d(cv::Mat input, cv::Mat& output) const
+{
+  return compute2dMask(input, output, nullptr);
+}
 
-    // converting to cv points
-    contours_indices.clear();
-    for (auto& cloud : contours_indices_cloud_vec)
+bool RegionDetector::compute2dMask(cv::Mat input, cv::Mat& output, BinaryImage* packed_output) const
+{
+  if (stage_2d_)
+  {
+    if (!stage_2d_(input, output))
     {
-      std::vector<cv::Point> temp_indices = convertCloudTo2DContour(*cloud);
-      contours_indices.push_back(temp_indices);
+      LOG4CXX_ERROR(logger_, "Custom 2d stage failed");
+      return false;
     }
+    updateDebugWindow(output);
+    return true;
+  }
+  if (!stage_graph_.empty())
+  {
+    return compute2dGraph(input, output);
+  }
+  return apply2dMethods(cfg_->opencv_cfg.methods, input, output, packed_output);
+}
 
-    // ============================== PCL 3D (x, y and z coordinates) =================================== //
-
-    // converting input cloud blob into point cloud of specified point type
-    pcl::PointCloud<pcl::PointXYZ>::Ptr input_cloud = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
-    pcl::fromPCLPointCloud2(data.cloud_blob, *input_cloud);
+bool RegionDetector::compute2d(cv::Mat input,
+                               cv::Mat& output,
+                               std::vector<std::vector<cv::Point>>& contours_indices) const
+{
+  return compute2dContours(input, contours_indices, output);
+}
 
-    // transform cloud
-    pcl::transformPointCloud(*input_cloud, *input_cloud, data.transform.cast<float>());
+RegionDetector::Result RegionDetector::computeBundleCurves(const DataBundle& data,
+                                                           DataBundle* owned_data,
+                                                           BundleCurves& curves,
+                                                           BundleCache* cache,
+                                                           const RegionCoverage* coverage,
+                                                           const ComputeMonitor& monitor)
+{
+  Result res;
+  auto canceled = [&monitor]() { return monitor.is_canceled && monitor.is_canceled(); };
+  if (canceled())
+  {
+    return Result(false, "Canceled");
+  }
 
-    // extract contours 3d points from 2d pixel locations
-    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> contours_points;
-    LOG4CXX_DEBUG(logger_, "Extracting contours from 3d data");
-    res = extractContoursFromCloud(contours_indices, input_cloud, contours_points);
-    if (!res)
+  // pixels that see the closed regions already found in the previous bundles
+  cv::Mat covered;
+  if (coverage && !coverage->empty())
+  {
+    const RegionDetectionConfig::CrossViewCfg& cross_view_cfg = cfg_->cross_view_cfg;
+    CloudPlanes planes;
+    if (planes.build(data.cloud_blob))
     {
-      LOG4CXX_ERROR(logger_, "Failed to extract 3d data");
-      return false;
+      planes.transform(data.transform);
+      covered = coverage->mask(planes, cross_view_cfg.max_plane_dist, cross_view_cfg.margin);
     }
-
-    // cleaning data
-    for (auto& contour : contours_points)
+    if (!covered.empty() && covered.size() != data.image.size())
     {
-      // removing nans
-      std::vector<int> nan_indices = {};
-      LOG4CXX_DEBUG(logger_, "NaN Removal");
-      contour->is_dense = false;
-      pcl::removeNaNFromPointCloud(*contour, *contour, nan_indices);
+      LOG4CXX_WARN(logger_, "Cloud and image sizes differ, the regions of the previous bundles are not masked out");
+      covered = cv::Mat();
+    }
+  }
 
-      // removing infinite
-      LOG4CXX_DEBUG(logger_, "Infinite Removal");
-      removeInfinite(*contour);
+  // in incremental mode the data is compared against the previous frame of the same bundle, and the config values each
+  // stage depends on against the ones used then
+  const RegionDetectionConfig::IncrementalCfg& incremental_cfg = cfg_->incremental_cfg;
+  const StageKeys keys = makeStageKeys(*cfg_);
+  bool use_cache = cache && cache->valid && cache->image.size() == data.image.size() &&
+                   cache->image.type() == data.image.type() && cache->transform.matrix() == data.transform.matrix();
+  std::vector<cv::Rect> changed_tiles;
+  bool cloud_changed = true;
+  if (use_cache)
+  {
+    changed_tiles =
+        findChangedTiles(cache->image, data.image, incremental_cfg.tile_size, incremental_cfg.image_threshold);
+    cloud_changed = cloudChanged(cache->cloud_blob, data.cloud_blob, incremental_cfg.depth_threshold);
+    if (changed_tiles.empty() && !cloud_changed && keys == cache->keys && sameMask(covered, cache->covered))
+    {
+      LOG4CXX_DEBUG(logger_, "Bundle data and config unchanged, reusing the previous curves");
+      curves = cache->curves.clone();
+      return true;
+    }
+  }
 
-      // statistical outlier removal
-      if (cfg_->pcl_cfg.stat_removal.enable)
-      {
-        LOG4CXX_DEBUG(logger_, "Statistical Outlier Removal");
-        pcl::StatisticalOutlierRemoval<pcl::PointXYZ> sor;
-        sor.setInputCloud(contour->makeShared());
-        sor.setMeanK(cfg_->pcl_cfg.stat_removal.kmeans);
-        sor.setStddevMulThresh(cfg_->pcl_cfg.stat_removal.stddev);
-        sor.filter(*contour);
-      }
+  cv::Mat mask;
+  BinaryImage packed_mask;
+  PixelCurves pixel_curves;
+  bool pixels_changed = true;
+  {
+    Executor::StageGuard stage_guard = executor_->acquireStage("2d");
+    std::chrono::steady_clock::time_point start_2d = std::chrono::steady_clock::now();
+    PerfCounters perf_2d(cfg_->output_cfg.perf_counters);
+    perf_2d.start();
 
-      /*    TODO:Disrupts the order of the points
-            if(cfg_->pcl_cfg.downsample_leaf_size > 0)
-            {
-              dowsampleCloud(*contour,cfg_->pcl_cfg.downsample_leaf_size);
-              *contour = sequence(contour->makeShared(),1e-5);
-            }*/
+    // ============================== Open CV =================================== //
+    LOG4CXX_DEBUG(logger_, "Computing 2d contours");
+    bool reuse_mask = use_cache && keys.mask == cache->keys.mask;
+    if (reuse_mask && changed_tiles.empty())
+    {
+      mask = cache->mask;
     }
-
-    LOG4CXX_DEBUG(logger_, "Computing normals");
-    std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr> contours_point_normals;
-    res = computeNormals(input_cloud, contours_points, contours_point_normals);
-    if (!res)
+    else
     {
-      return false;
+      res = reuse_mask ? computeIncremental2d(data.image, *cache, changed_tiles, mask) :
+                         Result(compute2dMask(data.image, mask, &packed_mask));
+      if (!res)
+      {
+        return res;
+      }
     }
 
-    // adding found closed contours
-    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> current_closed_contour_points;
-    current_closed_contour_points.assign(contours_points.begin(),
-                                         std::next(contours_points.begin(), closed_indices_curves_vec.size()));
-    for (pcl::PointCloud<pcl::PointXYZ>::Ptr cloud : current_closed_contour_points)
+    bool mask_changed = !use_cache || !sameMask(mask, cache->mask) || !sameMask(covered, cache->covered);
+    if (mask_changed || keys.mask != cache->keys.mask || keys.contours != cache->keys.contours)
     {
-      std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> split_clouds = split(*cloud, cfg_->pcl_cfg.split_dist);
-      if (split_clouds.size() == 1)
+      // the cached mask is kept whole so that the next call can update it incrementally
+      cv::Mat contour_mask = mask;
+      if (!covered.empty())
       {
-        // no split occurred so keeping as closed curve and copying first point to end in order to close the curve
-        cloud->push_back(cloud->front());
-        closed_contours_points.push_back(cloud);
+        LOG4CXX_DEBUG(logger_, "Masking out the regions found in the previous bundles");
+        contour_mask = mask.clone();
+        contour_mask.setTo(0, covered);
       }
-      else if (split_clouds.size() > 1)
+      res = compute2dCurves(contour_mask, pixel_curves, curves.image, covered.empty() ? &packed_mask : nullptr);
+      if (!res)
       {
-        // got splitted so inserting in open contours vector
-        open_contours_points.insert(open_contours_points.end(), split_clouds.begin(), split_clouds.end());
+        return res;
       }
-      else if (split_clouds.empty())
+    }
+    else
+    {
+      LOG4CXX_DEBUG(logger_, "2d output unchanged, reusing the previous contours");
+      pixel_curves = cache->pixel_curves;
+      curves.image = cache->curves.image;
+    }
+    pixels_changed = !use_cache || pixel_curves.num_closed != cache->pixel_curves.num_closed ||
+                     pixel_curves.contours != cache->pixel_curves.contours;
+    if (cfg_->output_cfg.contours)
+    {
+      curves.contours.clear();
+      curves.contours.reserve(pixel_curves.contours.size());
+      for (const ChainContour& contour : pixel_curves.contours)
       {
-        LOG4CXX_ERROR(logger_, "Splitting failed to return at least one curve");
-        return false;
+        curves.contours.push_back(contour.toPoints());
       }
     }
-
-    // adding open contours
-    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> current_open_contour_points;
-    current_open_contour_points.assign(std::next(contours_points.begin(), closed_indices_curves_vec.size()),
-                                       contours_points.end());
-    for (pcl::PointCloud<pcl::PointXYZ>::Ptr cloud : current_open_contour_points)
+    curves.durations["2d"] = secondsSince(start_2d);
+    if (perf_2d.isOpen())
     {
-      std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> split_clouds = split(*cloud, cfg_->pcl_cfg.split_dist);
-      open_contours_points.insert(open_contours_points.end(), split_clouds.begin(), split_clouds.end());
+      curves.counters["2d"] = perf_2d.stop();
     }
+  }
 
-    /*  TODO: Remove
-     *  if(!closed_indices_curves_vec.empty())
-        {
-          closed_contours_points.insert(closed_contours_points.end(),
-                                        contours_points.begin(),
-                                        std::next(contours_points.begin(),closed_indices_curves_vec.size()));
-        }
-
-        if(!open_indices_curves_vec.empty())
-        {
-          open_contours_points.insert(open_contours_points.end(),
-                                        std::next(contours_points.begin(),closed_indices_curves_vec.size()),
-                                        contours_points.end());
-        }*/
+  // ============================== PCL 3D (x, y and z coordinates) =================================== //
+  if (canceled())
+  {
+    return Result(false, "Canceled");
+  }
+  std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> points;
+  std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr> normals;
+  bool points_changed = pixels_changed || cloud_changed || keys.points != cache->keys.points;
+  if (!points_changed && keys.curves == cache->keys.curves)
+  {
+    LOG4CXX_DEBUG(logger_, "3d input and config unchanged, reusing the previous curves");
+    BundleCurves previous = cache->curves.clone();
+    curves.closed_curves = std::move(previous.closed_curves);
+    curves.closed_pixels = std::move(previous.closed_pixels);
+    curves.open_curves = std::move(previous.open_curves);
+    curves.normals = std::move(previous.normals);
+  }
+  else
+  {
+    Executor::StageGuard stage_guard = executor_->acquireStage("3d");
+    std::chrono::steady_clock::time_point start_3d = std::chrono::steady_clock::now();
+    PerfCounters perf_3d(cfg_->output_cfg.perf_counters);
+    perf_3d.start();
+    if (points_changed)
+    {
+      res = compute3dPoints(data, pixel_curves, points, normals);
+      if (!res)
+      {
+        return res;
+      }
+    }
+    else
+    {
+      LOG4CXX_DEBUG(logger_, "3d input unchanged, only splitting the previous points");
+      points = cache->points;
+      normals = cache->normals;
+    }
+
+    res = split3dCurves(points, pixel_curves, curves);
+    if (!res)
+    {
+      return res;
+    }
+
+    // the cached normals are kept apart from the ones handed out
+    for (const auto& cn : normals)
+    {
+      curves.normals.push_back(cache ? cn->makeShared() : cn);
+    }
+    curves.durations["3d"] = secondsSince(start_3d);
+    if (perf_3d.isOpen())
+    {
+      curves.counters["3d"] = perf_3d.stop();
+    }
+  }
+
+  if (cache)
+  {
+    cache->transform = data.transform;
+    // an image wrapping external memory (e.g. mapped shared memory) has no allocation and may not outlive the call
+    if (owned_data && owned_data->image.u)
+    {
+      cache->image = std::move(owned_data->image);
+    }
+    else
+    {
+      cache->image = data.image.clone();
+    }
+    if (owned_data)
+    {
+      cache->cloud_blob = std::move(owned_data->cloud_blob);
+    }
+    else
+    {
+      cache->cloud_blob = data.cloud_blob;
+    }
+    cache->mask = mask.clone();
+    cache->covered = covered;
+    cache->pixel_curves = pixel_curves;
+    if (points_changed)
+    {
+      cache->points = std::move(points);
+      cache->normals = std::move(normals);
+    }
+    cache->curves = curves.clone();
+    cache->keys = keys;
+    cache->valid = true;
+  }
+  return true;
+}
+
+RegionDetector::Result RegionDetector::compute2dCurves(const cv::Mat& mask,
+                                                       PixelCurves& pixel_curves,
+                                                       cv::Mat& output,
+                                                       const BinaryImage* packed_mask)
+{
+  using namespace pcl;
+  std::vector<std::vector<cv::Point>> contours_indices;
+  std::vector<PointCloud<PointXYZ>::Ptr> closed_indices_curves_vec, open_indices_curves_vec;
+  Result res = traceContours(mask, contours_indices, output, packed_mask);
+  if (!res)
+  {
+    return res;
+  }
+
+  // ============================== PCL 2D (pixel coordinates z= 0) =================================== //
+  // interpolating to fill gaps, straight into the cloud type used for further analysis
+  std::vector<PointCloud<PointXYZ>> contours_indices_clouds_vec(contours_indices.size());
+  for (std::size_t i = 0; i < contours_indices.size(); i++)
+  {
+    PointCloud<PointXYZ>& contour_indices_cloud = contours_indices_clouds_vec[i];
+    const std::vector<cv::Point>& indices = contours_indices[i];
+    contour_indices_cloud.reserve(indices.size());
+    addPixelToCloud(indices.front(), contour_indices_cloud);
+    for (std::size_t j = 1; j < indices.size(); j++)
+    {
+      const cv::Point& p1 = indices[j - 1];
+      const cv::Point& p2 = indices[j];
+
+      int x_coord_dist = std::abs(p2.x - p1.x);
+      int y_coord_dist = std::abs(p2.y - p1.y);
+      int max_coord_dist = x_coord_dist > y_coord_dist ? x_coord_dist : y_coord_dist;
+      if (max_coord_dist <= MIN_PIXEL_DISTANCE)
+      {
+        addPixelToCloud(p2, contour_indices_cloud);
+        continue;
+      }
+      int num_elements = max_coord_dist + 1;
+      std::vector<int> x_coord = linspace<int>(p1.x, p2.x, num_elements);
+      std::vector<int> y_coord = linspace<int>(p1.y, p2.y, num_elements);
+      for (std::size_t k = 0; k < num_elements; k++)
+      {
+        addPixelToCloud(cv::Point(x_coord[k], y_coord[k]), contour_indices_cloud);
+      }
+    }
+  }
+  contours_indices.clear();
+
+  // downsampling, the skeleton branches are already ordered so they are only thinned out along their length
+  const RegionDetectionConfig::PCL2DCfg& pcl2d_cfg = cfg_->pcl_2d_cfg;
+  const bool ordered = tracesSkeleton(mask);
+  for (std::size_t i = 0; i < contours_indices_clouds_vec.size(); i++)
+  {
+    if (pcl2d_cfg.downsampling_radius > 0)
+    {
+      if (ordered)
+      {
+        decimateOrderedCloud(contours_indices_clouds_vec[i], pcl2d_cfg.downsampling_radius);
+      }
+      else
+      {
+        dowsampleCloud(contours_indices_clouds_vec[i], pcl2d_cfg.downsampling_radius);
+      }
+    }
+  }
+
+  // sequence
+  for (std::size_t i = 0; i < contours_indices_clouds_vec.size() && !ordered; i++)
+  {
+    contours_indices_clouds_vec[i] = sequence(contours_indices_clouds_vec[i].makeShared());
+  }
+
+  // split
+  std::vector<PointCloud<PointXYZ>::Ptr> contours_indices_cloud_vec;
+  for (std::size_t i = 0; i < contours_indices_clouds_vec.size(); i++)
+  {
+    std::vector<PointCloud<PointXYZ>::Ptr> temp_indices_cloud_vec =
+        split(contours_indices_clouds_vec[i], pcl2d_cfg.split_dist);
+    contours_indices_cloud_vec.insert(
+        contours_indices_cloud_vec.end(), temp_indices_cloud_vec.begin(), temp_indices_cloud_vec.end());
+  }
+
+  // find closed curves
+  findClosedCurves(contours_indices_cloud_vec,
+                   pcl2d_cfg.closed_curve_max_dist,
+                   closed_indices_curves_vec,
+                   open_indices_curves_vec);
+
+  // simplification of closed curves
+  for (std::size_t i = 0; i < closed_indices_curves_vec.size(); i++)
+  {
+    int pre_simplified_size = closed_indices_curves_vec[i]->size();
+    if (pre_simplified_size < pcl2d_cfg.simplification_min_points)
+    {
+      continue;
+    }
+    closed_indices_curves_vec[i] =
+        concaveHullSimplification(closed_indices_curves_vec[i], pcl2d_cfg.simplification_alpha);
+    LOG4CXX_DEBUG(logger_,
+                  "Concave hull simplified cloud from " << pre_simplified_size << " to "
+                                                        << closed_indices_curves_vec[i]->size());
+    *closed_indices_curves_vec[i] = sequence(closed_indices_curves_vec[i]->makeShared());
+    closed_indices_curves_vec[i]->push_back(closed_indices_curves_vec[i]->front());
+  }
+
+  // combining closed and open back into single vec
+  contours_indices_cloud_vec.clear();
+  contours_indices_cloud_vec.insert(
+      contours_indices_cloud_vec.end(), closed_indices_curves_vec.begin(), closed_indices_curves_vec.end());
+  contours_indices_cloud_vec.insert(
+      contours_indices_cloud_vec.end(), open_indices_curves_vec.begin(), open_indices_curves_vec.end());
+
+  // encoding as chain codes, the 3d stage decodes them while sampling the cloud
+  pixel_curves.contours.clear();
+  pixel_curves.contours.reserve(contours_indices_cloud_vec.size());
+  for (auto& cloud : contours_indices_cloud_vec)
+  {
+    pixel_curves.contours.push_back(convertCloudToChainContour(*cloud));
+  }
+  pixel_curves.num_closed = closed_indices_curves_vec.size();
+  return true;
+}
+
+bool RegionDetector::tracesSkeleton(const cv::Mat& mask) const
+{
+  const RegionDetectionConfig::OpenCVCfg& opencv_cfg = cfg_->opencv_cfg;
+  if (!opencv_cfg.contour.trace_skeleton || mask.type() != CV_8UC1)
+  {
+    return false;
+  }
+
+  // the methods producing the mask are those of the custom stage, or of the output node when a stage graph is used
+  const std::vector<std::string>* methods = &opencv_cfg.methods;
+  if (stage_2d_)
+  {
+    methods = &stage_2d_methods_;
+  }
+  else if (!opencv_cfg.graph.nodes.empty())
+  {
+    auto output_node = std::find_if(opencv_cfg.graph.nodes.begin(),
+                                    opencv_cfg.graph.nodes.end(),
+                                    [&opencv_cfg](const config_2d::StageNodeCfg& node) {
+                                      return node.name == opencv_cfg.graph.output;
+                                    });
+    if (output_node == opencv_cfg.graph.nodes.end())
+    {
+      return false;
+    }
+    methods = &output_node->methods;
+  }
+  return !methods->empty() && methods->back() == "THINNING";
+}
+
+RegionDetector::Result RegionDetector::computeIncremental2d(const cv::Mat& image,
+                                                            const BundleCache& cache,
+                                                            const std::vector<cv::Rect>& changed_tiles,
+                                                            cv::Mat& mask) const
+{
+  int halo = get2dHalo();
+  if (halo < 0)
+  {
+    return compute2d(image, mask);
+  }
+
+  // a change spreads up to a halo out of its tile through the morphological kernels, so the tile grown by the halo is
+  // updated and the 2d methods are rerun on the tile grown by twice the halo, which holds all the pixels it depends on
+  cv::Mat updated_mask = cache.mask.clone();
+  const cv::Rect image_rect(0, 0, image.cols, image.rows);
+  auto grow = [&image_rect](const cv::Rect& rect, int margin) {
+    return cv::Rect(rect.x - margin, rect.y - margin, rect.width + 2 * margin, rect.height + 2 * margin) & image_rect;
+  };
+  for (const cv::Rect& tile : changed_tiles)
+  {
+    cv::Rect updated = grow(tile, halo);
+    cv::Rect roi = grow(tile, 2 * halo);
+    cv::Mat tile_mask;
+    if (!compute2d(image(roi).clone(), tile_mask))
+    {
+      return Result(false, "Failed to compute the 2d methods on a changed tile");
+    }
+
+    if (tile_mask.size() != roi.size() || tile_mask.type() != updated_mask.type())
+    {
+      return compute2d(image, mask);
+    }
+    tile_mask(updated - roi.tl()).copyTo(updated_mask(updated));
+  }
+  mask = updated_mask;
+  return true;
+}
+
+int RegionDetector::get2dHalo() const
+{
+  // nothing is known about the reach of a custom 2d stage
+  if (stage_2d_)
+  {
+    return -1;
+  }
+
+  std::vector<std::string> methods = cfg_->opencv_cfg.methods;
+  if (!stage_graph_.empty())
+  {
+    methods.clear();
+    for (const StageGraph::Node& node : stage_graph_.getNodes())
+    {
+      methods.insert(methods.end(), node.methods.begin(), node.methods.end());
+    }
+  }
+
+  int halo = 0;
+  for (const std::string& method_name : methods)
+  {
+    if (METHOD_CODES_MAPPINGS.count(method_name) == 0)
+    {
+      continue;
+    }
+
+    switch (METHOD_CODES_MAPPINGS.at(method_name))
+    {
+      case Methods2D::GRAYSCALE:
+      case Methods2D::INVERT:
+      case Methods2D::RANGE:
+      case Methods2D::HSV:
+        break;
+      case Methods2D::THRESHOLD:
+        // otsu and triangle pick the threshold from the histogram of the whole image
+        if (cfg_->opencv_cfg.threshold.type & (cv::THRESH_OTSU | cv::THRESH_TRIANGLE))
+        {
+          return -1;
+        }
+        break;
+      case Methods2D::DILATION:
+        halo += cfg_->opencv_cfg.dilation.kernel_size;
+        break;
+      case Methods2D::EROSION:
+        halo += cfg_->opencv_cfg.erosion.kernel_size;
+        break;
+      default:
+        // histogram equalization, canny hysteresis and thinning depend on the whole image
+        return -1;
+    }
+  }
+  return halo;
+}
+
+RegionDetector::Result
+RegionDetector::compute3dPoints(const DataBundle& data,
+                                const PixelCurves& pixel_curves,
+                                std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& contours_points,
+                                std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr>& normals)
+{
+  if (cfg_->pcl_cfg.normal_est.method == "organized")
+  {
+    return computeOrganized3dPoints(data, pixel_curves, contours_points, normals);
+  }
+
+  Result res;
+
+  // converting input cloud blob into point cloud of specified point type
+  pcl::PointCloud<pcl::PointXYZ>::Ptr input_cloud = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+  CloudPlanes planes;
+  if (planes.build(data.cloud_blob))
+  {
+    // float coordinates are transformed as separate planes before being interleaved
+    planes.transform(data.transform);
+    planes.toPointCloud(*input_cloud);
+    input_cloud->header = data.cloud_blob.header;
+  }
+  else
+  {
+    pcl::fromPCLPointCloud2(data.cloud_blob, *input_cloud);
+    pcl::transformPointCloud(*input_cloud, *input_cloud, data.transform.cast<float>());
+  }
+
+  // extract contours 3d points from 2d pixel locations
+  contours_points.clear();
+  normals.clear();
+  LOG4CXX_DEBUG(logger_, "Extracting contours from 3d data");
+  res = extractContoursFromCloud(pixel_curves.contours, input_cloud, contours_points);
+  if (!res)
+  {
+    LOG4CXX_ERROR(logger_, "Failed to extract 3d data");
+    return res;
+  }
+
+  // cleaning data
+  LOG4CXX_DEBUG(logger_, "Removing NaN, infinite and outlier points");
+  for (auto& contour : contours_points)
+  {
+    cleanCurve(*contour, cfg_->pcl_cfg.stat_removal);
+
+    /*    TODO:Disrupts the order of the points
+          if(cfg_->pcl_cfg.downsample_leaf_size > 0)
+          {
+            dowsampleCloud(*contour,cfg_->pcl_cfg.downsample_leaf_size);
+            *contour = sequence(contour->makeShared(),1e-5);
+          }*/
+  }
+
+  // the normals are only used by the poses
+  const RegionDetectionConfig::OutputCfg& output_cfg = cfg_->output_cfg;
+  if (output_cfg.normals || output_cfg.closed_regions || output_cfg.open_regions)
+  {
+    LOG4CXX_DEBUG(logger_, "Computing normals");
+    res = computeNormals(input_cloud, contours_points, normals);
+    if (!res)
+    {
+      return res;
+    }
+  }
+
+  // cleaning point normals
+  cleanNormals(normals);
+
+  return true;
+}
+
+RegionDetector::Result
+RegionDetector::computeOrganized3dPoints(const DataBundle& data,
+                                         const PixelCurves& pixel_curves,
+                                         std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& contours_points,
+                                         std::vector<pcl::PointCloud<pcl::PointNormal>::Ptr>& normals)
+{
+  // the points are sampled from the tiled cloud and the normal windows read from the planes, the blob is not
+  // converted into a pcl cloud
+  CloudPlanes planes;
+  TiledCloud tiled_cloud;
+  bool built = planes.build(data.cloud_blob);
+  if (built)
+  {
+    planes.transform(data.transform);
+    built = tiled_cloud.build(planes);
+  }
+  if (!built)
+  {
+    std::string err_msg = "Point Cloud not organized or without float x, y and z fields";
+    LOG4CXX_ERROR(logger_, err_msg)
+    return Result(false, err_msg);
+  }
+
+  const RegionDetectionConfig::OutputCfg& output_cfg = cfg_->output_cfg;
+  const bool with_normals = output_cfg.normals || output_cfg.closed_regions || output_cfg.open_regions;
+  contours_points.clear();
+  normals.clear();
+  if (pixel_curves.contours.empty())
+  {
+    std::string err_msg = "Input contour indices vector is empty";
+    LOG4CXX_ERROR(logger_, err_msg)
+    return Result(false, err_msg);
+  }
+
+  LOG4CXX_DEBUG(logger_, "Extracting contours and window normals from the organized cloud");
+  for (const ChainContour& indices : pixel_curves.contours)
+  {
+    if (indices.empty())
+    {
+      std::string err_msg = "Empty indices vector was passed";
+      LOG4CXX_ERROR(logger_, err_msg)
+      return Result(false, err_msg);
+    }
+
+    pcl::PointCloud<pcl::PointNormal>::Ptr curve = boost::make_shared<pcl::PointCloud<pcl::PointNormal>>();
+    curve->reserve(indices.size());
+    ChainContour::Decoder decoder(indices);
+    cv::Point idx;
+    while (decoder.next(idx))
+    {
+      if (idx.x < 0 || idx.y < 0 || idx.x >= tiled_cloud.width() || idx.y >= tiled_cloud.height())
+      {
+        std::string err_msg = "2D indices exceed point cloud size";
+        LOG4CXX_ERROR(logger_, err_msg)
+        return Result(false, err_msg);
+      }
+      const TiledCloud::Point& p = tiled_cloud.at(idx.x, idx.y);
+      pcl::PointNormal pn;
+      pn.x = p.x;
+      pn.y = p.y;
+      pn.z = p.z;
+      pn.normal_x = pn.normal_y = pn.normal_z = pn.curvature = 0.0f;
+      if (with_normals)
+      {
+        estimateWindowNormal(planes, idx.x, idx.y, cfg_->pcl_cfg.normal_est, pn);
+      }
+      curve->push_back(pn);
+    }
+
+    cleanCurve(*curve, cfg_->pcl_cfg.stat_removal);
+    pcl::PointCloud<pcl::PointXYZ>::Ptr curve_points = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+    pcl::copyPointCloud(*curve, *curve_points);
+    contours_points.push_back(curve_points);
+    if (with_normals)
+    {
+      normals.push_back(curve);
+    }
+  }
+
+  cleanNormals(normals);
+  return true;
+}
+
+RegionDetector::Result RegionDetector::split3dCurves(const std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& points,
+                                                     const PixelCurves& pixel_curves,
+                                                     BundleCurves& curves)
+{
+  // adding found closed contours
+  const std::size_t num_closed = pixel_curves.num_closed;
+  for (std::size_t i = 0; i < num_closed; i++)
+  {
+    const pcl::PointCloud<pcl::PointXYZ>::Ptr& cloud = points[i];
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> split_clouds = split(*cloud, cfg_->pcl_cfg.split_dist);
+    if (split_clouds.size() == 1)
+    {
+      // no split occurred so keeping a copy as closed curve and copying first point to end in order to close the curve
+      pcl::PointCloud<pcl::PointXYZ>::Ptr closed_curve = cloud->makeShared();
+      closed_curve->push_back(closed_curve->front());
+      curves.closed_curves.push_back(closed_curve);
+      curves.closed_pixels.push_back(pixel_curves.contours[i].toPoints());
+    }
+    else if (split_clouds.size() > 1)
+    {
+      // got splitted so inserting in open contours vector
+      curves.open_curves.insert(curves.open_curves.end(), split_clouds.begin(), split_clouds.end());
+    }
+    else if (split_clouds.empty())
+    {
+      std::string err_msg = "Splitting failed to return at least one curve";
+      LOG4CXX_ERROR(logger_, err_msg);
+      return Result(false, err_msg);
+    }
+  }
+
+  // adding open contours
+  std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> current_open_contour_points;
+  current_open_contour_points.assign(std::next(points.begin(), num_closed), points.end());
+  for (pcl::PointCloud<pcl::PointXYZ>::Ptr cloud : current_open_contour_points)
+  {
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> split_clouds = split(*cloud, cfg_->pcl_cfg.split_dist);
+    curves.open_curves.insert(curves.open_curves.end(), split_clouds.begin(), split_clouds.end());
+  }
+
+  return true;
+}
+
+RegionDetector::BundleCurves RegionDetector::BundleCurves::clone() const
+{
+  BundleCurves copy;
+  copy.image = image;
+  copy.contours = contours;
+  copy.closed_pixels = closed_pixels;
+  copy.durations = durations;
+  copy.counters = counters;
+  auto clone_clouds = [](const auto& clouds, auto& copies) {
+    for (const auto& cloud : clouds)
+    {
+      copies.push_back(cloud->makeShared());
+    }
+  };
+  clone_clouds(closed_curves, copy.closed_curves);
+  clone_clouds(open_curves, copy.open_curves);
+  clone_clouds(normals, copy.normals);
+  return copy;
+}
+
+void RegionDetector::RegionResults::clear()
+{
+  closed_regions_poses.clear();
+  open_regions_poses.clear();
+  closed_regions_info.clear();
+  images.clear();
+  contours.clear();
+  succeeded = false;
+  err_msg.clear();
+  for (auto& kv : stage_stats)
+  {
+    kv.second.durations.clear();
+    kv.second.counters.clear();
+  }
+}
+
+/**
+ * @brief appends the hardware counts of a stage sample to its stats
+ */
+static void addCounters(const PerfCounters::Counts& counts, RegionDetector::StageStats& stats)
+{
+  for (const auto& kv : counts)
+  {
+    stats.counters[kv.first].push_back(kv.second);
+  }
+}
+
+/**
+ * @brief adds the image, contours and timing of a bundle to the results, they are moved when the curves are owned
+ */
+static void addBundleResults(const RegionDetector::BundleCurves& curves,
+                             RegionDetector::BundleCurves* owned_curves,
+                             const RegionDetectionConfig::OutputCfg& output_cfg,
+                             RegionDetector::RegionResults& regions)
+{
+  if (output_cfg.images)
+  {
+    regions.images.push_back(owned_curves ? std::move(owned_curves->image) : curves.image);
+  }
+  if (output_cfg.contours)
+  {
+    regions.contours.push_back(owned_curves ? std::move(owned_curves->contours) : curves.contours);
+  }
+  for (const auto& kv : curves.durations)
+  {
+    regions.stage_stats[kv.first].durations.push_back(kv.second);
+  }
+  for (const auto& kv : curves.counters)
+  {
+    addCounters(kv.second, regions.stage_stats[kv.first]);
+  }
+}
 
-    // adding point normals
-    for (auto& cn : contours_point_normals)
+bool RegionDetector::compute(const RegionDetector::DataBundleVec& input,
+                             RegionDetector::RegionResults& regions,
+                             const ComputeMonitor& monitor)
+{
+  return compute(input, nullptr, regions, monitor);
+}
+
+bool RegionDetector::compute(RegionDetector::DataBundleVec&& input,
+                             RegionDetector::RegionResults& regions,
+                             const ComputeMonitor& monitor)
+{
+  return compute(input, &input, regions, monitor);
+}
+
+RegionDetector::RegionResults RegionDetector::compute(RegionDetector::DataBundleVec&& input,
+                                                      const ComputeMonitor& monitor)
+{
+  RegionResults regions;
+  compute(input, &input, regions, monitor);
+  return regions;
+}
+
+bool RegionDetector::compute(const RegionDetector::DataBundleVec& input,
+                             RegionDetector::DataBundleVec* owned_input,
+                             RegionDetector::RegionResults& regions,
+                             const ComputeMonitor& monitor)
+{
+  // the curves are always owned here so their images and contours are moved into the results
+  std::vector<BundleCurves> bundles_curves;
+  std::string err_msg;
+  if (!computeCurves(input, owned_input, bundles_curves, monitor, &err_msg))
+  {
+    // the timing of the bundles is still reported
+    regions.clear();
+    for (BundleCurves& bundle_curves : bundles_curves)
     {
-      std::vector<int> removed_indices;
-      cn->is_dense = false;
-      pcl::removeNaNNormalsFromPointCloud(*cn, *cn, removed_indices);
-      removeInfinite(*cn);
-      (*normals) += *cn;
+      addBundleResults(bundle_curves, &bundle_curves, cfg_->output_cfg, regions);
+    }
+    regions.err_msg = err_msg;
+    return false;
+  }
+  return computeRegions(bundles_curves, &bundles_curves, regions, monitor);
+}
+
+bool RegionDetector::computeCurves(const DataBundleVec& input,
+                                   std::vector<BundleCurves>& curves,
+                                   const ComputeMonitor& monitor)
+{
+  return computeCurves(input, nullptr, curves, monitor);
+}
+
+bool RegionDetector::computeCurves(DataBundleVec&& input,
+                                   std::vector<BundleCurves>& curves,
+                                   const ComputeMonitor& monitor)
+{
+  return computeCurves(input, &input, curves, monitor);
+}
+
+bool RegionDetector::computeCurves(const DataBundleVec& input,
+                                   DataBundleVec* owned_input,
+                                   std::vector<BundleCurves>& curves,
+                                   const ComputeMonitor& monitor,
+                                   std::string* err_msg)
+{
+  if (monitor.on_stage)
+  {
+    monitor.on_stage("curves");
+  }
+
+  // computing the curves of each bundle, the debug windows can only be updated from the calling thread
+  std::vector<BundleCurves>& bundles_curves = curves;
+  bundles_curves.assign(input.size(), BundleCurves());
+  std::vector<Result> bundles_results(input.size());
+  window_counter_ = 0;
+
+  // each bundle keeps its own cache so that they can be updated concurrently
+  if (cfg_->incremental_cfg.enable)
+  {
+    bundle_caches_.resize(input.size());
+  }
+  else
+  {
+    bundle_caches_.clear();
+  }
+  auto get_cache = [this](std::size_t i) -> BundleCache* {
+    return i < bundle_caches_.size() ? &bundle_caches_[i] : nullptr;
+  };
+
+  // with the cross view masking the closed regions of each bundle are masked out of the following ones
+  const bool cross_view = cfg_->cross_view_cfg.enable && input.size() > 1;
+  RegionCoverage coverage;
+  const RegionCoverage* bundles_coverage = cross_view ? &coverage : nullptr;
+
+  // the closed curves of a bundle are only dropped by the deduplication against the bundles before it, so once those
+  // are done its regions go through the same deduplication, simplification and filtering as in computeRegions
+  const bool stream_regions = monitor.on_closed_region && cfg_->output_cfg.closed_regions;
+  const bool dedup = cfg_->pcl_cfg.dedup.enable && input.size() > 1;
+  CurveVoxels stream_voxels(dedup ? cfg_->pcl_cfg.dedup.voxel_size : 1.0);
+  auto select_closed_regions = [this, &stream_voxels, dedup](std::size_t i, const BundleCurves& bundle_curves) {
+    std::vector<bool> covered;
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> regions_points;
+    for (const pcl::PointCloud<pcl::PointXYZ>::Ptr& curve : bundle_curves.closed_curves)
+    {
+      if (dedup)
+      {
+        if (stream_voxels.coveredFraction(*curve, i, covered) >= cfg_->pcl_cfg.dedup.min_overlap)
+        {
+          continue;
+        }
+        stream_voxels.add(*curve, i);
+      }
+      pcl::PointCloud<pcl::PointXYZ>::Ptr simplified =
+          simplifyByMinimunLength({ curve }, cfg_->pcl_cfg.simplification_min_dist).front();
+      if (simplified->size() >= static_cast<std::size_t>(cfg_->pcl_cfg.min_num_points))
+      {
+        regions_points.push_back(simplified);
+      }
+    }
+    return regions_points;
+  };
+
+  // the selection follows the bundle order under the lock, the poses are computed outside of it and the calls are
+  // then made in bundle order
+  std::mutex stream_mutex;
+  std::condition_variable stream_cv;
+  std::vector<bool> bundles_done(input.size(), false);
+  std::size_t next_stream = 0;
+  std::size_t next_call = 0;
+  bool stream_stopped = false;
+  auto stream_bundle = [&](std::size_t i) {
+    std::vector<std::pair<std::size_t, std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>>> selected;
+    {
+      std::lock_guard<std::mutex> lock(stream_mutex);
+      bundles_done[i] = true;
+      while (!stream_stopped && next_stream < input.size() && bundles_done[next_stream])
+      {
+        std::size_t b = next_stream++;
+        if (!bundles_results[b] || (monitor.is_canceled && monitor.is_canceled()))
+        {
+          // the computation fails as a whole
+          stream_stopped = true;
+          break;
+        }
+        selected.emplace_back(b, select_closed_regions(b, bundles_curves[b]));
+      }
+    }
+
+    for (auto& bundle_regions : selected)
+    {
+      const std::size_t b = bundle_regions.first;
+      pcl::PointCloud<pcl::PointNormal>::Ptr normals = boost::make_shared<pcl::PointCloud<pcl::PointNormal>>();
+      for (const auto& cn : bundles_curves[b].normals)
+      {
+        (*normals) += *cn;
+      }
+      std::vector<EigenPose3dVector> regions_poses;
+      if (!bundle_regions.second.empty() && !normals->empty() &&
+          !computePoses(normals, bundle_regions.second, regions_poses))
+      {
+        // these regions are only in the results
+        regions_poses.clear();
+      }
+
+      // every selected bundle takes its turn so that the ones after it are not blocked
+      std::unique_lock<std::mutex> lock(stream_mutex);
+      stream_cv.wait(lock, [&next_call, b]() { return next_call == b; });
+      for (const EigenPose3dVector& poses : regions_poses)
+      {
+        monitor.on_closed_region(b, poses);
+      }
+      next_call++;
+      stream_cv.notify_all();
+    }
+  };
+
+  auto run_bundle = [this, &input, owned_input, &bundles_curves, &bundles_results, &get_cache, bundles_coverage,
+                     &monitor, stream_regions, &stream_bundle](std::size_t i) {
+    DataBundle* owned_data = owned_input ? &(*owned_input)[i] : nullptr;
+    bundles_results[i] =
+        computeBundleCurves(input[i], owned_data, bundles_curves[i], get_cache(i), bundles_coverage, monitor);
+    if (bundles_results[i] && monitor.on_bundle_curves)
+    {
+      monitor.on_bundle_curves(i, bundles_curves[i]);
+    }
+    if (stream_regions)
+    {
+      stream_bundle(i);
+    }
+  };
+
+  // a single bundle runs on the calling thread so that the branches of the stage graph can be dispatched to the workers,
+  // tasks submitted from a worker run inline
+  if (cfg_->opencv_cfg.debug_mode_enable || cross_view || input.size() == 1)
+  {
+    for (std::size_t i = 0; i < input.size(); i++)
+    {
+      window_counter_++;
+      run_bundle(i);
+      if (!bundles_results[i])
+      {
+        break;
+      }
+      if (cross_view)
+      {
+        for (const auto& closed_curve : bundles_curves[i].closed_curves)
+        {
+          coverage.addRegion(*closed_curve);
+        }
+      }
+    }
+  }
+  else
+  {
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(input.size());
+    for (std::size_t i = 0; i < input.size(); i++)
+    {
+      tasks.push_back([&run_bundle, i]() { run_bundle(i); });
+    }
+    executor_->runAll(tasks);
+  }
+
+  for (std::size_t i = 0; i < input.size(); i++)
+  {
+    if (!bundles_results[i])
+    {
+      std::string msg = "Bundle " + std::to_string(i) + " failed: " + bundles_results[i].msg;
+      LOG4CXX_ERROR(logger_, msg);
+      if (err_msg)
+      {
+        *err_msg = msg;
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RegionDetector::computeRegions(const std::vector<BundleCurves>& curves,
+                                    RegionDetector::RegionResults& regions,
+                                    const ComputeMonitor& monitor)
+{
+  return computeRegions(curves, nullptr, regions, monitor);
+}
+
+bool RegionDetector::computeRegions(std::vector<BundleCurves>&& curves,
+                                    RegionDetector::RegionResults& regions,
+                                    const ComputeMonitor& monitor)
+{
+  return computeRegions(curves, &curves, regions, monitor);
+}
+
+bool RegionDetector::computeRegions(const std::vector<BundleCurves>& curves,
+                                    std::vector<BundleCurves>* owned_curves,
+                                    RegionDetector::RegionResults& regions,
+                                    const ComputeMonitor& monitor)
+{
+  auto start_stage = [&monitor](const std::string& stage) -> bool {
+    if (monitor.is_canceled && monitor.is_canceled())
+    {
+      return false;
+    }
+    if (monitor.on_stage)
+    {
+      monitor.on_stage(stage);
+    }
+    return true;
+  };
+
+  using namespace pcl;
+  const RegionDetectionConfig::OutputCfg& output_cfg = cfg_->output_cfg;
+  const bool compute_poses = output_cfg.closed_regions || output_cfg.open_regions;
+  std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> closed_contours_points, open_contours_points;
+  std::vector<int> closed_bundles, open_bundles;
+
+  // the closed curves of the bundles are followed through the merge for their pixels and streamed poses
+  struct ClosedSource
+  {
+    int bundle = -1;
+    const std::vector<cv::Point>* pixels = nullptr;
+  };
+  std::vector<ClosedSource> closed_sources;
+  pcl::PointCloud<pcl::PointNormal>::Ptr normals = boost::make_shared<pcl::PointCloud<pcl::PointNormal>>();
+
+  // collecting in the same order as the input, the merge does not modify the bundle curves
+  Result res;
+  regions.clear();
+  for (std::size_t i = 0; i < curves.size(); i++)
+  {
+    const BundleCurves& bundle_curves = curves[i];
+    addBundleResults(bundle_curves, owned_curves ? &(*owned_curves)[i] : nullptr, output_cfg, regions);
+
+    closed_contours_points.insert(
+        closed_contours_points.end(), bundle_curves.closed_curves.begin(), bundle_curves.closed_curves.end());
+    open_contours_points.insert(
+        open_contours_points.end(), bundle_curves.open_curves.begin(), bundle_curves.open_curves.end());
+    closed_bundles.resize(closed_contours_points.size(), static_cast<int>(i));
+    open_bundles.resize(open_contours_points.size(), static_cast<int>(i));
+    for (std::size_t k = 0; k < bundle_curves.closed_curves.size(); k++)
+    {
+      ClosedSource source;
+      source.bundle = static_cast<int>(i);
+      source.pixels = k < bundle_curves.closed_pixels.size() ? &bundle_curves.closed_pixels[k] : nullptr;
+      closed_sources.push_back(source);
+    }
+
+    // adding point normals, they are only used by the poses
+    if (compute_poses)
+    {
+      for (auto& cn : bundle_curves.normals)
+      {
+        (*normals) += *cn;
+      }
     }
   }
 
   // combining open curves to form closed ones
+  if (!start_stage("merge"))
+  {
+    regions.err_msg = "Canceled before merging the curves";
+    LOG4CXX_INFO(logger_, "Region detection canceled before merging the curves");
+    return false;
+  }
+  std::chrono::steady_clock::time_point start_merge = std::chrono::steady_clock::now();
+  PerfCounters perf_merge(output_cfg.perf_counters);
+  perf_merge.start();
+  if (cfg_->pcl_cfg.dedup.enable && curves.size() > 1)
+  {
+    std::vector<std::size_t> closed_kept;
+    std::size_t num_dropped = deduplicateCurves(
+        closed_contours_points, closed_bundles, open_contours_points, open_bundles, cfg_->pcl_cfg.dedup, closed_kept);
+    for (std::size_t k = 0; k < closed_kept.size(); k++)
+    {
+      closed_sources[k] = closed_sources[closed_kept[k]];
+    }
+    closed_sources.resize(closed_kept.size());
+    LOG4CXX_DEBUG(logger_, "Fused " << num_dropped << " curves already found in other bundles");
+  }
   std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> closed_curves_points, open_curves_points;
   LOG4CXX_DEBUG(logger_, "Computing closed contours from " << open_contours_points.size() << " open curves");
   res = combineIntoClosedRegions(open_contours_points, closed_curves_points, open_curves_points);
@@ -1105,17 +2911,30 @@ bool RegionDetector::compute(const RegionDetector::DataBundleVec& input, RegionD
   closed_contours_points.insert(closed_contours_points.end(), closed_curves_points.begin(), closed_curves_points.end());
   open_contours_points = open_curves_points;
 
-  // simplifying by length
+  // the curves closed by the merge have no source
+  closed_sources.resize(closed_contours_points.size());
+
+  // simplifying by length, the open curves are only kept for their poses
+  if (!output_cfg.open_regions)
+  {
+    open_contours_points.clear();
+  }
   closed_contours_points = simplifyByMinimunLength(closed_contours_points, cfg_->pcl_cfg.simplification_min_dist);
   open_contours_points = simplifyByMinimunLength(open_contours_points, cfg_->pcl_cfg.simplification_min_dist);
 
   // filter out those with too few points
-  closed_contours_points.erase(std::remove_if(closed_contours_points.begin(),
-                                              closed_contours_points.end(),
-                                              [this](pcl::PointCloud<pcl::PointXYZ>::Ptr& c) {
-                                                return c->size() < cfg_->pcl_cfg.min_num_points;
-                                              }),
-                               closed_contours_points.end());
+  std::size_t num_kept = 0;
+  for (std::size_t i = 0; i < closed_contours_points.size(); i++)
+  {
+    if (closed_contours_points[i]->size() >= static_cast<std::size_t>(cfg_->pcl_cfg.min_num_points))
+    {
+      closed_contours_points[num_kept] = closed_contours_points[i];
+      closed_sources[num_kept] = closed_sources[i];
+      num_kept++;
+    }
+  }
+  closed_contours_points.resize(num_kept);
+  closed_sources.resize(num_kept);
 
   open_contours_points.erase(std::remove_if(open_contours_points.begin(),
                                             open_contours_points.end(),
@@ -1123,22 +2942,67 @@ bool RegionDetector::compute(const RegionDetector::DataBundleVec& input, RegionD
                                               return c->size() < cfg_->pcl_cfg.min_num_points;
                                             }),
                              open_contours_points.end());
+  regions.stage_stats["merge"].durations.push_back(secondsSince(start_merge));
+  if (perf_merge.isOpen())
+  {
+    addCounters(perf_merge.stop(), regions.stage_stats["merge"]);
+  }
 
-  LOG4CXX_DEBUG(logger_, "Computing curves normals");
-  computePoses(normals, open_contours_points, regions.open_regions_poses);
-  computePoses(normals, closed_contours_points, regions.closed_regions_poses);
+  if (!start_stage("poses"))
+  {
+    regions.err_msg = "Canceled before computing the poses";
+    LOG4CXX_INFO(logger_, "Region detection canceled before computing the poses");
+    return false;
+  }
+  if (compute_poses)
+  {
+    LOG4CXX_DEBUG(logger_, "Computing curves normals");
+    std::chrono::steady_clock::time_point start_poses = std::chrono::steady_clock::now();
+    PerfCounters perf_poses(output_cfg.perf_counters);
+    perf_poses.start();
+    if (output_cfg.open_regions)
+    {
+      computePoses(normals, open_contours_points, regions.open_regions_poses);
+    }
+    if (output_cfg.closed_regions)
+    {
+      computePoses(normals, closed_contours_points, regions.closed_regions_poses);
+      for (std::size_t i = 0; i < regions.closed_regions_poses.size(); i++)
+      {
+        const ClosedSource& source = closed_sources[i];
+        RegionInfo info;
+        info.bundle = source.bundle;
+        if (source.pixels)
+        {
+          info.pixels = *source.pixels;
+        }
+        info.plane = fitRegionPlane(*closed_contours_points[i], regions.closed_regions_poses[i]);
+        regions.closed_regions_info.push_back(std::move(info));
+      }
+    }
+    regions.stage_stats["poses"].durations.push_back(secondsSince(start_poses));
+    if (perf_poses.isOpen())
+    {
+      addCounters(perf_poses.stop(), regions.stage_stats["poses"]);
+    }
+  }
 
-  std::string msg = boost::str(boost::format("Found %i closed regions and %i open regions") %
-                               regions.closed_regions_poses.size() % regions.open_regions_poses.size());
-  if (regions.closed_regions_poses.empty())
+  // without their poses the closed regions are counted by their curves
+  std::size_t num_closed =
+      output_cfg.closed_regions ? regions.closed_regions_poses.size() : closed_contours_points.size();
+  std::string msg = boost::str(boost::format("Found %i closed regions and %i open regions") % num_closed %
+                               open_contours_points.size());
+  regions.succeeded = num_closed > 0;
+  if (!regions.succeeded)
   {
+    regions.err_msg = "No closed regions found";
     LOG4CXX_ERROR(logger_, msg);
   }
   else
   {
     LOG4CXX_INFO(logger_, msg);
   }
-  return !regions.closed_regions_poses.empty();
+  return regions.succeeded;
 }
 
 std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>
@@ -1169,7 +3033,7 @@ RegionDetector::simplifyByMinimunLength(const std::vector<pcl::PointCloud<pcl::P
 }
 
 RegionDetector::Result
-RegionDetector::extractContoursFromCloud(const std::vector<std::vector<cv::Point>>& contour_indices,
+RegionDetector::extractContoursFromCloud(const std::vector<ChainContour>& contour_indices,
                                          pcl::PointCloud<pcl::PointXYZ>::ConstPtr input,
                                          std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& contours_points)
 {
@@ -1188,8 +3052,7 @@ RegionDetector::extractContoursFromCloud(const std::vector<std::vector<cv::Point
     return Result(false, err_msg);
   }
 
-  pcl::PointCloud<pcl::PointXYZ> temp_contour_points;
-  for (const std::vector<cv::Point>& indices : contour_indices)
+  for (const ChainContour& indices : contour_indices)
   {
     if (indices.empty())
     {
@@ -1198,8 +3061,11 @@ RegionDetector::extractContoursFromCloud(const std::vector<std::vector<cv::Point
       return Result(false, err_msg);
     }
 
-    temp_contour_points.clear();
-    for (const cv::Point& idx : indices)
+    pcl::PointCloud<pcl::PointXYZ>::Ptr contour_points = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+    contour_points->reserve(indices.size());
+    ChainContour::Decoder decoder(indices);
+    cv::Point idx;
+    while (decoder.next(idx))
     {
       if (idx.x >= input->width || idx.y >= input->height)
       {
@@ -1207,9 +3073,9 @@ RegionDetector::extractContoursFromCloud(const std::vector<std::vector<cv::Point
         LOG4CXX_ERROR(logger_, err_msg)
         return Result(false, err_msg);
       }
-      temp_contour_points.push_back(input->at(idx.x, idx.y));
+      contour_points->push_back(input->at(idx.x, idx.y));
     }
-    contours_points.push_back(boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>(temp_contour_points));
+    contours_points.push_back(contour_points);
   }
 
   return Result(!contours_points.empty(), "Empty cloud after extraction of 3D points");
@@ -1401,15 +3267,13 @@ RegionDetector::computeNormals(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr so
   pcl::NormalEstimation<pcl::PointXYZ, pcl::PointNormal> ne;
   ne.setInputCloud(source_cloud_downsampled);
   ne.setViewPoint(cfg.viewpoint_xyz[0], cfg.viewpoint_xyz[1], cfg.viewpoint_xyz[2]);
-  pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZ>());
-  ne.setSearchMethod(tree);
+  ne.setSearchMethod(createSearch(cfg_->backend_cfg.search, 0.0));
   ne.setRadiusSearch(cfg.search_radius);
   ne.compute(*source_cloud_normals);
 
-  // create kdtree to search cloud with normals
-  pcl::KdTreeFLANN<pcl::PointXYZ> kdtree;
-  kdtree.setEpsilon(cfg.kdtree_epsilon);
-  kdtree.setInputCloud(source_cloud_downsampled);
+  // create search of the cloud with normals
+  pcl::search::Search<pcl::PointXYZ>::Ptr search = createSearch(cfg_->backend_cfg.search, cfg.kdtree_epsilon);
+  search->setInputCloud(source_cloud_downsampled);
 
   const int MAX_NUM_POINTS = 1;
   std::vector<int> nearest_indices(MAX_NUM_POINTS);
@@ -1421,7 +3285,7 @@ RegionDetector::computeNormals(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr so
     curve_normals->reserve(curve->size());
     for (auto& search_p : *curve)
     {
-      int nearest_found = kdtree.nearestKSearch(search_p, MAX_NUM_POINTS, nearest_indices, nearest_distances);
+      int nearest_found = search->nearestKSearch(search_p, MAX_NUM_POINTS, nearest_indices, nearest_distances);
       if (nearest_found <= 0)
       {
         std::string err_msg = "Found no points near curve, can not get normal vector";
@@ -1445,12 +3309,11 @@ RegionDetector::Result RegionDetector::computePoses(pcl::PointCloud<pcl::PointNo
   using namespace Eigen;
   const config_3d::NormalEstimationCfg& cfg = cfg_->pcl_cfg.normal_est;
 
-  // create kdtree to search cloud with normals
+  // create search of the cloud with normals
   pcl::PointCloud<pcl::PointXYZ>::Ptr source_points = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
   pcl::copyPointCloud(*source_normal_cloud, *source_points);
-  pcl::KdTreeFLANN<pcl::PointXYZ> kdtree;
-  kdtree.setEpsilon(cfg.kdtree_epsilon);
-  kdtree.setInputCloud(source_points);
+  pcl::search::Search<pcl::PointXYZ>::Ptr search = createSearch(cfg_->backend_cfg.search, cfg.kdtree_epsilon);
+  search->setInputCloud(source_points);
 
   const unsigned int MAX_NUM_POINTS = 1;
   std::vector<int> nearest_indices(MAX_NUM_POINTS);
@@ -1465,7 +3328,7 @@ RegionDetector::Result RegionDetector::computePoses(pcl::PointCloud<pcl::PointNo
     curve_normals->reserve(curve->size());
     for (auto& search_p : *curve)
     {
-      int nearest_found = kdtree.nearestKSearch(search_p, MAX_NUM_POINTS, nearest_indices, nearest_distances);
+      int nearest_found = search->nearestKSearch(search_p, MAX_NUM_POINTS, nearest_indices, nearest_distances);
       if (nearest_found <= 0)
       {
         std::string err_msg = boost::str(boost::format("Kdtree found no nearby points during pose computation"));
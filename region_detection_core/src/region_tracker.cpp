@@ -0,0 +1,354 @@
+/*
+ * @file region_tracker.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+#include <boost/format.hpp>
+
+#include "region_detection_core/region_tracker.h"
+
+/**
+ * @brief copies the points of an organized cloud that fall inside the region of interest
+ */
+static bool cropOrganizedCloud(const pcl::PCLPointCloud2& cloud, const cv::Rect& roi, pcl::PCLPointCloud2& cropped)
+{
+  if (cloud.height <= 1 || roi.x < 0 || roi.y < 0 || roi.x + roi.width > static_cast<int>(cloud.width) ||
+      roi.y + roi.height > static_cast<int>(cloud.height) || cloud.data.size() < cloud.row_step * cloud.height)
+  {
+    return false;
+  }
+
+  cropped.header = cloud.header;
+  cropped.fields = cloud.fields;
+  cropped.is_bigendian = cloud.is_bigendian;
+  cropped.is_dense = cloud.is_dense;
+  cropped.point_step = cloud.point_step;
+  cropped.width = roi.width;
+  cropped.height = roi.height;
+  cropped.row_step = cropped.width * cropped.point_step;
+  cropped.data.resize(cropped.row_step * cropped.height);
+  for (int r = 0; r < roi.height; r++)
+  {
+    std::memcpy(&cropped.data[r * cropped.row_step],
+                &cloud.data[(roi.y + r) * cloud.row_step + roi.x * cloud.point_step],
+                cropped.row_step);
+  }
+  return true;
+}
+
+/**
+ * @brief merges the overlapping rectangles so that no pixel is processed twice
+ */
+static std::vector<cv::Rect> mergeOverlapping(std::vector<cv::Rect> rects)
+{
+  bool merged = true;
+  while (merged)
+  {
+    merged = false;
+    for (std::size_t i = 0; i < rects.size() && !merged; i++)
+    {
+      for (std::size_t j = i + 1; j < rects.size(); j++)
+      {
+        if ((rects[i] & rects[j]).area() > 0)
+        {
+          rects[i] |= rects[j];
+          rects.erase(std::next(rects.begin(), j));
+          merged = true;
+          break;
+        }
+      }
+    }
+  }
+  return rects;
+}
+
+static Eigen::Vector3d computeCentroid(const region_detection_core::RegionDetector::EigenPose3dVector& poses)
+{
+  Eigen::Vector3d centroid = Eigen::Vector3d::Zero();
+  for (const Eigen::Isometry3d& pose : poses)
+  {
+    centroid += pose.translation();
+  }
+  return centroid / static_cast<double>(poses.size());
+}
+
+namespace region_detection_core
+{
+RegionTracker::RegionTracker(std::shared_ptr<RegionDetector> detector, const RegionTrackerConfig& config)
+  : detector_(detector), config_(config)
+{
+  // the regions of interest are found around the pixel contours and the tracks include the open regions
+  RegionDetectionConfig::OutputCfg outputs = detector_->getConfig().output_cfg;
+  if (!outputs.contours || !outputs.closed_regions || !outputs.open_regions)
+  {
+    LOG4CXX_WARN(detector_->getLogger(), "The tracker enables the contours and region outputs of the detector");
+    outputs.contours = outputs.closed_regions = outputs.open_regions = true;
+    detector_->setOutputs(outputs);
+  }
+}
+
+RegionTracker::~RegionTracker() {}
+
+void RegionTracker::setConfig(const RegionTrackerConfig& config) { config_ = config; }
+
+void RegionTracker::reset()
+{
+  tracks_.clear();
+  contours_.clear();
+  frames_since_detection_ = 0;
+}
+
+bool RegionTracker::update(const RegionDetector::DataBundleVec& input, TrackingResults& results)
+{
+  log4cxx::LoggerPtr logger = detector_->getLogger();
+  results = TrackingResults();
+
+  // the whole frame is searched periodically so that new regions are picked up
+  bool full_detection = tracks_.empty() || contours_.size() != input.size() || config_.redetect_interval <= 1 ||
+                        frames_since_detection_ + 1 >= static_cast<std::size_t>(config_.redetect_interval);
+  if (!full_detection)
+  {
+    RegionDetector::DataBundleVec roi_input;
+    std::vector<RoiBundle> roi_bundles;
+    bool found = false;
+    if (predictRois(input, roi_input, roi_bundles))
+    {
+      // compute() also reports failure when only open regions are found
+      detector_->compute(std::move(roi_input), results.detection);
+      found = !results.detection.closed_regions_poses.empty() || !results.detection.open_regions_poses.empty();
+    }
+
+    if (found)
+    {
+      LOG4CXX_DEBUG(logger, "Tracked regions searched in " << roi_bundles.size() << " regions of interest");
+      updateContours(roi_bundles, input.size(), results.detection);
+      frames_since_detection_++;
+
+      // the region info refers to the full frames
+      for (RegionDetector::RegionInfo& info : results.detection.closed_regions_info)
+      {
+        if (info.bundle < 0 || static_cast<std::size_t>(info.bundle) >= roi_bundles.size())
+        {
+          continue;
+        }
+        const RoiBundle& roi_bundle = roi_bundles[info.bundle];
+        for (cv::Point& p : info.pixels)
+        {
+          p += roi_bundle.roi.tl();
+        }
+        info.bundle = static_cast<int>(roi_bundle.bundle_index);
+      }
+    }
+    else
+    {
+      LOG4CXX_DEBUG(logger, "No regions found in the regions of interest, searching the full frame");
+      full_detection = true;
+    }
+  }
+
+  if (full_detection)
+  {
+    detector_->compute(input, results.detection);
+    contours_ = results.detection.contours;
+    contours_.resize(input.size());
+    frames_since_detection_ = 0;
+  }
+  results.full_detection = full_detection;
+
+  associate(results.detection, results);
+  LOG4CXX_INFO(logger,
+               boost::str(boost::format("Tracking %i regions, %i found in this frame") % tracks_.size() %
+                          results.regions.size()));
+  return !results.regions.empty();
+}
+
+bool RegionTracker::predictRois(const RegionDetector::DataBundleVec& input,
+                                RegionDetector::DataBundleVec& roi_input,
+                                std::vector<RoiBundle>& roi_bundles) const
+{
+  for (std::size_t i = 0; i < input.size(); i++)
+  {
+    const RegionDetector::DataBundle& data = input[i];
+    if (data.cloud_blob.width != static_cast<std::uint32_t>(data.image.cols) ||
+        data.cloud_blob.height != static_cast<std::uint32_t>(data.image.rows))
+    {
+      LOG4CXX_DEBUG(detector_->getLogger(), "The cloud of bundle " << i << " is not aligned with its image");
+      return false;
+    }
+
+    const cv::Rect image_rect(0, 0, data.image.cols, data.image.rows);
+    std::vector<cv::Rect> rects;
+    for (const std::vector<cv::Point>& contour : contours_[i])
+    {
+      if (contour.empty())
+      {
+        continue;
+      }
+      cv::Rect rect = cv::boundingRect(contour);
+      rect = cv::Rect(rect.x - config_.roi_margin,
+                      rect.y - config_.roi_margin,
+                      rect.width + 2 * config_.roi_margin,
+                      rect.height + 2 * config_.roi_margin) &
+             image_rect;
+      if (rect.area() > 0)
+      {
+        rects.push_back(rect);
+      }
+    }
+
+    for (const cv::Rect& roi : mergeOverlapping(rects))
+    {
+      RegionDetector::DataBundle roi_data;
+      if (!cropOrganizedCloud(data.cloud_blob, roi, roi_data.cloud_blob))
+      {
+        return false;
+      }
+      roi_data.image = data.image(roi).clone();
+      roi_data.transform = data.transform;
+      roi_input.push_back(std::move(roi_data));
+      roi_bundles.push_back(RoiBundle{ i, roi });
+    }
+  }
+  return !roi_input.empty();
+}
+
+void RegionTracker::updateContours(const std::vector<RoiBundle>& roi_bundles,
+                                   std::size_t num_bundles,
+                                   const RegionDetector::RegionResults& detection)
+{
+  contours_.assign(num_bundles, {});
+  for (std::size_t k = 0; k < roi_bundles.size() && k < detection.contours.size(); k++)
+  {
+    const cv::Point offset = roi_bundles[k].roi.tl();
+    std::vector<std::vector<cv::Point>>& bundle_contours = contours_[roi_bundles[k].bundle_index];
+    for (std::vector<cv::Point> contour : detection.contours[k])
+    {
+      for (cv::Point& p : contour)
+      {
+        p += offset;
+      }
+      bundle_contours.push_back(contour);
+    }
+  }
+}
+
+void RegionTracker::associate(const RegionDetector::RegionResults& detection, TrackingResults& results)
+{
+  // detected regions, closed first
+  std::vector<TrackedRegion, Eigen::aligned_allocator<TrackedRegion>> detected;
+  auto add_detected = [&detected](const std::vector<RegionDetector::EigenPose3dVector>& regions, bool closed) {
+    for (const RegionDetector::EigenPose3dVector& poses : regions)
+    {
+      if (poses.empty())
+      {
+        continue;
+      }
+      TrackedRegion region;
+      region.id = -1;
+      region.closed = closed;
+      region.poses = poses;
+      region.centroid = computeCentroid(poses);
+      detected.push_back(region);
+    }
+  };
+  add_detected(detection.closed_regions_poses, true);
+  add_detected(detection.open_regions_poses, false);
+
+  // greedy nearest neighbor assignment
+  std::vector<std::tuple<double, std::size_t, std::size_t>> candidates;
+  for (std::size_t t = 0; t < tracks_.size(); t++)
+  {
+    for (std::size_t d = 0; d < detected.size(); d++)
+    {
+      if (tracks_[t].closed != detected[d].closed)
+      {
+        continue;
+      }
+      double dist = (tracks_[t].centroid - detected[d].centroid).norm();
+      if (dist <= config_.max_association_dist)
+      {
+        candidates.emplace_back(dist, t, d);
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+
+  std::vector<bool> track_matched(tracks_.size(), false);
+  std::vector<bool> detection_matched(detected.size(), false);
+  for (const auto& candidate : candidates)
+  {
+    std::size_t t, d;
+    std::tie(std::ignore, t, d) = candidate;
+    if (track_matched[t] || detection_matched[d])
+    {
+      continue;
+    }
+    track_matched[t] = detection_matched[d] = true;
+
+    TrackedRegion& track = tracks_[t];
+    track.poses = detected[d].poses;
+    track.centroid = detected[d].centroid;
+    track.age++;
+    track.missed = 0;
+    detected[d] = track;
+  }
+
+  // unmatched tracks are kept for a few frames in case the region was temporarily not found
+  for (std::size_t t = 0; t < tracks_.size(); t++)
+  {
+    if (!track_matched[t])
+    {
+      tracks_[t].missed++;
+    }
+  }
+  tracks_.erase(std::remove_if(tracks_.begin(),
+                               tracks_.end(),
+                               [this](const TrackedRegion& track) { return track.missed > config_.max_missed_frames; }),
+                tracks_.end());
+
+  // unmatched detections start new tracks
+  for (std::size_t d = 0; d < detected.size(); d++)
+  {
+    if (!detection_matched[d])
+    {
+      detected[d].id = next_id_++;
+      tracks_.push_back(detected[d]);
+    }
+  }
+  results.regions = detected;
+}
+
+} /* namespace region_detection_core */
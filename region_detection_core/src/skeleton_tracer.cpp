@@ -0,0 +1,194 @@
+/*
+ * @file skeleton_tracer.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdint>
+
+#include "region_detection_core/skeleton_tracer.h"
+
+namespace region_detection_core
+{
+namespace
+{
+/**
+ * @brief skeleton copied into a buffer with a one pixel border so that the neighbors of every pixel can be read
+ * without bound checks
+ */
+class PaddedSkeleton
+{
+public:
+  explicit PaddedSkeleton(const cv::Mat& skeleton)
+    : stride_(skeleton.cols + 2), pixels_((skeleton.rows + 2) * stride_, 0)
+  {
+    for (int y = 0; y < skeleton.rows; y++)
+    {
+      const uchar* row = skeleton.ptr<uchar>(y);
+      std::uint8_t* dst = &pixels_[(y + 1) * stride_ + 1];
+      for (int x = 0; x < skeleton.cols; x++)
+      {
+        dst[x] = row[x] != 0 ? 1 : 0;
+      }
+    }
+
+    // neighbors in counterclockwise order starting with the right one, the even entries share a side
+    const int offsets[8] = { 1, 1 - stride_, -stride_, -1 - stride_, -1, stride_ - 1, stride_, stride_ + 1 };
+    std::copy(offsets, offsets + 8, offsets_);
+  }
+
+  std::size_t size() const { return pixels_.size(); }
+  bool isSet(int idx) const { return pixels_[idx] != 0; }
+
+  /**
+   * @brief neighbor of a set pixel in the given direction when it is linked to it, -1 otherwise
+   */
+  int linkedNeighbor(int idx, int dir) const
+  {
+    int neighbor = idx + offsets_[dir];
+    if (!pixels_[neighbor])
+    {
+      return -1;
+    }
+    if (dir % 2 == 1 && (pixels_[idx + offsets_[dir - 1]] || pixels_[idx + offsets_[(dir + 1) % 8]]))
+    {
+      // reached through a pixel sharing a side with both
+      return -1;
+    }
+    return neighbor;
+  }
+
+  int degree(int idx) const
+  {
+    int count = 0;
+    for (int dir = 0; dir < 8; dir++)
+    {
+      count += linkedNeighbor(idx, dir) >= 0 ? 1 : 0;
+    }
+    return count;
+  }
+
+  cv::Point toPoint(int idx) const { return cv::Point(idx % stride_ - 1, idx / stride_ - 1); }
+
+private:
+  int stride_;
+  std::vector<std::uint8_t> pixels_;
+  int offsets_[8];
+};
+}  // namespace
+
+bool traceSkeleton(const cv::Mat& skeleton, std::vector<std::vector<cv::Point>>& polylines)
+{
+  polylines.clear();
+  if (skeleton.type() != CV_8UC1)
+  {
+    return false;
+  }
+
+  PaddedSkeleton padded(skeleton);
+  std::vector<std::uint8_t> degrees(padded.size(), 0);
+  std::vector<int> set_pixels;
+  for (int idx = 0; idx < static_cast<int>(padded.size()); idx++)
+  {
+    if (padded.isSet(idx))
+    {
+      degrees[idx] = padded.degree(idx);
+      set_pixels.push_back(idx);
+    }
+  }
+  auto is_node = [&degrees](int idx) { return degrees[idx] != 2; };
+
+  // follows a branch until it reaches a node or a visited pixel, only the pixels inside the branch are marked
+  std::vector<std::uint8_t> visited(padded.size(), 0);
+  auto walk = [&](int prev, int current, std::vector<cv::Point>& polyline) {
+    while (true)
+    {
+      polyline.push_back(padded.toPoint(current));
+      if (is_node(current))
+      {
+        return;
+      }
+      visited[current] = 1;
+
+      int next = -1;
+      for (int dir = 0; dir < 8 && next < 0; dir++)
+      {
+        int neighbor = padded.linkedNeighbor(current, dir);
+        if (neighbor >= 0 && neighbor != prev && (is_node(neighbor) || !visited[neighbor]))
+        {
+          next = neighbor;
+        }
+      }
+      if (next < 0)
+      {
+        return;
+      }
+      prev = current;
+      current = next;
+    }
+  };
+
+  // branches leaving the endpoints and junctions
+  for (int node : set_pixels)
+  {
+    if (!is_node(node) || degrees[node] == 0)
+    {
+      continue;
+    }
+    for (int dir = 0; dir < 8; dir++)
+    {
+      int neighbor = padded.linkedNeighbor(node, dir);
+      if (neighbor < 0 || is_node(neighbor) || visited[neighbor])
+      {
+        // nodes next to each other belong to the same junction
+        continue;
+      }
+      std::vector<cv::Point> polyline = { padded.toPoint(node) };
+      walk(node, neighbor, polyline);
+      polylines.push_back(std::move(polyline));
+    }
+  }
+
+  // what remains are loops without nodes
+  for (int idx : set_pixels)
+  {
+    if (is_node(idx) || visited[idx])
+    {
+      continue;
+    }
+    std::vector<cv::Point> polyline;
+    walk(-1, idx, polyline);
+    polylines.push_back(std::move(polyline));
+  }
+  return true;
+}
+
+}  // namespace region_detection_core
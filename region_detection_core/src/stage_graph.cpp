@@ -0,0 +1,256 @@
+/*
+ * @file stage_graph.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <map>
+
+#include <boost/format.hpp>
+
+#include "region_detection_core/stage_graph.h"
+
+static const std::map<std::string, region_detection_core::CombineOp> COMBINE_CODES_MAPPINGS = {
+  { "AND", region_detection_core::CombineOp::AND },
+  { "OR", region_detection_core::CombineOp::OR },
+  { "XOR", region_detection_core::CombineOp::XOR }
+};
+
+namespace region_detection_core
+{
+const std::string StageGraph::INPUT_NODE = "input";
+const std::size_t StageGraph::INPUT_INDEX;
+
+StageGraph::StageGraph() : output_index_(INPUT_INDEX) {}
+
+StageGraph::~StageGraph() {}
+
+bool StageGraph::build(const config_2d::StageGraphCfg& config, std::string& err_msg)
+{
+  nodes_.clear();
+  levels_.clear();
+  output_index_ = INPUT_INDEX;
+  if (config.nodes.empty())
+  {
+    return true;
+  }
+
+  // indexing nodes by name
+  std::map<std::string, std::size_t> node_indices;
+  for (std::size_t i = 0; i < config.nodes.size(); i++)
+  {
+    const std::string& name = config.nodes[i].name;
+    if (name.empty() || name == INPUT_NODE || node_indices.count(name) > 0)
+    {
+      err_msg = boost::str(boost::format("Stage graph node %i has an empty, reserved or repeated name '%s'") % i % name);
+      return false;
+    }
+    node_indices[name] = i;
+  }
+
+  if (node_indices.count(config.output) == 0)
+  {
+    err_msg = boost::str(boost::format("Stage graph output node '%s' was not found") % config.output);
+    return false;
+  }
+  output_index_ = node_indices.at(config.output);
+
+  // resolving the node inputs
+  std::vector<Node> nodes(config.nodes.size());
+  for (std::size_t i = 0; i < config.nodes.size(); i++)
+  {
+    const config_2d::StageNodeCfg& node_cfg = config.nodes[i];
+    Node& node = nodes[i];
+    node.name = node_cfg.name;
+    node.methods = node_cfg.methods;
+
+    if (!node_cfg.combine.empty())
+    {
+      if (COMBINE_CODES_MAPPINGS.count(node_cfg.combine) == 0 || !node_cfg.methods.empty())
+      {
+        err_msg = boost::str(boost::format("Stage graph node '%s' has an invalid combine operator '%s' or also "
+                                           "lists methods") %
+                             node.name % node_cfg.combine);
+        return false;
+      }
+      node.combine = COMBINE_CODES_MAPPINGS.at(node_cfg.combine);
+    }
+
+    if (node_cfg.inputs.empty() || (node.combine == CombineOp::NONE && node_cfg.inputs.size() != 1))
+    {
+      err_msg = boost::str(boost::format("Stage graph node '%s' needs one input or a combine operator") % node.name);
+      return false;
+    }
+
+    for (const std::string& input_name : node_cfg.inputs)
+    {
+      if (input_name == INPUT_NODE)
+      {
+        node.inputs.push_back(INPUT_INDEX);
+        continue;
+      }
+
+      if (node_indices.count(input_name) == 0)
+      {
+        err_msg = boost::str(boost::format("Stage graph node '%s' uses unknown input '%s'") % node.name % input_name);
+        return false;
+      }
+      node.inputs.push_back(node_indices.at(input_name));
+    }
+  }
+
+  // only the nodes the output depends on get computed
+  std::vector<bool> required(nodes.size(), false);
+  std::vector<std::size_t> pending = { output_index_ };
+  while (!pending.empty())
+  {
+    std::size_t idx = pending.back();
+    pending.pop_back();
+    if (required[idx])
+    {
+      continue;
+    }
+    required[idx] = true;
+    for (std::size_t input_idx : nodes[idx].inputs)
+    {
+      if (input_idx != INPUT_INDEX)
+      {
+        pending.push_back(input_idx);
+      }
+    }
+  }
+
+  // grouping into levels, a node goes into the level after the deepest of its inputs
+  std::vector<int> node_levels(nodes.size(), -1);
+  std::size_t num_required = std::count(required.begin(), required.end(), true);
+  std::size_t num_assigned = 0;
+  for (int level = 0; num_assigned < num_required; level++)
+  {
+    std::vector<std::size_t> level_nodes;
+    for (std::size_t i = 0; i < nodes.size(); i++)
+    {
+      if (!required[i] || node_levels[i] >= 0)
+      {
+        continue;
+      }
+
+      bool ready = std::all_of(nodes[i].inputs.begin(), nodes[i].inputs.end(), [&](std::size_t input_idx) {
+        return input_idx == INPUT_INDEX || (node_levels[input_idx] >= 0 && node_levels[input_idx] < level);
+      });
+      if (ready)
+      {
+        level_nodes.push_back(i);
+      }
+    }
+
+    if (level_nodes.empty())
+    {
+      err_msg = "Stage graph contains a cycle";
+      return false;
+    }
+
+    for (std::size_t idx : level_nodes)
+    {
+      node_levels[idx] = level;
+      for (std::size_t input_idx : nodes[idx].inputs)
+      {
+        if (input_idx != INPUT_INDEX)
+        {
+          nodes[input_idx].num_consumers++;
+        }
+      }
+    }
+    num_assigned += level_nodes.size();
+    levels_.push_back(level_nodes);
+  }
+
+  nodes_ = nodes;
+  return true;
+}
+
+bool StageGraph::empty() const { return nodes_.empty(); }
+
+const std::vector<StageGraph::Node>& StageGraph::getNodes() const { return nodes_; }
+
+const std::vector<std::vector<std::size_t>>& StageGraph::getLevels() const { return levels_; }
+
+std::size_t StageGraph::getOutputIndex() const { return output_index_; }
+
+bool StageGraph::combine(CombineOp op, const std::vector<cv::Mat>& inputs, cv::Mat& output, std::string& err_msg)
+{
+  if (inputs.empty())
+  {
+    err_msg = "No masks to combine";
+    return false;
+  }
+
+  for (const cv::Mat& m : inputs)
+  {
+    if (m.empty() || m.size() != inputs.front().size() || m.type() != inputs.front().type())
+    {
+      err_msg = "Combined masks must be non empty and of the same size and type";
+      return false;
+    }
+  }
+
+  if (inputs.size() == 1)
+  {
+    output = inputs.front();
+    return true;
+  }
+
+  // writing into a new buffer since the output may share data with images used by other nodes
+  cv::Mat combined;
+  for (std::size_t i = 1; i < inputs.size(); i++)
+  {
+    const cv::Mat& lhs = i == 1 ? inputs.front() : combined;
+    switch (op)
+    {
+      case CombineOp::AND:
+        cv::bitwise_and(lhs, inputs[i], combined);
+        break;
+      case CombineOp::OR:
+        cv::bitwise_or(lhs, inputs[i], combined);
+        break;
+      case CombineOp::XOR:
+        cv::bitwise_xor(lhs, inputs[i], combined);
+        break;
+      default:
+        err_msg = boost::str(boost::format("Combine operator %i is not supported") % static_cast<int>(op));
+        return false;
+    }
+  }
+  output = combined;
+  return true;
+}
+
+} /* namespace region_detection_core */
@@ -0,0 +1,107 @@
+#include <iostream>
+#include <boost/lexical_cast.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include "region_detection_core/binary_image.h"
+
+using namespace region_detection_core;
+
+/**
+ * @brief traces the mask on the packed image and with cv::findContours for every mode and method the packed image
+ * supports
+ * @return The number of combinations that differ
+ */
+static int compareContours(const cv::Mat& mask, const std::string& name)
+{
+  static const std::vector<std::pair<int, int>> VARIANTS = { { CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE },
+                                                             { CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE },
+                                                             { CV_RETR_LIST, CV_CHAIN_APPROX_NONE },
+                                                             { CV_RETR_LIST, CV_CHAIN_APPROX_SIMPLE } };
+  BinaryImage packed;
+  if (!BinaryImage::pack(mask, packed))
+  {
+    std::cout << name << ": could not pack the mask" << std::endl;
+    return 1;
+  }
+
+  int num_failed = 0;
+  for (const auto& variant : VARIANTS)
+  {
+    std::vector<std::vector<cv::Point>> expected, traced;
+    std::vector<cv::Vec4i> expected_hierarchy, traced_hierarchy;
+
+    // older versions of findContours modify the image
+    cv::findContours(mask.clone(), expected, expected_hierarchy, variant.first, variant.second);
+    packed.findContours(traced, traced_hierarchy, variant.first, variant.second);
+    if (traced != expected || traced_hierarchy != expected_hierarchy)
+    {
+      std::cout << name << " mode " << variant.first << " method " << variant.second << ": traced " << traced.size()
+                << " contours, findContours " << expected.size() << std::endl;
+      num_failed++;
+    }
+  }
+  return num_failed;
+}
+
+/**
+ * @brief random shapes and noise, the widths cross the 64 pixel words of the packed image
+ */
+static cv::Mat createMask(cv::RNG& rng, int rows, int cols)
+{
+  cv::Mat mask = cv::Mat::zeros(rows, cols, CV_8UC1);
+  if (rng.uniform(0, 3) == 0)
+  {
+    cv::randu(mask, 0, 256);
+    cv::threshold(mask, mask, rng.uniform(0, 256), 255, cv::THRESH_BINARY);
+    return mask;
+  }
+
+  int num_shapes = rng.uniform(1, 8);
+  for (int i = 0; i < num_shapes; i++)
+  {
+    cv::Point p1(rng.uniform(-5, cols + 5), rng.uniform(-5, rows + 5));
+    cv::Point p2(rng.uniform(-5, cols + 5), rng.uniform(-5, rows + 5));
+    int thickness = rng.uniform(0, 3) == 0 ? cv::FILLED : rng.uniform(1, 4);
+    cv::rectangle(mask, p1, p2, cv::Scalar(255), thickness);
+    cv::circle(mask, p2, rng.uniform(1, std::max(2, rows / 3)), cv::Scalar(rng.uniform(0, 2) * 255), thickness);
+  }
+  return mask;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1 && std::string(argv[1]) == "-h")
+  {
+    std::cout << "Usage: binary_contours_test [num random masks] [images ...]" << std::endl;
+    return 0;
+  }
+
+  int num_masks = argc > 1 ? boost::lexical_cast<int>(argv[1]) : 500;
+  int num_failed = 0;
+  int num_checked = 0;
+  cv::RNG rng(12345);
+  const std::vector<int> widths = { 1, 7, 63, 64, 65, 127, 128, 200 };
+  for (int i = 0; i < num_masks; i++)
+  {
+    int cols = rng.uniform(0, 2) == 0 ? widths[rng.uniform(0, static_cast<int>(widths.size()))] : rng.uniform(1, 300);
+    cv::Mat mask = createMask(rng, rng.uniform(1, 120), cols);
+    num_failed += compareContours(mask, "mask " + std::to_string(i));
+    num_checked++;
+  }
+
+  // any other argument is an image whose non zero pixels are traced
+  for (int i = 2; i < argc; i++)
+  {
+    cv::Mat image = cv::imread(argv[i], cv::IMREAD_GRAYSCALE);
+    if (image.empty())
+    {
+      std::cout << "Cannot read the image: " << argv[i] << std::endl;
+      return -1;
+    }
+    num_failed += compareContours(image, argv[i]);
+    num_checked++;
+  }
+
+  std::cout << num_checked << " masks checked, " << num_failed << " traces differ from findContours" << std::endl;
+  return num_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+#include <iostream>
+#include <boost/lexical_cast.hpp>
+#include <boost/filesystem.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <pcl/io/pcd_io.h>
+#include "region_detection_core/autotuner.h"
+
+using namespace region_detection_core;
+
+int main(int argc, char** argv)
+{
+  namespace fs = boost::filesystem;
+
+  auto logger = RegionDetector::createDefaultInfoLogger("Autotune");
+  if (argc < 5)
+  {
+    LOG4CXX_ERROR(logger, "Needs config file, image, pcd file and output profile arguments, optionally the repetitions");
+    return -1;
+  }
+
+  std::vector<std::string> files = { argv[1], argv[2], argv[3] };
+  if (!std::all_of(files.begin(), files.end(), [](const std::string& f) { return fs::exists(fs::path(f)); }))
+  {
+    LOG4CXX_ERROR(logger, "File does not exists");
+    return -1;
+  }
+
+  std::string config_file = argv[1];
+  std::string img_file = argv[2];
+  std::string pcd_file = argv[3];
+  std::string profile_file = argv[4];
+  int repetitions = argc > 5 ? boost::lexical_cast<int>(argv[5]) : 3;
+
+  RegionDetector::DataBundle bundle;
+  bundle.image = cv::imread(img_file, cv::IMREAD_COLOR);
+  bundle.transform = Eigen::Isometry3d::Identity();
+  if (bundle.image.empty() || pcl::io::loadPCDFile(pcd_file, bundle.cloud_blob) < 0)
+  {
+    LOG4CXX_ERROR(logger, "Failed to load the sample data");
+    return -1;
+  }
+
+  AutotuneProfile profile;
+  Autotuner autotuner(logger);
+  std::string err_msg;
+  if (!autotuner.run(RegionDetectionConfig::loadFromFile(config_file), { bundle }, profile, repetitions))
+  {
+    LOG4CXX_ERROR(logger, "Autotuning failed");
+    return -1;
+  }
+
+  if (!profile.save(profile_file, err_msg))
+  {
+    LOG4CXX_ERROR(logger, err_msg);
+    return -1;
+  }
+
+  std::cout << "Saved profile to " << profile_file << std::endl;
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * @file tiled_cloud.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits>
+
+#include "region_detection_core/tiled_cloud.h"
+
+namespace region_detection_core
+{
+const int TiledCloud::TILE_BITS;
+const int TiledCloud::TILE_SIZE;
+
+TiledCloud::TiledCloud() : width_(0), height_(0), tiles_per_row_(0) {}
+
+bool TiledCloud::build(const CloudPlanes& planes)
+{
+  if (planes.height() <= 1)
+  {
+    return false;
+  }
+
+  width_ = planes.width();
+  height_ = planes.height();
+  tiles_per_row_ = (width_ + TILE_SIZE - 1) / TILE_SIZE;
+  int tile_rows = (height_ + TILE_SIZE - 1) / TILE_SIZE;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  points_.assign(static_cast<std::size_t>(tiles_per_row_ * tile_rows) << (2 * TILE_BITS), Point{ nan, nan, nan });
+
+  // the planes are read in order, the writes stay within the band of tiles of the current row
+  std::size_t src = 0;
+  for (int y = 0; y < height_; y++)
+  {
+    for (int x = 0; x < width_; x++, src++)
+    {
+      points_[index(x, y)] = Point{ planes.x()[src], planes.y()[src], planes.z()[src] };
+    }
+  }
+  return true;
+}
+
+}  // namespace region_detection_core
@@ -0,0 +1,367 @@
+/*
+ * @file request_queue.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_RCLCPP_REQUEST_QUEUE_H_
+#define INCLUDE_REGION_DETECTION_RCLCPP_REQUEST_QUEUE_H_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace region_detection_rclcpp
+{
+/**
+ * @class region_detection_rclcpp::RequestQueue
+ * @brief Admission control for a service whose callbacks run concurrently.  Each callback waits in the queue until one
+ * of the processing slots is free, higher priorities first and in arrival order otherwise.  A request is rejected
+ * when the queue is full of requests with the same or a higher priority, or when the expected completion time,
+ * estimated from the duration of the previous requests, is past its deadline.  A request identical to one that is
+ * queued or running waits for that one's response instead of being processed again, these waiting requests also count
+ * against the depth so that at most concurrency + depth callers are blocked in the queue.
+ */
+template <typename RequestT, typename ResponseT>
+class RequestQueue
+{
+public:
+  using Clock = std::chrono::steady_clock;
+  using SameRequestFn = std::function<bool(const RequestT&, const RequestT&)>;
+
+  enum class Outcome
+  {
+    RUN,        /** @brief the request is processed by the caller */
+    COALESCED,  /** @brief the response of an identical request is available */
+    QUEUE_FULL, /** @brief rejected or evicted by a request with a higher priority */
+    DEADLINE    /** @brief the request cannot complete before its deadline */
+  };
+
+private:
+  struct Entry
+  {
+    std::shared_ptr<const RequestT> request;
+    std::shared_ptr<const ResponseT> response; /** @brief written by the processed request once done */
+    std::uint64_t key;
+    int priority;
+    std::uint64_t sequence;
+    Clock::time_point deadline;
+    Clock::time_point start;
+    bool done = false;
+    bool dropped = false;
+    Outcome drop_reason = Outcome::QUEUE_FULL;
+  };
+
+public:
+  /**
+   * @class region_detection_rclcpp::RequestQueue::Slot
+   * @brief Result of an admission.  A slot that runs frees its place when it goes out of scope and hands a copy of
+   * the response to the identical requests that waited for it.
+   */
+  class Slot
+  {
+  public:
+    Slot(Slot&& other)
+      : queue_(other.queue_)
+      , entry_(std::move(other.entry_))
+      , response_(std::move(other.response_))
+      , outcome_(other.outcome_)
+      , coalesced_(std::move(other.coalesced_))
+    {
+      other.queue_ = nullptr;
+    }
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+
+    ~Slot()
+    {
+      if (queue_ && entry_)
+      {
+        queue_->finish(entry_, response_ ? std::make_shared<const ResponseT>(*response_) : nullptr);
+      }
+    }
+
+    Outcome getOutcome() const { return outcome_; }
+
+    /**
+     * @brief response of the identical request, null when that request failed to produce one
+     */
+    std::shared_ptr<const ResponseT> getResponse() const { return coalesced_; }
+
+  private:
+    friend class RequestQueue;
+    Slot(RequestQueue* queue,
+         std::shared_ptr<Entry> entry,
+         std::shared_ptr<ResponseT> response,
+         Outcome outcome,
+         std::shared_ptr<const ResponseT> coalesced = nullptr)
+      : queue_(queue)
+      , entry_(std::move(entry))
+      , response_(std::move(response))
+      , outcome_(outcome)
+      , coalesced_(std::move(coalesced))
+    {
+    }
+
+    RequestQueue* queue_;
+    std::shared_ptr<Entry> entry_; /** @brief only set for the requests that run */
+    std::shared_ptr<ResponseT> response_;
+    Outcome outcome_;
+    std::shared_ptr<const ResponseT> coalesced_;
+  };
+
+  /**
+   * @param max_depth     Requests that can wait for a slot
+   * @param concurrency   Requests processed at the same time
+   * @param same_request  True when two requests would produce the same response
+   */
+  RequestQueue(std::size_t max_depth, std::size_t concurrency, SameRequestFn same_request)
+    : max_depth_(max_depth)
+    , concurrency_(std::max<std::size_t>(concurrency, 1))
+    , same_request_(std::move(same_request))
+    , next_sequence_(0)
+    , num_coalesced_(0)
+    , service_time_(0.0)
+  {
+  }
+
+  /**
+   * @brief blocks until the request can be processed or is rejected
+   * @param request   The request
+   * @param response  The response the caller fills when the request runs, copied to the identical requests
+   * @param key       Hash of the request, requests are only compared when their keys match
+   * @param priority  Higher values are served first
+   * @param deadline  Time by which the response is needed, Clock::time_point::max() for none
+   */
+  Slot admit(std::shared_ptr<const RequestT> request,
+             std::shared_ptr<ResponseT> response,
+             std::uint64_t key,
+             int priority,
+             Clock::time_point deadline)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // an identical request that is queued or running answers this one
+    std::shared_ptr<Entry> leader = findSame(*request, key);
+    if (leader && getNumWaiting() >= max_depth_)
+    {
+      return Slot(nullptr, nullptr, nullptr, Outcome::QUEUE_FULL);
+    }
+    while (leader)
+    {
+      num_coalesced_++;
+      bool in_time = waitFor(lock, deadline, [&leader]() { return leader->done || leader->dropped; });
+      num_coalesced_--;
+      if (!in_time)
+      {
+        return Slot(nullptr, nullptr, nullptr, Outcome::DEADLINE);
+      }
+      if (leader->done)
+      {
+        return Slot(nullptr, nullptr, nullptr, Outcome::COALESCED, leader->response);
+      }
+
+      // the identical request was dropped, this one queues on its own unless there is another one
+      leader = findSame(*request, key);
+    }
+
+    if (expectedCompletion(priority) > deadline)
+    {
+      return Slot(nullptr, nullptr, nullptr, Outcome::DEADLINE);
+    }
+
+    // a full queue makes room by evicting its newest request of the lowest priority
+    if (getNumWaiting() >= max_depth_ && running_.size() >= concurrency_)
+    {
+      auto lowest = std::min_element(
+          queued_.begin(), queued_.end(), [](const std::shared_ptr<Entry>& a, const std::shared_ptr<Entry>& b) {
+            return a->priority < b->priority || (a->priority == b->priority && a->sequence > b->sequence);
+          });
+      if (lowest == queued_.end() || (*lowest)->priority >= priority)
+      {
+        return Slot(nullptr, nullptr, nullptr, Outcome::QUEUE_FULL);
+      }
+      drop(*lowest, Outcome::QUEUE_FULL);
+    }
+
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    entry->request = std::move(request);
+    entry->key = key;
+    entry->priority = priority;
+    entry->sequence = next_sequence_++;
+    entry->deadline = deadline;
+    queued_.push_back(entry);
+
+    bool in_time = waitFor(lock, deadline, [this, &entry]() { return entry->dropped || isNext(entry); });
+    if (entry->dropped)
+    {
+      return Slot(nullptr, nullptr, nullptr, entry->drop_reason);
+    }
+
+    // the wait may have pushed the expected completion past the deadline
+    Clock::time_point now = Clock::now();
+    if (!in_time || now + toDuration(service_time_) > deadline)
+    {
+      drop(entry, Outcome::DEADLINE);
+      return Slot(nullptr, nullptr, nullptr, Outcome::DEADLINE);
+    }
+
+    queued_.erase(std::find(queued_.begin(), queued_.end(), entry));
+    entry->start = now;
+    running_.push_back(entry);
+    return Slot(this, entry, std::move(response), Outcome::RUN);
+  }
+
+  std::size_t getMaxDepth() const { return max_depth_; }
+
+  std::size_t getQueued() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queued_.size();
+  }
+
+  /**
+   * @brief moving average of the seconds spent processing a request
+   */
+  double getServiceTime() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return service_time_;
+  }
+
+private:
+  static Clock::duration toDuration(double seconds)
+  {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  }
+
+  template <typename PredicateT>
+  bool waitFor(std::unique_lock<std::mutex>& lock, Clock::time_point deadline, PredicateT predicate)
+  {
+    if (deadline == Clock::time_point::max())
+    {
+      cv_.wait(lock, predicate);
+      return true;
+    }
+    return cv_.wait_until(lock, deadline, predicate);
+  }
+
+  /**
+   * @brief callers blocked in the queue besides the running ones
+   */
+  std::size_t getNumWaiting() const { return queued_.size() + num_coalesced_; }
+
+  std::shared_ptr<Entry> findSame(const RequestT& request, std::uint64_t key) const
+  {
+    for (const std::vector<std::shared_ptr<Entry>>* entries : { &running_, &queued_ })
+    {
+      for (const std::shared_ptr<Entry>& entry : *entries)
+      {
+        if (entry->key == key && same_request_(*entry->request, request))
+        {
+          return entry;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief the requests ahead are processed in rounds of concurrency_ requests that each take the average service time
+   */
+  Clock::time_point expectedCompletion(int priority) const
+  {
+    std::size_t ahead = running_.size();
+    for (const std::shared_ptr<Entry>& entry : queued_)
+    {
+      ahead += entry->priority >= priority ? 1 : 0;
+    }
+    return Clock::now() + toDuration(service_time_ * static_cast<double>(ahead / concurrency_ + 1));
+  }
+
+  bool isNext(const std::shared_ptr<Entry>& entry) const
+  {
+    if (running_.size() >= concurrency_)
+    {
+      return false;
+    }
+    for (const std::shared_ptr<Entry>& other : queued_)
+    {
+      bool ahead = other->priority > entry->priority ||
+                   (other->priority == entry->priority && other->sequence < entry->sequence);
+      if (ahead)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void drop(const std::shared_ptr<Entry>& entry, Outcome reason)
+  {
+    entry->dropped = true;
+    entry->drop_reason = reason;
+    queued_.erase(std::find(queued_.begin(), queued_.end(), entry));
+    cv_.notify_all();
+  }
+
+  void finish(const std::shared_ptr<Entry>& entry, std::shared_ptr<const ResponseT> response)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double ALPHA = 0.2;
+    double seconds = std::chrono::duration<double>(Clock::now() - entry->start).count();
+    service_time_ = service_time_ > 0.0 ? (1.0 - ALPHA) * service_time_ + ALPHA * seconds : seconds;
+    entry->response = std::move(response);
+    entry->done = true;
+    running_.erase(std::find(running_.begin(), running_.end(), entry));
+    cv_.notify_all();
+  }
+
+  std::size_t max_depth_;
+  std::size_t concurrency_;
+  SameRequestFn same_request_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::shared_ptr<Entry>> queued_;
+  std::vector<std::shared_ptr<Entry>> running_;
+  std::uint64_t next_sequence_;
+  std::size_t num_coalesced_; /** @brief callers waiting for an identical request */
+  double service_time_; /** @brief seconds, 0 until the first request completes */
+};
+
+}  // namespace region_detection_rclcpp
+
+#endif /* INCLUDE_REGION_DETECTION_RCLCPP_REQUEST_QUEUE_H_ */
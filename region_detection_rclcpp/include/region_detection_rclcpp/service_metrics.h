@@ -0,0 +1,171 @@
+/*
+ * @file service_metrics.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_RCLCPP_SERVICE_METRICS_H_
+#define INCLUDE_REGION_DETECTION_RCLCPP_SERVICE_METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
+namespace region_detection_rclcpp
+{
+/**
+ * @class region_detection_rclcpp::LatencyHistogram
+ * @brief Histogram with log-linear buckets in the manner of HdrHistogram, each power of two range is split into 16
+ * buckets so that the recorded values keep about 6% of relative precision at any magnitude.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram();
+
+  void record(std::uint64_t value);
+  void reset();
+
+  std::uint64_t getCount() const;
+  std::uint64_t getMin() const;
+  std::uint64_t getMax() const;
+  double getMean() const;
+
+  /**
+   * @brief highest value in the bucket that contains the percentile
+   * @param percentile In the range [0, 100]
+   */
+  std::uint64_t getPercentile(double percentile) const;
+
+private:
+  static std::size_t bucketIndex(std::uint64_t value);
+  static std::uint64_t bucketUpperBound(std::size_t index);
+
+  std::vector<std::uint64_t> counts_;
+  std::uint64_t count_;
+  std::uint64_t min_;
+  std::uint64_t max_;
+  double sum_;
+};
+
+/**
+ * @class region_detection_rclcpp::ServiceMetrics
+ * @brief Collects the end-to-end and per stage latencies, the request sizes, the failures and the requests in flight of
+ * a service.  A summary is published periodically on the /diagnostics topic and optionally appended to a file.
+ *
+ * Parameters read from the node:
+ *  - metrics.publish_period: seconds between summaries, 0 disables the publication (default 1.0)
+ *  - metrics.file: file the summaries are appended to, empty disables it (default "")
+ *  - metrics.file_period: seconds between the summaries written to the file (defaults to the publish period or 1.0
+ *    when the publication is disabled)
+ */
+class ServiceMetrics
+{
+public:
+  /**
+   * @class region_detection_rclcpp::ServiceMetrics::RequestScope
+   * @brief Counts a request as in flight until it goes out of scope, at which point its latency is recorded along with
+   * its outcome.  Requests are considered failed unless marked otherwise.
+   */
+  class RequestScope
+  {
+  public:
+    RequestScope(RequestScope&& other);
+    RequestScope(const RequestScope&) = delete;
+    RequestScope& operator=(const RequestScope&) = delete;
+    ~RequestScope();
+
+    void setSucceeded(bool succeeded);
+
+  private:
+    friend class ServiceMetrics;
+    explicit RequestScope(ServiceMetrics* metrics);
+
+    ServiceMetrics* metrics_;
+    std::chrono::steady_clock::time_point start_;
+    bool succeeded_;
+  };
+
+  /**
+   * @param node        The node that owns the service
+   * @param service     Name of the service, used to label the diagnostic status
+   * @param size_units  Units of the request sizes, e.g. "bytes"
+   */
+  ServiceMetrics(std::shared_ptr<rclcpp::Node> node, const std::string& service, const std::string& size_units);
+
+  RequestScope startRequest(std::uint64_t request_size);
+
+  /**
+   * @brief records the duration of a processing stage
+   * @param stage   The stage name
+   * @param seconds The duration
+   */
+  void recordStage(const std::string& stage, double seconds);
+
+  diagnostic_msgs::msg::DiagnosticStatus getStatus();
+
+private:
+  void finishRequest(const std::chrono::steady_clock::time_point& start, bool succeeded);
+  void publish();
+  void writeFile();
+
+  std::shared_ptr<rclcpp::Node> node_;
+  std::string service_;
+  std::string size_units_;
+
+  std::mutex mutex_;
+  LatencyHistogram latency_;
+  LatencyHistogram request_sizes_;
+  std::map<std::string, LatencyHistogram> stage_latencies_;
+  std::uint64_t num_requests_;
+  std::uint64_t num_failures_;
+  std::atomic<int> in_flight_;
+  int max_in_flight_;
+
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub_;
+  rclcpp::TimerBase::SharedPtr publish_timer_;
+  rclcpp::TimerBase::SharedPtr file_timer_;
+  std::ofstream file_;
+};
+
+}  // namespace region_detection_rclcpp
+
+#endif /* INCLUDE_REGION_DETECTION_RCLCPP_SERVICE_METRICS_H_ */
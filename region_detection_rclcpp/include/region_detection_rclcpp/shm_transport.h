@@ -0,0 +1,183 @@
+/*
+ * @file shm_transport.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_RCLCPP_SHM_TRANSPORT_H_
+#define INCLUDE_REGION_DETECTION_RCLCPP_SHM_TRANSPORT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <region_detection_core/region_detector.h>
+
+namespace region_detection_rclcpp
+{
+/**
+ * @class region_detection_rclcpp::SharedMemory
+ * @brief A POSIX shared memory object mapped into the address space of the process, it is unmapped on destruction
+ * and removed as well when this process created it.
+ */
+class SharedMemory
+{
+public:
+  ~SharedMemory();
+
+  /**
+   * @brief creates a new shared memory object, fails when the name is already in use
+   */
+  static std::shared_ptr<SharedMemory> create(const std::string& name, std::size_t size, std::string& err_msg);
+
+  /**
+   * @brief maps an existing shared memory object, the size is read from the object
+   */
+  static std::shared_ptr<SharedMemory> open(const std::string& name, std::string& err_msg);
+
+  /**
+   * @brief removes the name so that the memory is released once every process has unmapped it
+   */
+  void unlink();
+
+  /**
+   * @brief removes the name of a shared memory object that may not exist, e.g. one left by a worker that was killed
+   */
+  static void remove(const std::string& name);
+
+  /**
+   * @brief keeps the object after this process unmaps it, used to hand it over to another process
+   */
+  void detach() { owner_ = false; }
+
+  const std::string& getName() const { return name_; }
+  std::uint8_t* getData() const { return data_; }
+  std::size_t getSize() const { return size_; }
+
+private:
+  SharedMemory(const std::string& name, std::uint8_t* data, std::size_t size, bool owner);
+
+  std::string name_;
+  std::uint8_t* data_;
+  std::size_t size_;
+  bool owner_;
+};
+
+/**
+ * @brief sent to a worker process through its job pipe, the request is in the named shared memory
+ */
+struct WorkerJob
+{
+  std::uint64_t id;
+  std::uint64_t size;
+  char shm_name[64];
+};
+
+/**
+ * @brief name of the shared memory object a worker leaves the results of a job in
+ */
+std::string getResultsShmName(const std::string& job_shm_name);
+
+/**
+ * @brief sent back by a worker process through its reply pipe once the results are in the named shared memory
+ */
+struct WorkerReply
+{
+  std::uint64_t id;
+  std::uint64_t size;
+  char shm_name[64];
+};
+
+/**
+ * @brief writes the whole message to a pipe
+ * @return False when the pipe is closed
+ */
+bool writeMessage(int fd, const void* msg, std::size_t size);
+
+/**
+ * @brief reads a whole message from a pipe
+ * @param timeout_ms  Milliseconds to wait for the message, values less or equal to 0 wait indefinitely
+ * @return 1 when the message was read, 0 when the pipe was closed and -1 on timeout or error
+ */
+int readMessage(int fd, void* msg, std::size_t size, int timeout_ms = 0);
+
+/**
+ * @brief writes the configuration and the data bundles of a detection request with their raw image and cloud buffers
+ * @param config  The yaml configuration of the detector
+ * @param input   The data bundles
+ * @param dst     Destination of the request, nullptr only computes the size needed
+ * @return The number of bytes written
+ */
+std::size_t writeRequest(const std::string& config,
+                         const region_detection_core::RegionDetector::DataBundleVec& input,
+                         std::uint8_t* dst);
+
+/**
+ * @brief reads a request written by writeRequest, the images point into the source memory which must outlive them
+ * @return False when the request is truncated or malformed
+ */
+bool readRequest(const std::uint8_t* src,
+                 std::size_t size,
+                 std::string& config,
+                 region_detection_core::RegionDetector::DataBundleVec& input);
+
+/**
+ * @brief the detect_regions responses only carry the closed regions so the open regions, images and contours are
+ * not produced, used by the server and its workers alike
+ */
+region_detection_core::RegionDetectionConfig restrictOutputs(region_detection_core::RegionDetectionConfig config);
+
+/**
+ * @brief writes the regions and stage durations of a detection, the images of the results are not transferred
+ * @param succeeded The value returned by RegionDetector::compute
+ * @param err_msg   Reason of the failure, if any
+ * @param results   The detection results
+ * @param dst       Destination of the results, nullptr only computes the size needed
+ * @return The number of bytes written
+ */
+std::size_t writeResults(bool succeeded,
+                         const std::string& err_msg,
+                         const region_detection_core::RegionDetector::RegionResults& results,
+                         std::uint8_t* dst);
+
+/**
+ * @brief reads the results written by writeResults
+ * @return False when the results are truncated or malformed
+ */
+bool readResults(const std::uint8_t* src,
+                 std::size_t size,
+                 bool& succeeded,
+                 std::string& err_msg,
+                 region_detection_core::RegionDetector::RegionResults& results);
+
+}  // namespace region_detection_rclcpp
+
+#endif /* INCLUDE_REGION_DETECTION_RCLCPP_SHM_TRANSPORT_H_ */
@@ -0,0 +1,114 @@
+/*
+ * @file worker_pool.h
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INCLUDE_REGION_DETECTION_RCLCPP_WORKER_POOL_H_
+#define INCLUDE_REGION_DETECTION_RCLCPP_WORKER_POOL_H_
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <region_detection_core/region_detector.h>
+
+namespace region_detection_rclcpp
+{
+/**
+ * @class region_detection_rclcpp::WorkerPool
+ * @brief Runs the region detection in separate worker processes so that several requests are processed concurrently
+ * and a crash only fails the request being processed.  The data is passed through POSIX shared memory and the
+ * workers are signaled through pipes, a worker that crashes or times out is restarted on its next use.
+ */
+class WorkerPool
+{
+public:
+  /**
+   * @brief starts the workers
+   * @param executable  Path to the region_detector_worker executable
+   * @param num_workers Number of worker processes
+   * @param timeout     Seconds a worker is given to complete a request before it is killed, 0 waits indefinitely
+   * @param logger      Logger of the node
+   */
+  WorkerPool(const std::string& executable, std::size_t num_workers, double timeout, rclcpp::Logger logger);
+  ~WorkerPool();
+
+  /**
+   * @brief runs the detection on the next idle worker, blocks until one is available
+   * @param config    The yaml configuration of the detector
+   * @param input     The data bundles
+   * @param results   (Output) The regions found, the images are not returned
+   * @param detected  (Output) The value returned by RegionDetector::compute
+   * @param err_msg   (Output) The reason the worker failed to process the request
+   * @return False when the worker failed, true otherwise
+   */
+  bool compute(const std::string& config,
+               const region_detection_core::RegionDetector::DataBundleVec& input,
+               region_detection_core::RegionDetector::RegionResults& results,
+               bool& detected,
+               std::string& err_msg);
+
+  std::size_t getNumWorkers() const { return workers_.size(); }
+
+private:
+  struct Worker
+  {
+    pid_t pid = -1;
+    int job_fd = -1;   /** @brief write end of the pipe the jobs are sent through */
+    int reply_fd = -1; /** @brief read end of the pipe the replies are received from */
+  };
+
+  bool spawn(Worker& worker, std::string& err_msg);
+  void terminate(Worker& worker, const std::string& reason);
+  std::size_t acquire();
+  void release(std::size_t index);
+
+  std::string executable_;
+  int timeout_ms_;
+  rclcpp::Logger logger_;
+  std::vector<Worker> workers_;
+  std::deque<std::size_t> idle_;
+  std::mutex mutex_;
+  std::condition_variable idle_cv_;
+  std::atomic<std::uint64_t> next_job_id_;
+};
+
+}  // namespace region_detection_rclcpp
+
+#endif /* INCLUDE_REGION_DETECTION_RCLCPP_WORKER_POOL_H_ */
@@ -47,6 +47,8 @@
 
 #include <region_detection_core/region_crop.h>
 
+#include "region_detection_rclcpp/service_metrics.h"
+
 static const std::string CROP_DATA_SERVICE = "crop_data";
 
 class CropDataServer
@@ -63,6 +65,8 @@ public:
                                                                              std::placeholders::_2,
                                                                              std::placeholders::_3));
 
+    metrics_ = std::make_shared<region_detection_rclcpp::ServiceMetrics>(node, CROP_DATA_SERVICE, "poses");
+
     // check parameters
     loadRegionCropConfig();
   }
@@ -101,6 +105,13 @@ private:
 
     (void)request_header;
 
+    std::uint64_t request_size = 0;
+    for (const geometry_msgs::msg::PoseArray& segment_poses : request->input_data)
+    {
+      request_size += segment_poses.poses.size();
+    }
+    region_detection_rclcpp::ServiceMetrics::RequestScope request_metrics = metrics_->startRequest(request_size);
+
     // use detected regions to crop
     RegionCropConfig region_crop_cfg = loadRegionCropConfig();
     RegionCrop<pcl::PointXYZ> region_crop;
@@ -139,8 +150,11 @@ private:
                          return p;
                        });
 
+        std::chrono::steady_clock::time_point start_filter = std::chrono::steady_clock::now();
         region_crop.setInput(segments_points);
         std::vector<int> inlier_indices = region_crop.filter();
+        metrics_->recordStage("filter",
+                              std::chrono::duration<double>(std::chrono::steady_clock::now() - start_filter).count());
 
         if (inlier_indices.empty())
         {
@@ -163,15 +177,18 @@ private:
       response->succeeded = false;
       response->err_msg = "Failed to crop toolpaths";
       RCLCPP_ERROR_STREAM(logger_, response->err_msg);
+      return;
     }
 
     response->succeeded = true;
+    request_metrics.setSucceeded(true);
   }
 
   // ros interfaces
   rclcpp::Service<region_detection_msgs::srv::CropData>::SharedPtr crop_data_server_;
   std::shared_ptr<rclcpp::Node> node_;
   rclcpp::Logger logger_;
+  std::shared_ptr<region_detection_rclcpp::ServiceMetrics> metrics_;
 };
 
 int main(int argc, char** argv)
@@ -33,25 +33,53 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
 #include <rclcpp/rclcpp.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
 
+#include <region_detection_msgs/action/detect_regions.hpp>
 #include <region_detection_msgs/srv/detect_regions.hpp>
+#include <region_detection_msgs/srv/extract_curves.hpp>
 
 #include <visualization_msgs/msg/marker_array.hpp>
 
 #include <cv_bridge/cv_bridge.h>
 
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
 #include <tf2_eigen/tf2_eigen.h>
 
 #include <pcl/io/pcd_io.h>
 
 #include <pcl_conversions/pcl_conversions.h>
 
+#include <boost/make_shared.hpp>
+
 #include <region_detection_core/region_detector.h>
 
+#include "region_detection_rclcpp/request_queue.h"
+#include "region_detection_rclcpp/service_metrics.h"
+#include "region_detection_rclcpp/worker_pool.h"
+
 static const std::string REGION_MARKERS_TOPIC = "detected_regions";
 static const std::string DETECT_REGIONS_SERVICE = "detect_regions";
+static const std::string EXTRACT_CURVES_SERVICE = "extract_curves";
+static const std::string DETECT_REGIONS_ACTION = "detect_regions";
 static const std::string CLOSED_REGIONS_NS = "closed_regions";
+static const std::string WORKER_EXECUTABLE = "region_detector_worker";
 
 typedef std::vector<Eigen::Isometry3d, Eigen::aligned_allocator<Eigen::Isometry3d> > EigenPose3dVector;
 
@@ -193,6 +221,366 @@ convertToDottedLineMarker(const std::vector<EigenPose3dVector>& path,
   return markers_msgs;
 }
 
+/**
+ * @brief reads the image size from the header of a PNG or JPEG stream
+ * @return False when the format is not recognized
+ */
+static bool readCompressedImageSize(const std::vector<uint8_t>& data, int& width, int& height)
+{
+  auto read_be = [&data](std::size_t pos, std::size_t num_bytes) -> int {
+    int value = 0;
+    for (std::size_t i = 0; i < num_bytes; i++)
+    {
+      value = (value << 8) | data[pos + i];
+    }
+    return value;
+  };
+
+  // png, the IHDR chunk follows the 8 bytes signature
+  static const std::vector<uint8_t> PNG_SIGNATURE = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  if (data.size() >= 24 && std::equal(PNG_SIGNATURE.begin(), PNG_SIGNATURE.end(), data.begin()))
+  {
+    width = read_be(16, 4);
+    height = read_be(20, 4);
+    return true;
+  }
+
+  // jpeg, walking the segments until a start of frame marker
+  if (data.size() < 4 || data[0] != 0xFF || data[1] != 0xD8)
+  {
+    return false;
+  }
+  std::size_t pos = 2;
+  while (pos + 9 < data.size())
+  {
+    if (data[pos] != 0xFF)
+    {
+      return false;
+    }
+    uint8_t marker = data[pos + 1];
+    if (marker == 0xFF)
+    {
+      pos++;
+      continue;
+    }
+    bool start_of_frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+    if (start_of_frame)
+    {
+      height = read_be(pos + 5, 2);
+      width = read_be(pos + 7, 2);
+      return true;
+    }
+    pos += 2 + read_be(pos + 2, 2);
+  }
+  return false;
+}
+
+/**
+ * @brief decodes a compressed image with the same channel order as the raw images.  The image is converted to the
+ * grayscale the first 2d stage would produce from the raw image when that stage converts to grayscale, and it is decoded
+ * at reduced scale when the organized cloud has a half, a quarter or an eighth of its resolution so that both match.
+ * @param msg           The compressed image
+ * @param grayscale     True to return a single channel image
+ * @param cloud_width   Width of the organized cloud
+ * @param cloud_height  Height of the organized cloud
+ * @return The decoded image, empty on failure
+ */
+static cv::Mat decodeCompressedImage(const sensor_msgs::msg::CompressedImage& msg,
+                                     bool grayscale,
+                                     int cloud_width,
+                                     int cloud_height)
+{
+  static const std::map<int, int> REDUCED_FLAGS = { { 1, cv::IMREAD_COLOR },
+                                                    { 2, cv::IMREAD_REDUCED_COLOR_2 },
+                                                    { 4, cv::IMREAD_REDUCED_COLOR_4 },
+                                                    { 8, cv::IMREAD_REDUCED_COLOR_8 } };
+
+  int scale = 1;
+  int width, height;
+  if (readCompressedImageSize(msg.data, width, height))
+  {
+    for (const auto& kv : REDUCED_FLAGS)
+    {
+      if (width == cloud_width * kv.first && height == cloud_height * kv.first)
+      {
+        scale = kv.first;
+      }
+    }
+  }
+
+  cv::Mat decoded = cv::imdecode(msg.data, REDUCED_FLAGS.at(scale));
+  if (decoded.empty())
+  {
+    return decoded;
+  }
+
+  // the raw images are converted to RGBA8 and the GRAYSCALE method then weighs their channels as BGR, the decoder's
+  // own grayscale would use different weights and threshold differently
+  cv::Mat image;
+  cv::cvtColor(decoded, image, grayscale ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2RGBA);
+  return image;
+}
+
+/**
+ * @brief true when every 2d branch starts by converting the input image to grayscale
+ */
+static bool startsWithGrayscale(const region_detection_core::RegionDetectionConfig& config)
+{
+  const std::string grayscale_method = "GRAYSCALE";
+  const region_detection_core::RegionDetectionConfig::OpenCVCfg& opencv_cfg = config.opencv_cfg;
+  if (opencv_cfg.graph.nodes.empty())
+  {
+    return !opencv_cfg.methods.empty() && opencv_cfg.methods.front() == grayscale_method;
+  }
+
+  bool reads_input = false;
+  for (const region_detection_core::config_2d::StageNodeCfg& node : opencv_cfg.graph.nodes)
+  {
+    if (std::find(node.inputs.begin(), node.inputs.end(), "input") == node.inputs.end())
+    {
+      continue;
+    }
+    if (node.methods.empty() || node.methods.front() != grayscale_method)
+    {
+      return false;
+    }
+    reads_input = true;
+  }
+  return reads_input;
+}
+
+/**
+ * @brief converts the images, clouds and transforms of a DetectRegions or ExtractCurves request into data bundles
+ * @param request   The request
+ * @param grayscale True to decode the compressed images as single channel images
+ * @param data_vec  (Output) The data bundles
+ * @param err_msg   (Output) The reason of the failure
+ * @return False when the request is invalid
+ */
+template <typename RequestT>
+static bool convertRequest(const RequestT& request,
+                           bool grayscale,
+                           region_detection_core::RegionDetector::DataBundleVec& data_vec,
+                           std::string& err_msg)
+{
+  using namespace region_detection_core;
+
+  // compressed images take precedence over the raw ones
+  const bool compressed = !request.compressed_images.empty();
+  std::size_t num_images = compressed ? request.compressed_images.size() : request.images.size();
+  if (num_images != request.clouds.size() || request.transforms.size() != request.clouds.size())
+  {
+    err_msg = "The number of images, clouds and transforms must be the same";
+    return false;
+  }
+
+  for (std::size_t i = 0; i < request.clouds.size(); i++)
+  {
+    RegionDetector::DataBundle data;
+    pcl_conversions::toPCL(request.clouds[i], data.cloud_blob);
+    if (compressed)
+    {
+      data.image = decodeCompressedImage(request.compressed_images[i],
+                                         grayscale,
+                                         static_cast<int>(request.clouds[i].width),
+                                         static_cast<int>(request.clouds[i].height));
+      if (data.image.empty())
+      {
+        err_msg = "Failed to decode compressed image " + std::to_string(i);
+        return false;
+      }
+    }
+    else
+    {
+      cv_bridge::CvImagePtr img = cv_bridge::toCvCopy(request.images[i], sensor_msgs::image_encodings::RGBA8);
+      data.image = img->image;
+    }
+    data.transform = tf2::transformToEigen(request.transforms[i]);
+    data_vec.push_back(std::move(data));
+  }
+  return true;
+}
+
+/**
+ * @brief hash of the images, clouds and transforms of a request, the headers are left out
+ */
+static std::uint64_t hashRequestData(const region_detection_msgs::srv::DetectRegions::Request& request)
+{
+  // FNV-1a over 8 byte words
+  const std::uint64_t PRIME = 1099511628211ULL;
+  std::uint64_t hash = 14695981039346656037ULL;
+  auto add_bytes = [&hash, PRIME](const void* data, std::size_t size) {
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+    {
+      std::uint64_t word;
+      std::memcpy(&word, bytes + i, sizeof(word));
+      hash = (hash ^ word) * PRIME;
+    }
+    for (; i < size; i++)
+    {
+      hash = (hash ^ bytes[i]) * PRIME;
+    }
+    hash = (hash ^ size) * PRIME;
+  };
+
+  for (const sensor_msgs::msg::Image& image : request.images)
+  {
+    add_bytes(image.data.data(), image.data.size());
+  }
+  for (const sensor_msgs::msg::CompressedImage& image : request.compressed_images)
+  {
+    add_bytes(image.data.data(), image.data.size());
+  }
+  for (const sensor_msgs::msg::PointCloud2& cloud : request.clouds)
+  {
+    add_bytes(cloud.data.data(), cloud.data.size());
+  }
+  for (const geometry_msgs::msg::TransformStamped& transform : request.transforms)
+  {
+    const geometry_msgs::msg::Vector3& t = transform.transform.translation;
+    const geometry_msgs::msg::Quaternion& q = transform.transform.rotation;
+    const double values[] = { t.x, t.y, t.z, q.x, q.y, q.z, q.w };
+    add_bytes(values, sizeof(values));
+  }
+  return hash;
+}
+
+/**
+ * @brief true when two requests carry the same images, clouds and transforms, the stamps are ignored
+ */
+static bool sameRequestData(const region_detection_msgs::srv::DetectRegions::Request& a,
+                            const region_detection_msgs::srv::DetectRegions::Request& b)
+{
+  auto same = [](const auto& va, const auto& vb, auto equal) {
+    return va.size() == vb.size() && std::equal(va.begin(), va.end(), vb.begin(), equal);
+  };
+  return same(a.images,
+              b.images,
+              [](const sensor_msgs::msg::Image& ia, const sensor_msgs::msg::Image& ib) {
+                return ia.width == ib.width && ia.height == ib.height && ia.encoding == ib.encoding &&
+                       ia.data == ib.data;
+              }) &&
+         same(a.compressed_images,
+              b.compressed_images,
+              [](const sensor_msgs::msg::CompressedImage& ia, const sensor_msgs::msg::CompressedImage& ib) {
+                return ia.format == ib.format && ia.data == ib.data;
+              }) &&
+         same(a.clouds,
+              b.clouds,
+              [](const sensor_msgs::msg::PointCloud2& ca, const sensor_msgs::msg::PointCloud2& cb) {
+                return ca.width == cb.width && ca.height == cb.height && ca.point_step == cb.point_step &&
+                       ca.fields == cb.fields && ca.data == cb.data;
+              }) &&
+         same(a.transforms,
+              b.transforms,
+              [](const geometry_msgs::msg::TransformStamped& ta, const geometry_msgs::msg::TransformStamped& tb) {
+                return ta.header.frame_id == tb.header.frame_id && ta.child_frame_id == tb.child_frame_id &&
+                       ta.transform == tb.transform;
+              });
+}
+
+/**
+ * @brief packs the 3d curves of a bundle into flat arrays, the images and pixel contours are left out
+ */
+static region_detection_msgs::msg::BundleCurves
+toBundleCurvesMsg(const region_detection_core::RegionDetector::BundleCurves& curves)
+{
+  region_detection_msgs::msg::BundleCurves msg;
+  auto pack_curves = [](const std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& clouds,
+                        std::vector<float>& points,
+                        std::vector<uint32_t>& sizes) {
+    for (const auto& cloud : clouds)
+    {
+      sizes.push_back(static_cast<uint32_t>(cloud->size()));
+      for (const pcl::PointXYZ& p : *cloud)
+      {
+        points.insert(points.end(), { p.x, p.y, p.z });
+      }
+    }
+  };
+  pack_curves(curves.closed_curves, msg.closed_points, msg.closed_sizes);
+  pack_curves(curves.open_curves, msg.open_points, msg.open_sizes);
+
+  for (const auto& cloud : curves.normals)
+  {
+    msg.normals_sizes.push_back(static_cast<uint32_t>(cloud->size()));
+    for (const pcl::PointNormal& p : *cloud)
+    {
+      msg.normals.insert(msg.normals.end(), { p.x, p.y, p.z, p.normal_x, p.normal_y, p.normal_z, p.curvature });
+    }
+  }
+
+  for (const auto& kv : curves.durations)
+  {
+    msg.stage_names.push_back(kv.first);
+    msg.stage_durations.push_back(kv.second);
+  }
+  return msg;
+}
+
+/**
+ * @brief unpacks the curves packed by toBundleCurvesMsg
+ * @return False when the sizes do not match the number of points
+ */
+static bool fromBundleCurvesMsg(const region_detection_msgs::msg::BundleCurves& msg,
+                                region_detection_core::RegionDetector::BundleCurves& curves)
+{
+  auto unpack_curves = [](const std::vector<float>& points,
+                          const std::vector<uint32_t>& sizes,
+                          std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr>& clouds) -> bool {
+    std::size_t idx = 0;
+    for (uint32_t size : sizes)
+    {
+      if (idx + 3 * static_cast<std::size_t>(size) > points.size())
+      {
+        return false;
+      }
+      pcl::PointCloud<pcl::PointXYZ>::Ptr cloud = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+      cloud->reserve(size);
+      for (uint32_t i = 0; i < size; i++, idx += 3)
+      {
+        cloud->push_back(pcl::PointXYZ(points[idx], points[idx + 1], points[idx + 2]));
+      }
+      clouds.push_back(cloud);
+    }
+    return idx == points.size();
+  };
+  if (!unpack_curves(msg.closed_points, msg.closed_sizes, curves.closed_curves) ||
+      !unpack_curves(msg.open_points, msg.open_sizes, curves.open_curves))
+  {
+    return false;
+  }
+
+  std::size_t idx = 0;
+  for (uint32_t size : msg.normals_sizes)
+  {
+    if (idx + 7 * static_cast<std::size_t>(size) > msg.normals.size())
+    {
+      return false;
+    }
+    pcl::PointCloud<pcl::PointNormal>::Ptr cloud = boost::make_shared<pcl::PointCloud<pcl::PointNormal>>();
+    cloud->reserve(size);
+    for (uint32_t i = 0; i < size; i++, idx += 7)
+    {
+      pcl::PointNormal p;
+      std::tie(p.x, p.y, p.z) = std::make_tuple(msg.normals[idx], msg.normals[idx + 1], msg.normals[idx + 2]);
+      std::tie(p.normal_x, p.normal_y, p.normal_z) =
+          std::make_tuple(msg.normals[idx + 3], msg.normals[idx + 4], msg.normals[idx + 5]);
+      p.curvature = msg.normals[idx + 6];
+      cloud->push_back(p);
+    }
+    curves.normals.push_back(cloud);
+  }
+
+  for (std::size_t i = 0; i < msg.stage_names.size() && i < msg.stage_durations.size(); i++)
+  {
+    curves.durations[msg.stage_names[i]] = msg.stage_durations[i];
+  }
+  return idx == msg.normals.size();
+}
+
 class RegionDetectorServer
 {
 public:
@@ -200,6 +588,52 @@ public:
     : node_(node), logger_(node->get_logger()), marker_pub_timer_(nullptr)
   {
     // load parameters
+    int num_workers;
+    double worker_timeout;
+    std::string worker_executable;
+    node->get_parameter_or("worker_pool.num_workers", num_workers, 0);
+    node->get_parameter_or("worker_pool.timeout", worker_timeout, 0.0);
+    node->get_parameter_or("worker_pool.executable", worker_executable, getDefaultWorkerExecutable());
+    std::vector<std::string> curves_workers;
+    node->get_parameter_or("coordinator.workers", curves_workers, {});
+    node->get_parameter_or("coordinator.timeout", coordinator_timeout_, 30.0);
+    node->get_parameter_or("debug.save_inputs", save_inputs_, false);
+    int queue_depth;
+    std::vector<std::string> clients;
+    std::vector<int64_t> priorities;
+    node->get_parameter_or("admission.queue_depth", queue_depth, 0);
+    node->get_parameter_or("admission.clients", clients, {});
+    node->get_parameter_or("admission.priorities", priorities, {});
+    node->get_parameter_or("admission.default_priority", default_priority_, 0);
+    node->get_parameter_or("admission.default_timeout", default_timeout_, 0.0);
+    if (clients.size() != priorities.size())
+    {
+      throw std::runtime_error("admission.clients and admission.priorities must have the same size");
+    }
+    for (std::size_t i = 0; i < clients.size(); i++)
+    {
+      client_priorities_[clients[i]] = static_cast<int>(priorities[i]);
+    }
+
+    // with a worker pool the requests are served concurrently
+    rclcpp::CallbackGroup::SharedPtr callback_group;
+    if (num_workers > 0)
+    {
+      worker_pool_ = std::make_shared<region_detection_rclcpp::WorkerPool>(
+          worker_executable, static_cast<std::size_t>(num_workers), worker_timeout, logger_);
+    }
+
+    // with the admission queue the waiting requests also hold a callback thread
+    if (queue_depth > 0)
+    {
+      request_queue_ = std::make_shared<DetectRegionsQueue>(
+          static_cast<std::size_t>(queue_depth), getConcurrency(), &sameRequestData);
+      RCLCPP_INFO(logger_, "Admission queue of %i requests", queue_depth);
+    }
+    if (worker_pool_ || request_queue_)
+    {
+      callback_group = node->create_callback_group(rclcpp::CallbackGroupType::Reentrant);
+    }
 
     // creating service
     detect_regions_server_ = node->create_service<region_detection_msgs::srv::DetectRegions>(
@@ -208,28 +642,149 @@ public:
                   this,
                   std::placeholders::_1,
                   std::placeholders::_2,
-                  std::placeholders::_3));
+                  std::placeholders::_3),
+        rmw_qos_profile_services_default,
+        callback_group);
+
+    extract_curves_server_ = node->create_service<region_detection_msgs::srv::ExtractCurves>(
+        EXTRACT_CURVES_SERVICE,
+        std::bind(&RegionDetectorServer::extractCurvesCallback,
+                  this,
+                  std::placeholders::_1,
+                  std::placeholders::_2,
+                  std::placeholders::_3),
+        rmw_qos_profile_services_default,
+        callback_group);
+
+    // in coordinator mode the bundles are sent to the extract_curves service of the worker nodes, their responses are
+    // handled in a separate group while the detect_regions callback waits for them
+    if (!curves_workers.empty())
+    {
+      rclcpp::CallbackGroup::SharedPtr clients_group =
+          node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+      for (const std::string& worker : curves_workers)
+      {
+        curves_clients_.push_back(node->create_client<region_detection_msgs::srv::ExtractCurves>(
+            worker + "/" + EXTRACT_CURVES_SERVICE, rmw_qos_profile_services_default, clients_group));
+      }
+      RCLCPP_INFO(logger_, "Coordinating %lu detector nodes", curves_clients_.size());
+    }
+
+    // the goals are computed in their own thread so that a newer goal can be accepted and preempt the active one
+    detect_regions_action_server_ = rclcpp_action::create_server<DetectRegionsAction>(
+        node,
+        DETECT_REGIONS_ACTION,
+        std::bind(&RegionDetectorServer::handleGoal, this, std::placeholders::_1, std::placeholders::_2),
+        std::bind(&RegionDetectorServer::handleCancel, this, std::placeholders::_1),
+        std::bind(&RegionDetectorServer::handleAccepted, this, std::placeholders::_1),
+        rcl_action_server_get_default_options(),
+        node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive));
 
     region_markers_pub_ =
         node->create_publisher<visualization_msgs::msg::MarkerArray>(REGION_MARKERS_TOPIC, rclcpp::QoS(1));
 
+    metrics_ = std::make_shared<region_detection_rclcpp::ServiceMetrics>(node, DETECT_REGIONS_SERVICE, "bytes");
+
     // run this for verification of parameters
     loadRegionDetectionConfig();
   }
 
-  ~RegionDetectorServer() {}
+  ~RegionDetectorServer()
+  {
+    std::lock_guard<std::mutex> lock(goal_mutex_);
+    if (active_goal_preempted_)
+    {
+      active_goal_preempted_->store(true);
+    }
+    if (goal_thread_.joinable())
+    {
+      goal_thread_.join();
+    }
+  }
+
+  /**
+   * @brief number of requests that can be served at the same time
+   */
+  std::size_t getConcurrency() const { return worker_pool_ ? worker_pool_->getNumWorkers() : 1; }
+
+  /**
+   * @brief threads needed by the service callbacks, the queued requests or those waiting for an identical one, and one
+   * more that turns away the requests arriving when the queue is full
+   */
+  std::size_t getServiceThreads() const
+  {
+    return getConcurrency() + (request_queue_ ? request_queue_->getMaxDepth() + 1 : 0);
+  }
 
 private:
+  using DetectRegionsAction = region_detection_msgs::action::DetectRegions;
+  using GoalHandle = rclcpp_action::ServerGoalHandle<DetectRegionsAction>;
+  using DetectRegionsQueue =
+      region_detection_rclcpp::RequestQueue<region_detection_msgs::srv::DetectRegions::Request,
+                                            region_detection_msgs::srv::DetectRegions::Response>;
+
   region_detection_core::RegionDetectionConfig loadRegionDetectionConfig()
   {
     std::string yaml_config_file = node_->get_parameter("region_detection_cfg_file").as_string();
     return region_detection_core::RegionDetectionConfig::loadFromFile(yaml_config_file);
   }
 
+  /**
+   * @brief the worker is installed next to this executable
+   */
+  static std::string getDefaultWorkerExecutable()
+  {
+    std::vector<char> path(4096, '\0');
+    ssize_t length = readlink("/proc/self/exe", path.data(), path.size() - 1);
+    std::string exe_path = length > 0 ? std::string(path.data(), static_cast<std::size_t>(length)) : "";
+    std::size_t separator = exe_path.find_last_of('/');
+    return separator == std::string::npos ? WORKER_EXECUTABLE : exe_path.substr(0, separator + 1) + WORKER_EXECUTABLE;
+  }
+
+  std::string readRegionDetectionConfig()
+  {
+    std::string yaml_config_file = node_->get_parameter("region_detection_cfg_file").as_string();
+    std::ifstream yaml_file(yaml_config_file);
+    std::stringstream yaml_stream;
+    yaml_stream << yaml_file.rdbuf();
+    return yaml_stream.str();
+  }
+
+  /**
+   * @brief the detector is kept across requests so that the incremental mode can reuse the previous results, it is
+   * only reconfigured when the configuration changes
+   * @param yaml_str  The configuration, the configuration file of the node is used when empty
+   */
+  std::shared_ptr<region_detection_core::RegionDetector> getRegionDetector(std::string yaml_str = "")
+  {
+    using namespace region_detection_core;
+    if (yaml_str.empty())
+    {
+      yaml_str = readRegionDetectionConfig();
+    }
+    if (yaml_str.empty())
+    {
+      // let the loader report the missing file
+      region_detector_ =
+          std::make_shared<RegionDetector>(region_detection_rclcpp::restrictOutputs(loadRegionDetectionConfig()));
+      region_detection_cfg_str_.clear();
+      return region_detector_;
+    }
+
+    if (!region_detector_ || yaml_str != region_detection_cfg_str_)
+    {
+      region_detector_ = std::make_shared<RegionDetector>(
+          region_detection_rclcpp::restrictOutputs(RegionDetectionConfig::load(yaml_str)));
+      region_detection_cfg_str_ = yaml_str;
+    }
+    return region_detector_;
+  }
+
   void publishRegions(const std::string& frame_id, const std::string ns, const std::vector<EigenPose3dVector>& regions)
   {
     using namespace std::chrono_literals;
 
+    std::lock_guard<std::mutex> lock(markers_mutex_);
     if (marker_pub_timer_)
     {
       marker_pub_timer_->cancel();
@@ -252,6 +807,220 @@ private:
         500ms, [this, region_markers]() -> void { region_markers_pub_->publish(region_markers); });
   }
 
+  /**
+   * @brief runs the detection in this node or in the worker pool
+   */
+  bool computeDetection(const region_detection_msgs::srv::DetectRegions::Request& request,
+                        const std::string& yaml_str,
+                        region_detection_core::RegionDetector::RegionResults& results,
+                        bool& detected,
+                        std::string& err_msg)
+  {
+    using namespace region_detection_core;
+
+    std::unique_lock<std::mutex> lock(detector_mutex_, std::defer_lock);
+    std::shared_ptr<RegionDetector> region_detector;
+    bool decode_grayscale;
+    if (worker_pool_)
+    {
+      decode_grayscale = startsWithGrayscale(RegionDetectionConfig::load(yaml_str));
+    }
+    else
+    {
+      lock.lock();
+      region_detector = getRegionDetector(yaml_str);
+      decode_grayscale = startsWithGrayscale(region_detector->getConfig());
+    }
+
+    // converting to input for region detection
+    std::chrono::steady_clock::time_point start_conversion = std::chrono::steady_clock::now();
+    RegionDetector::DataBundleVec data_vec;
+    if (!convertRequest(request, decode_grayscale, data_vec, err_msg))
+    {
+      return false;
+    }
+    metrics_->recordStage(
+        "conversion",
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_conversion).count());
+
+    // the inputs are written to the same files by every request
+    if (save_inputs_)
+    {
+      std::lock_guard<std::mutex> save_lock(save_inputs_mutex_);
+      const std::string img_name_prefix = "img_input_";
+      const std::string pcd_file_prefix = "cloud_input_";
+      for (std::size_t i = 0; i < data_vec.size(); i++)
+      {
+        cv::imwrite(img_name_prefix + std::to_string(i) + ".jpg", data_vec[i].image);
+        pcl::io::savePCDFile(pcd_file_prefix + std::to_string(i) + ".pcd", data_vec[i].cloud_blob);
+      }
+    }
+
+    // region detection
+    if (worker_pool_)
+    {
+      return worker_pool_->compute(yaml_str, data_vec, results, detected, err_msg);
+    }
+    detected = region_detector->compute(std::move(data_vec), results);
+    return true;
+  }
+
+  /**
+   * @brief splits the bundles among the worker nodes, their curves are then merged into regions in this node.  The
+   * bundles of a worker that is not available or that fails are processed locally.
+   */
+  bool coordinateDetection(const region_detection_msgs::srv::DetectRegions::Request& request,
+                           const std::string& yaml_str,
+                           region_detection_core::RegionDetector::RegionResults& results,
+                           bool& detected,
+                           std::string& err_msg)
+  {
+    using namespace region_detection_core;
+    using ExtractCurves = region_detection_msgs::srv::ExtractCurves;
+
+    // contiguous chunks so that the curves stay in the order of the input
+    const std::size_t num_bundles = request.clouds.size();
+    const std::size_t num_chunks = std::min(curves_clients_.size(), num_bundles);
+    std::vector<ExtractCurves::Request::SharedPtr> chunk_requests;
+    std::vector<std::shared_future<ExtractCurves::Response::SharedPtr>> chunk_futures;
+    const bool compressed = !request.compressed_images.empty();
+    for (std::size_t k = 0; k < num_chunks; k++)
+    {
+      std::size_t begin = k * num_bundles / num_chunks;
+      std::size_t end = (k + 1) * num_bundles / num_chunks;
+      ExtractCurves::Request::SharedPtr chunk_request = std::make_shared<ExtractCurves::Request>();
+      if (compressed)
+      {
+        chunk_request->compressed_images.assign(std::next(request.compressed_images.begin(), begin),
+                                                std::next(request.compressed_images.begin(), end));
+      }
+      else
+      {
+        chunk_request->images.assign(std::next(request.images.begin(), begin),
+                                     std::next(request.images.begin(), end));
+      }
+      chunk_request->clouds.assign(std::next(request.clouds.begin(), begin), std::next(request.clouds.begin(), end));
+      chunk_request->transforms.assign(std::next(request.transforms.begin(), begin),
+                                       std::next(request.transforms.begin(), end));
+      chunk_request->config = yaml_str;
+      chunk_requests.push_back(chunk_request);
+
+      std::shared_future<ExtractCurves::Response::SharedPtr> future;
+      if (curves_clients_[k]->service_is_ready())
+      {
+        future = curves_clients_[k]->async_send_request(chunk_request).share();
+        RCLCPP_DEBUG(logger_, "Sent bundles %lu to %lu to %s", begin, end - 1, curves_clients_[k]->get_service_name());
+      }
+      chunk_futures.push_back(future);
+    }
+
+    // gathering the curves
+    std::vector<RegionDetector::BundleCurves> bundles_curves;
+    for (std::size_t k = 0; k < num_chunks; k++)
+    {
+      std::string chunk_err_msg = "worker node not available";
+      std::vector<RegionDetector::BundleCurves> chunk_curves;
+      std::shared_future<ExtractCurves::Response::SharedPtr>& future = chunk_futures[k];
+      bool ready = future.valid() && (coordinator_timeout_ <= 0.0 ||
+                                      future.wait_for(std::chrono::duration<double>(coordinator_timeout_)) ==
+                                          std::future_status::ready);
+      ExtractCurves::Response::SharedPtr chunk_response = ready ? future.get() : nullptr;
+      if (future.valid() && !ready)
+      {
+        // the late response is dropped
+        curves_clients_[k]->remove_pending_request(future);
+        chunk_err_msg = "worker node timed out";
+      }
+      else if (chunk_response && !chunk_response->succeeded)
+      {
+        chunk_err_msg = chunk_response->err_msg;
+      }
+      else if (chunk_response)
+      {
+        chunk_curves.resize(chunk_response->curves.size());
+        for (std::size_t i = 0; i < chunk_curves.size(); i++)
+        {
+          if (!fromBundleCurvesMsg(chunk_response->curves[i], chunk_curves[i]))
+          {
+            chunk_curves.clear();
+            chunk_err_msg = "malformed curves";
+            break;
+          }
+        }
+        if (chunk_curves.size() == chunk_requests[k]->clouds.size())
+        {
+          chunk_err_msg.clear();
+        }
+      }
+
+      if (!chunk_err_msg.empty())
+      {
+        RCLCPP_WARN_STREAM(logger_,
+                           "Processing the bundles of " << curves_clients_[k]->get_service_name()
+                                                        << " locally, " << chunk_err_msg);
+        chunk_curves.clear();
+        if (!extractCurves(*chunk_requests[k], chunk_curves, err_msg))
+        {
+          return false;
+        }
+      }
+      bundles_curves.insert(bundles_curves.end(),
+                            std::make_move_iterator(chunk_curves.begin()),
+                            std::make_move_iterator(chunk_curves.end()));
+    }
+
+    // cross view merge and poses
+    std::lock_guard<std::mutex> lock(detector_mutex_);
+    detected = getRegionDetector(yaml_str)->computeRegions(std::move(bundles_curves), results);
+    return true;
+  }
+
+  /**
+   * @brief computes the curves of each bundle in this node
+   */
+  bool extractCurves(const region_detection_msgs::srv::ExtractCurves::Request& request,
+                     std::vector<region_detection_core::RegionDetector::BundleCurves>& curves,
+                     std::string& err_msg)
+  {
+    using namespace region_detection_core;
+
+    std::lock_guard<std::mutex> lock(detector_mutex_);
+    std::shared_ptr<RegionDetector> region_detector = getRegionDetector(request.config);
+    RegionDetector::DataBundleVec data_vec;
+    if (!convertRequest(request, startsWithGrayscale(region_detector->getConfig()), data_vec, err_msg))
+    {
+      return false;
+    }
+    if (!region_detector->computeCurves(std::move(data_vec), curves))
+    {
+      err_msg = "Failed to compute the curves";
+      return false;
+    }
+    return true;
+  }
+
+  void extractCurvesCallback(const std::shared_ptr<rmw_request_id_t> request_header,
+                             const std::shared_ptr<region_detection_msgs::srv::ExtractCurves::Request> request,
+                             const std::shared_ptr<region_detection_msgs::srv::ExtractCurves::Response> response)
+  {
+    using namespace region_detection_core;
+
+    (void)request_header;
+    std::vector<RegionDetector::BundleCurves> curves;
+    response->succeeded = extractCurves(*request, curves, response->err_msg);
+    if (!response->succeeded)
+    {
+      RCLCPP_ERROR_STREAM(logger_, response->err_msg);
+      return;
+    }
+
+    for (const RegionDetector::BundleCurves& bundle_curves : curves)
+    {
+      response->curves.push_back(toBundleCurvesMsg(bundle_curves));
+    }
+    RCLCPP_INFO(logger_, "Extracted the curves of %lu bundles", curves.size());
+  }
+
   void detectRegionsCallback(const std::shared_ptr<rmw_request_id_t> request_header,
                              const std::shared_ptr<region_detection_msgs::srv::DetectRegions::Request> request,
                              const std::shared_ptr<region_detection_msgs::srv::DetectRegions::Response> response)
@@ -260,28 +1029,103 @@ private:
     using namespace pcl;
 
     (void)request_header;
+    const std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
 
-    // converting to input for region detection
-    RegionDetector::DataBundleVec data_vec;
-    const std::string img_name_prefix = "img_input_";
-    const std::string pcd_file_prefix = "cloud_input_";
+    // compressed images take precedence over the raw ones
+    const bool compressed = !request->compressed_images.empty();
+    std::uint64_t request_size = 0;
     for (std::size_t i = 0; i < request->clouds.size(); i++)
     {
-      RegionDetector::DataBundle data;
-      pcl_conversions::toPCL(request->clouds[i], data.cloud_blob);
-      cv_bridge::CvImagePtr img = cv_bridge::toCvCopy(request->images[i], sensor_msgs::image_encodings::RGBA8);
-      data.image = img->image;
-      cv::imwrite(img_name_prefix + std::to_string(i) + ".jpg", data.image);
-      pcl::io::savePCDFile(pcd_file_prefix + std::to_string(i) + ".pcd", data.cloud_blob);
-      data.transform = tf2::transformToEigen(request->transforms[i]);
-      data_vec.push_back(data);
+      request_size += request->clouds[i].data.size();
+    }
+    for (const sensor_msgs::msg::Image& image : request->images)
+    {
+      request_size += image.data.size();
     }
+    for (const sensor_msgs::msg::CompressedImage& image : request->compressed_images)
+    {
+      request_size += image.data.size();
+    }
+    region_detection_rclcpp::ServiceMetrics::RequestScope request_metrics = metrics_->startRequest(request_size);
 
-    // region detection
-    RegionDetectionConfig config = loadRegionDetectionConfig();
-    RegionDetector region_detector(config);
+    std::size_t num_images = compressed ? request->compressed_images.size() : request->images.size();
+    if (num_images != request->clouds.size() || request->transforms.size() != request->clouds.size())
+    {
+      response->succeeded = false;
+      response->err_msg = "The number of images, clouds and transforms must be the same";
+      RCLCPP_ERROR_STREAM(logger_, response->err_msg);
+      return;
+    }
+
+    // the request waits here for its turn, the slot hands the response to the identical requests once it is released
+    std::unique_ptr<DetectRegionsQueue::Slot> slot;
+    if (request_queue_)
+    {
+      auto priority = client_priorities_.find(request->client_id);
+      double timeout = request->timeout > 0.0 ? request->timeout : default_timeout_;
+      std::chrono::steady_clock::time_point deadline =
+          timeout > 0.0 ? arrival + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                        std::chrono::duration<double>(timeout)) :
+                          std::chrono::steady_clock::time_point::max();
+      slot = std::make_unique<DetectRegionsQueue::Slot>(
+          request_queue_->admit(request,
+                                response,
+                                hashRequestData(*request),
+                                priority != client_priorities_.end() ? priority->second : default_priority_,
+                                deadline));
+      switch (slot->getOutcome())
+      {
+        case DetectRegionsQueue::Outcome::RUN:
+          break;
+        case DetectRegionsQueue::Outcome::COALESCED:
+          if (slot->getResponse())
+          {
+            *response = *slot->getResponse();
+            request_metrics.setSucceeded(response->succeeded);
+            RCLCPP_INFO(logger_, "Answered with the response of an identical request");
+            return;
+          }
+          response->succeeded = false;
+          response->err_msg = "The identical request this one waited for failed";
+          RCLCPP_ERROR_STREAM(logger_, response->err_msg);
+          return;
+        case DetectRegionsQueue::Outcome::QUEUE_FULL:
+          response->succeeded = false;
+          response->err_msg = "Rejected, the request queue is full";
+          RCLCPP_WARN_STREAM(logger_, response->err_msg << " (client '" << request->client_id << "')");
+          return;
+        case DetectRegionsQueue::Outcome::DEADLINE:
+          response->succeeded = false;
+          response->err_msg = "Rejected, the request cannot complete before its deadline";
+          RCLCPP_WARN_STREAM(logger_, response->err_msg << " (client '" << request->client_id << "')");
+          return;
+      }
+    }
+
+    // the workers receive the configuration with each request
+    std::string yaml_str = readRegionDetectionConfig();
     RegionDetector::RegionResults region_detection_results;
-    if (!region_detector.compute(data_vec, region_detection_results))
+    bool detected = false;
+    std::string err_msg;
+    bool computed = curves_clients_.empty() ?
+                        computeDetection(*request, yaml_str, region_detection_results, detected, err_msg) :
+                        coordinateDetection(*request, yaml_str, region_detection_results, detected, err_msg);
+    if (!computed)
+    {
+      response->succeeded = false;
+      response->err_msg = err_msg;
+      RCLCPP_ERROR_STREAM(logger_, response->err_msg);
+      return;
+    }
+    for (const auto& kv : region_detection_results.stage_stats)
+    {
+      for (double duration : kv.second.durations)
+      {
+        metrics_->recordStage(kv.first, duration);
+      }
+    }
+
+    if (!detected)
     {
       response->succeeded = false;
       response->err_msg = "Failed to find closed regions";
@@ -303,14 +1147,193 @@ private:
       response->detected_regions.push_back(region_poses);
     }
     response->succeeded = !response->detected_regions.empty();
+    request_metrics.setSucceeded(response->succeeded);
+  }
+
+  rclcpp_action::GoalResponse handleGoal(const rclcpp_action::GoalUUID& uuid,
+                                         std::shared_ptr<const DetectRegionsAction::Goal> goal)
+  {
+    (void)uuid;
+    std::size_t num_images = goal->compressed_images.empty() ? goal->images.size() : goal->compressed_images.size();
+    if (goal->clouds.empty() || num_images != goal->clouds.size() || goal->transforms.size() != goal->clouds.size())
+    {
+      RCLCPP_ERROR(logger_, "Rejected goal, the number of images, clouds and transforms must be the same");
+      return rclcpp_action::GoalResponse::REJECT;
+    }
+    return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+  }
+
+  rclcpp_action::CancelResponse handleCancel(const std::shared_ptr<GoalHandle> goal_handle)
+  {
+    (void)goal_handle;
+    RCLCPP_INFO(logger_, "Canceling the region detection goal");
+    return rclcpp_action::CancelResponse::ACCEPT;
+  }
+
+  /**
+   * @brief preempts the active goal and starts the new one once the previous thread has stopped
+   */
+  void handleAccepted(const std::shared_ptr<GoalHandle> goal_handle)
+  {
+    std::lock_guard<std::mutex> lock(goal_mutex_);
+    if (active_goal_preempted_)
+    {
+      active_goal_preempted_->store(true);
+    }
+    std::shared_ptr<std::atomic<bool>> preempted = std::make_shared<std::atomic<bool>>(false);
+    active_goal_preempted_ = preempted;
+
+    std::thread previous_thread = std::move(goal_thread_);
+    goal_thread_ = std::thread([this, goal_handle, preempted, previous_thread = std::move(previous_thread)]() mutable {
+      if (previous_thread.joinable())
+      {
+        previous_thread.join();
+      }
+      executeGoal(goal_handle, preempted);
+    });
+  }
+
+  /**
+   * @brief runs the detection in this node, the stages and the curves of each bundle are reported as feedback.  The
+   * detector checks for preemption and cancellation between its stages.
+   */
+  void executeGoal(const std::shared_ptr<GoalHandle> goal_handle, std::shared_ptr<std::atomic<bool>> preempted)
+  {
+    using namespace region_detection_core;
+
+    std::shared_ptr<DetectRegionsAction::Result> result = std::make_shared<DetectRegionsAction::Result>();
+    auto stopped = [&goal_handle, &preempted]() { return preempted->load() || goal_handle->is_canceling(); };
+    auto finish_stopped = [&]() {
+      result->succeeded = false;
+      if (goal_handle->is_canceling())
+      {
+        result->err_msg = "Canceled";
+        goal_handle->canceled(result);
+      }
+      else
+      {
+        result->err_msg = "Preempted by a newer goal";
+        goal_handle->abort(result);
+      }
+      RCLCPP_INFO_STREAM(logger_, "Region detection goal stopped: " << result->err_msg);
+    };
+    if (stopped())
+    {
+      finish_stopped();
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(detector_mutex_);
+    std::shared_ptr<RegionDetector> region_detector = getRegionDetector();
+    const DetectRegionsAction::Goal& goal = *goal_handle->get_goal();
+    RegionDetector::DataBundleVec data_vec;
+    if (!convertRequest(goal, startsWithGrayscale(region_detector->getConfig()), data_vec, result->err_msg))
+    {
+      result->succeeded = false;
+      goal_handle->abort(result);
+      RCLCPP_ERROR_STREAM(logger_, result->err_msg);
+      return;
+    }
+
+    // the curves callback runs in the detector threads
+    const std::size_t num_bundles = data_vec.size();
+    std::mutex feedback_mutex;
+    std::string current_stage;
+    std::size_t bundles_done = 0;
+    auto publish_feedback = [&](std::vector<geometry_msgs::msg::PoseArray>&& partial_regions) {
+      std::shared_ptr<DetectRegionsAction::Feedback> feedback = std::make_shared<DetectRegionsAction::Feedback>();
+      feedback->stage = current_stage;
+      feedback->progress = static_cast<float>(bundles_done) / static_cast<float>(num_bundles);
+      feedback->partial_regions = std::move(partial_regions);
+      goal_handle->publish_feedback(feedback);
+    };
+
+    RegionDetector::ComputeMonitor monitor;
+    monitor.is_canceled = stopped;
+    monitor.on_stage = [&](const std::string& stage) {
+      std::lock_guard<std::mutex> feedback_lock(feedback_mutex);
+      current_stage = stage;
+      publish_feedback({});
+    };
+    monitor.on_bundle_curves = [&](std::size_t bundle, const RegionDetector::BundleCurves& curves) {
+      (void)bundle;
+      std::vector<geometry_msgs::msg::PoseArray> partial_regions;
+      for (const auto& curve : curves.closed_curves)
+      {
+        geometry_msgs::msg::PoseArray region_poses;
+        region_poses.header.frame_id = goal.transforms.front().header.frame_id;
+        for (const pcl::PointXYZ& p : *curve)
+        {
+          geometry_msgs::msg::Pose pose;
+          pose.position.x = p.x;
+          pose.position.y = p.y;
+          pose.position.z = p.z;
+          region_poses.poses.push_back(pose);
+        }
+        partial_regions.push_back(std::move(region_poses));
+      }
+      std::lock_guard<std::mutex> feedback_lock(feedback_mutex);
+      bundles_done++;
+      publish_feedback(std::move(partial_regions));
+    };
+
+    RegionDetector::RegionResults region_detection_results;
+    bool detected = region_detector->compute(std::move(data_vec), region_detection_results, monitor);
+    if (stopped())
+    {
+      finish_stopped();
+      return;
+    }
+    if (!detected)
+    {
+      result->succeeded = false;
+      result->err_msg = "Failed to find closed regions";
+      goal_handle->abort(result);
+      RCLCPP_ERROR_STREAM(logger_, result->err_msg);
+      return;
+    }
+    RCLCPP_INFO(logger_, "Found %lu closed regions", region_detection_results.closed_regions_poses.size());
+
+    publishRegions(
+        goal.transforms.front().header.frame_id, CLOSED_REGIONS_NS, region_detection_results.closed_regions_poses);
+    for (const EigenPose3dVector& region : region_detection_results.closed_regions_poses)
+    {
+      geometry_msgs::msg::PoseArray region_poses;
+      for (const Eigen::Affine3d& pose : region)
+      {
+        region_poses.poses.push_back(tf2::toMsg(pose));
+      }
+      result->detected_regions.push_back(region_poses);
+    }
+    result->succeeded = true;
+    goal_handle->succeed(result);
   }
 
   // ros interfaces
   rclcpp::Service<region_detection_msgs::srv::DetectRegions>::SharedPtr detect_regions_server_;
+  rclcpp_action::Server<DetectRegionsAction>::SharedPtr detect_regions_action_server_;
+  rclcpp::Service<region_detection_msgs::srv::ExtractCurves>::SharedPtr extract_curves_server_;
+  std::vector<rclcpp::Client<region_detection_msgs::srv::ExtractCurves>::SharedPtr> curves_clients_;
+  double coordinator_timeout_;
+  bool save_inputs_;
+  std::mutex save_inputs_mutex_;
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr region_markers_pub_;
   std::shared_ptr<rclcpp::Node> node_;
   rclcpp::Logger logger_;
   rclcpp::TimerBase::SharedPtr marker_pub_timer_;
+  std::mutex markers_mutex_;
+  std::shared_ptr<region_detection_rclcpp::ServiceMetrics> metrics_;
+  std::shared_ptr<region_detection_rclcpp::WorkerPool> worker_pool_;
+  std::shared_ptr<DetectRegionsQueue> request_queue_;
+  std::map<std::string, int> client_priorities_;
+  int default_priority_;
+  double default_timeout_; /** @brief seconds, 0 for requests without a deadline */
+  std::mutex detector_mutex_; /** @brief the detector keeps state between requests */
+  std::shared_ptr<region_detection_core::RegionDetector> region_detector_;
+  std::string region_detection_cfg_str_;
+  std::mutex goal_mutex_;
+  std::thread goal_thread_; /** @brief computes the active goal after joining the thread of the preempted one */
+  std::shared_ptr<std::atomic<bool>> active_goal_preempted_;
 };
 
 int main(int argc, char** argv)
@@ -325,6 +1348,10 @@ int main(int argc, char** argv)
   options.automatically_declare_parameters_from_overrides(true);
   std::shared_ptr<rclcpp::Node> node = std::make_shared<rclcpp::Node>("region_detector", options);
   RegionDetectorServer region_detector(node);
-  rclcpp::spin(node);
+
+  // the service threads plus one for the timers, one for the responses of the worker nodes and one for the action goals
+  rclcpp::executors::MultiThreadedExecutor executor(rclcpp::ExecutorOptions(), region_detector.getServiceThreads() + 3);
+  executor.add_node(node);
+  executor.spin();
   return 0;
 }
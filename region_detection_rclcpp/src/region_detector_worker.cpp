@@ -0,0 +1,140 @@
+/*
+ * @file region_detector_worker.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/prctl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <region_detection_core/region_detector.h>
+
+#include "region_detection_rclcpp/shm_transport.h"
+
+// set up by the WorkerPool that spawns this process
+static const int JOB_FD = 3;
+static const int REPLY_FD = 4;
+
+/**
+ * @brief Detector process started by the region_detector_server when its worker pool is enabled.  It waits for jobs
+ * on its job pipe, runs the detection on the data found in the shared memory named in each job and replies with the
+ * name of a new shared memory object holding the results.  It exits once the job pipe is closed.
+ */
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  using namespace region_detection_core;
+  using namespace region_detection_rclcpp;
+
+  // the worker should not outlive the server
+  prctl(PR_SET_PDEATHSIG, SIGTERM);
+  if (getppid() == 1)
+  {
+    return 1;
+  }
+
+  log4cxx::LoggerPtr logger = RegionDetector::createDefaultInfoLogger("region_detector_worker");
+  std::shared_ptr<RegionDetector> region_detector;
+  std::string region_detection_cfg_str;
+
+  WorkerJob job;
+  while (readMessage(JOB_FD, &job, sizeof(job)) == 1)
+  {
+    job.shm_name[sizeof(job.shm_name) - 1] = '\0';
+    bool detected = false;
+    std::string err_msg;
+    RegionDetector::RegionResults results;
+
+    std::string config;
+    RegionDetector::DataBundleVec input;
+    std::shared_ptr<SharedMemory> request_shm = SharedMemory::open(job.shm_name, err_msg);
+    if (request_shm &&
+        (job.size > request_shm->getSize() || !readRequest(request_shm->getData(), job.size, config, input)))
+    {
+      err_msg = "Failed to read the request";
+    }
+
+    // the detector is only reconfigured when the configuration changes
+    if (err_msg.empty())
+    {
+      try
+      {
+        if (!region_detector || config != region_detection_cfg_str)
+        {
+          region_detector =
+              std::make_shared<RegionDetector>(restrictOutputs(RegionDetectionConfig::load(config)), logger);
+          region_detection_cfg_str = config;
+        }
+        detected = region_detector->compute(std::move(input), results);
+      }
+      catch (std::exception& ex)
+      {
+        region_detector.reset();
+        err_msg = std::string("Region detection failed: ") + ex.what();
+      }
+    }
+    input.clear();
+    request_shm.reset();
+    if (!err_msg.empty())
+    {
+      LOG4CXX_ERROR(logger, err_msg);
+    }
+
+    // the results are left in a new shared memory object that the server removes
+    WorkerReply reply;
+    reply.id = job.id;
+    std::string shm_name = getResultsShmName(job.shm_name);
+    std::snprintf(reply.shm_name, sizeof(reply.shm_name), "%s", shm_name.c_str());
+    reply.size = writeResults(detected, err_msg, results, nullptr);
+    std::shared_ptr<SharedMemory> results_shm = SharedMemory::create(shm_name, reply.size, err_msg);
+    if (!results_shm)
+    {
+      LOG4CXX_ERROR(logger, err_msg);
+      return 1;
+    }
+    writeResults(detected, err_msg, results, results_shm->getData());
+
+    if (!writeMessage(REPLY_FD, &reply, sizeof(reply)))
+    {
+      return 1;
+    }
+
+    // the server removes it once read
+    results_shm->detach();
+  }
+  return 0;
+}
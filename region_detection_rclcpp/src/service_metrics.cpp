@@ -0,0 +1,289 @@
+/*
+ * @file service_metrics.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "region_detection_rclcpp/service_metrics.h"
+
+static const std::string DIAGNOSTICS_TOPIC = "/diagnostics";
+static const std::size_t SUB_BUCKET_BITS = 4;
+static const std::size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+static const std::size_t NUM_BUCKETS = SUB_BUCKETS * (64 - SUB_BUCKET_BITS + 1);
+
+static std::string toString(double value)
+{
+  std::stringstream ss;
+  ss << value;
+  return ss.str();
+}
+
+namespace region_detection_rclcpp
+{
+LatencyHistogram::LatencyHistogram() : counts_(NUM_BUCKETS, 0) { reset(); }
+
+void LatencyHistogram::record(std::uint64_t value)
+{
+  counts_[bucketIndex(value)]++;
+  count_++;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  sum_ += static_cast<double>(value);
+}
+
+void LatencyHistogram::reset()
+{
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  min_ = std::numeric_limits<std::uint64_t>::max();
+  max_ = 0;
+  sum_ = 0.0;
+}
+
+std::uint64_t LatencyHistogram::getCount() const { return count_; }
+
+std::uint64_t LatencyHistogram::getMin() const { return count_ > 0 ? min_ : 0; }
+
+std::uint64_t LatencyHistogram::getMax() const { return max_; }
+
+double LatencyHistogram::getMean() const { return count_ > 0 ? sum_ / count_ : 0.0; }
+
+std::uint64_t LatencyHistogram::getPercentile(double percentile) const
+{
+  if (count_ == 0)
+  {
+    return 0;
+  }
+
+  double clamped = std::min(100.0, std::max(0.0, percentile));
+  std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * count_)));
+  std::uint64_t cumulative = 0;
+  for (std::size_t i = 0; i < counts_.size(); i++)
+  {
+    cumulative += counts_[i];
+    if (cumulative >= target)
+    {
+      return std::min(bucketUpperBound(i), max_);
+    }
+  }
+  return max_;
+}
+
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t value)
+{
+  // values below 2 * SUB_BUCKETS have their own bucket, larger ones keep their SUB_BUCKET_BITS + 1 leading bits
+  if (value < 2 * SUB_BUCKETS)
+  {
+    return value;
+  }
+  std::size_t magnitude = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+  return SUB_BUCKETS * magnitude + (value >> magnitude);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index)
+{
+  if (index < 2 * SUB_BUCKETS)
+  {
+    return index;
+  }
+  std::size_t magnitude = index / SUB_BUCKETS - 1;
+  std::uint64_t sub_bucket = index - SUB_BUCKETS * magnitude;
+  return ((sub_bucket + 1) << magnitude) - 1;
+}
+
+ServiceMetrics::RequestScope::RequestScope(ServiceMetrics* metrics)
+  : metrics_(metrics), start_(std::chrono::steady_clock::now()), succeeded_(false)
+{
+}
+
+ServiceMetrics::RequestScope::RequestScope(RequestScope&& other)
+  : metrics_(other.metrics_), start_(other.start_), succeeded_(other.succeeded_)
+{
+  other.metrics_ = nullptr;
+}
+
+ServiceMetrics::RequestScope::~RequestScope()
+{
+  if (metrics_)
+  {
+    metrics_->finishRequest(start_, succeeded_);
+  }
+}
+
+void ServiceMetrics::RequestScope::setSucceeded(bool succeeded) { succeeded_ = succeeded; }
+
+ServiceMetrics::ServiceMetrics(std::shared_ptr<rclcpp::Node> node,
+                               const std::string& service,
+                               const std::string& size_units)
+  : node_(node)
+  , service_(service)
+  , size_units_(size_units)
+  , num_requests_(0)
+  , num_failures_(0)
+  , in_flight_(0)
+  , max_in_flight_(0)
+{
+  double publish_period, file_period;
+  std::string file;
+  node_->get_parameter_or("metrics.publish_period", publish_period, 1.0);
+  node_->get_parameter_or("metrics.file", file, std::string(""));
+  node_->get_parameter_or("metrics.file_period", file_period, publish_period > 0.0 ? publish_period : 1.0);
+
+  if (!file.empty())
+  {
+    file_.open(file, std::ios::out | std::ios::app);
+    if (!file_.is_open())
+    {
+      RCLCPP_ERROR(node_->get_logger(), "Failed to open metrics file %s", file.c_str());
+    }
+    else if (file_period <= 0.0)
+    {
+      RCLCPP_ERROR(
+          node_->get_logger(), "The metrics file period must be greater than 0, %s is not written", file.c_str());
+    }
+    else
+    {
+      file_timer_ = node_->create_wall_timer(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(file_period)),
+          std::bind(&ServiceMetrics::writeFile, this));
+    }
+  }
+
+  if (publish_period > 0.0)
+  {
+    diagnostics_pub_ =
+        node_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>(DIAGNOSTICS_TOPIC, rclcpp::QoS(10));
+    publish_timer_ = node_->create_wall_timer(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(publish_period)),
+        std::bind(&ServiceMetrics::publish, this));
+  }
+}
+
+ServiceMetrics::RequestScope ServiceMetrics::startRequest(std::uint64_t request_size)
+{
+  int in_flight = ++in_flight_;
+  std::lock_guard<std::mutex> lock(mutex_);
+  request_sizes_.record(request_size);
+  max_in_flight_ = std::max(max_in_flight_, in_flight);
+  return RequestScope(this);
+}
+
+void ServiceMetrics::recordStage(const std::string& stage, double seconds)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  stage_latencies_[stage].record(static_cast<std::uint64_t>(std::max(0.0, seconds) * 1e6));
+}
+
+void ServiceMetrics::finishRequest(const std::chrono::steady_clock::time_point& start, bool succeeded)
+{
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  in_flight_--;
+  std::lock_guard<std::mutex> lock(mutex_);
+  latency_.record(static_cast<std::uint64_t>(elapsed.count()));
+  num_requests_++;
+  num_failures_ += succeeded ? 0 : 1;
+}
+
+diagnostic_msgs::msg::DiagnosticStatus ServiceMetrics::getStatus()
+{
+  using diagnostic_msgs::msg::DiagnosticStatus;
+  using diagnostic_msgs::msg::KeyValue;
+
+  DiagnosticStatus status;
+  status.name = std::string(node_->get_name()) + ": " + service_;
+  status.hardware_id = node_->get_fully_qualified_name();
+
+  auto add_value = [&status](const std::string& key, const std::string& value) {
+    KeyValue kv;
+    kv.key = key;
+    kv.value = value;
+    status.values.push_back(kv);
+  };
+
+  // latencies are recorded in microseconds and reported in milliseconds
+  auto add_latency = [&add_value](const std::string& prefix, const LatencyHistogram& h) {
+    add_value(prefix + ".count", std::to_string(h.getCount()));
+    add_value(prefix + ".mean_ms", toString(h.getMean() * 1e-3));
+    add_value(prefix + ".p50_ms", toString(h.getPercentile(50.0) * 1e-3));
+    add_value(prefix + ".p90_ms", toString(h.getPercentile(90.0) * 1e-3));
+    add_value(prefix + ".p99_ms", toString(h.getPercentile(99.0) * 1e-3));
+    add_value(prefix + ".max_ms", toString(h.getMax() * 1e-3));
+  };
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  double failure_rate = num_requests_ > 0 ? static_cast<double>(num_failures_) / num_requests_ : 0.0;
+  status.level = num_failures_ > 0 ? DiagnosticStatus::WARN : DiagnosticStatus::OK;
+  status.message = std::to_string(num_requests_) + " requests, " + std::to_string(num_failures_) + " failed, " +
+                   std::to_string(in_flight_.load()) + " in flight";
+
+  add_value("requests", std::to_string(num_requests_));
+  add_value("failures", std::to_string(num_failures_));
+  add_value("failure_rate", toString(failure_rate));
+  add_value("in_flight", std::to_string(in_flight_.load()));
+  add_value("max_in_flight", std::to_string(max_in_flight_));
+  add_latency("total", latency_);
+  for (const auto& kv : stage_latencies_)
+  {
+    add_latency(kv.first, kv.second);
+  }
+
+  const std::string size_prefix = "request_size_" + size_units_;
+  add_value(size_prefix + ".p50", std::to_string(request_sizes_.getPercentile(50.0)));
+  add_value(size_prefix + ".p99", std::to_string(request_sizes_.getPercentile(99.0)));
+  add_value(size_prefix + ".max", std::to_string(request_sizes_.getMax()));
+  return status;
+}
+
+void ServiceMetrics::publish()
+{
+  diagnostic_msgs::msg::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = node_->now();
+  diagnostics.status.push_back(getStatus());
+  diagnostics_pub_->publish(diagnostics);
+}
+
+void ServiceMetrics::writeFile()
+{
+  diagnostic_msgs::msg::DiagnosticStatus status = getStatus();
+  file_ << node_->now().seconds() << " " << status.name;
+  for (const diagnostic_msgs::msg::KeyValue& kv : status.values)
+  {
+    file_ << " " << kv.key << "=" << kv.value;
+  }
+  file_ << std::endl;
+}
+
+}  // namespace region_detection_rclcpp
@@ -0,0 +1,539 @@
+/*
+ * @file shm_transport.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "region_detection_rclcpp/shm_transport.h"
+
+static const std::uint32_t REQUEST_MAGIC = 0x52445251;  // "RDRQ"
+static const std::uint32_t RESULTS_MAGIC = 0x52445253;  // "RDRS"
+static const std::size_t DATA_ALIGNMENT = 16;
+
+/**
+ * @brief appends values at a cursor, when no destination is given it only counts the bytes
+ */
+class BufferWriter
+{
+public:
+  explicit BufferWriter(std::uint8_t* dst) : dst_(dst), pos_(0) {}
+
+  void putBytes(const void* src, std::size_t size)
+  {
+    if (dst_ && size > 0)
+    {
+      std::memcpy(dst_ + pos_, src, size);
+    }
+    pos_ += size;
+  }
+
+  template <typename T>
+  void put(const T& value)
+  {
+    putBytes(&value, sizeof(T));
+  }
+
+  void putString(const std::string& str)
+  {
+    put<std::uint64_t>(str.size());
+    putBytes(str.data(), str.size());
+  }
+
+  /**
+   * @brief pads so that the next bytes start at an aligned offset, the mapping itself is page aligned
+   */
+  void align()
+  {
+    std::size_t padding = (DATA_ALIGNMENT - pos_ % DATA_ALIGNMENT) % DATA_ALIGNMENT;
+    if (dst_ && padding > 0)
+    {
+      std::memset(dst_ + pos_, 0, padding);
+    }
+    pos_ += padding;
+  }
+
+  std::size_t getPosition() const { return pos_; }
+
+private:
+  std::uint8_t* dst_;
+  std::size_t pos_;
+};
+
+/**
+ * @brief reads values at a cursor with bounds checking
+ */
+class BufferReader
+{
+public:
+  BufferReader(const std::uint8_t* src, std::size_t size) : src_(src), size_(size), pos_(0) {}
+
+  const std::uint8_t* getBytes(std::size_t size)
+  {
+    if (size > size_ - pos_)
+    {
+      return nullptr;
+    }
+    const std::uint8_t* bytes = src_ + pos_;
+    pos_ += size;
+    return bytes;
+  }
+
+  template <typename T>
+  bool get(T& value)
+  {
+    const std::uint8_t* bytes = getBytes(sizeof(T));
+    if (!bytes)
+    {
+      return false;
+    }
+    std::memcpy(&value, bytes, sizeof(T));
+    return true;
+  }
+
+  bool getString(std::string& str)
+  {
+    std::uint64_t length;
+    const std::uint8_t* bytes;
+    if (!get(length) || !(bytes = getBytes(length)))
+    {
+      return false;
+    }
+    str.assign(reinterpret_cast<const char*>(bytes), length);
+    return true;
+  }
+
+  bool align()
+  {
+    std::size_t padding = (DATA_ALIGNMENT - pos_ % DATA_ALIGNMENT) % DATA_ALIGNMENT;
+    return getBytes(padding) != nullptr;
+  }
+
+  /**
+   * @brief used to reject element counts that cannot fit in the remaining bytes before allocating
+   */
+  std::size_t getRemaining() const { return size_ - pos_; }
+
+private:
+  const std::uint8_t* src_;
+  std::size_t size_;
+  std::size_t pos_;
+};
+
+static void writePoses(BufferWriter& writer,
+                       const std::vector<region_detection_core::RegionDetector::EigenPose3dVector>& regions)
+{
+  writer.put<std::uint64_t>(regions.size());
+  for (const region_detection_core::RegionDetector::EigenPose3dVector& poses : regions)
+  {
+    writer.put<std::uint64_t>(poses.size());
+    for (const Eigen::Isometry3d& pose : poses)
+    {
+      writer.putBytes(pose.matrix().data(), 16 * sizeof(double));
+    }
+  }
+}
+
+static bool readPoses(BufferReader& reader,
+                      std::vector<region_detection_core::RegionDetector::EigenPose3dVector>& regions)
+{
+  std::uint64_t num_regions;
+  if (!reader.get(num_regions) || num_regions > reader.getRemaining())
+  {
+    return false;
+  }
+  regions.resize(num_regions);
+  for (region_detection_core::RegionDetector::EigenPose3dVector& poses : regions)
+  {
+    std::uint64_t num_poses;
+    if (!reader.get(num_poses) || num_poses > reader.getRemaining() / (16 * sizeof(double)))
+    {
+      return false;
+    }
+    poses.resize(num_poses);
+    for (Eigen::Isometry3d& pose : poses)
+    {
+      const std::uint8_t* bytes = reader.getBytes(16 * sizeof(double));
+      if (!bytes)
+      {
+        return false;
+      }
+      std::memcpy(pose.matrix().data(), bytes, 16 * sizeof(double));
+    }
+  }
+  return true;
+}
+
+namespace region_detection_rclcpp
+{
+SharedMemory::SharedMemory(const std::string& name, std::uint8_t* data, std::size_t size, bool owner)
+  : name_(name), data_(data), size_(size), owner_(owner)
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+  munmap(data_, size_);
+  if (owner_)
+  {
+    unlink();
+  }
+}
+
+std::shared_ptr<SharedMemory> SharedMemory::create(const std::string& name, std::size_t size, std::string& err_msg)
+{
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd < 0)
+  {
+    err_msg = "Failed to create shared memory " + name + ": " + std::strerror(errno);
+    return nullptr;
+  }
+
+  // an empty mapping is not allowed
+  size = std::max<std::size_t>(size, 1);
+  void* data = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+  {
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int error = errno;
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    shm_unlink(name.c_str());
+    err_msg = "Failed to map shared memory " + name + ": " + std::strerror(error);
+    return nullptr;
+  }
+  return std::shared_ptr<SharedMemory>(new SharedMemory(name, static_cast<std::uint8_t*>(data), size, true));
+}
+
+std::shared_ptr<SharedMemory> SharedMemory::open(const std::string& name, std::string& err_msg)
+{
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+  {
+    err_msg = "Failed to open shared memory " + name + ": " + std::strerror(errno);
+    return nullptr;
+  }
+
+  struct stat info;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+  {
+    data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int error = errno;
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    err_msg = "Failed to map shared memory " + name + ": " + std::strerror(error);
+    return nullptr;
+  }
+  return std::shared_ptr<SharedMemory>(
+      new SharedMemory(name, static_cast<std::uint8_t*>(data), static_cast<std::size_t>(info.st_size), false));
+}
+
+void SharedMemory::unlink()
+{
+  shm_unlink(name_.c_str());
+  owner_ = false;
+}
+
+void SharedMemory::remove(const std::string& name)
+{
+  shm_unlink(name.c_str());
+}
+
+std::string getResultsShmName(const std::string& job_shm_name)
+{
+  return job_shm_name + "_results";
+}
+
+bool writeMessage(int fd, const void* msg, std::size_t size)
+{
+  const std::uint8_t* bytes = static_cast<const std::uint8_t*>(msg);
+  std::size_t written = 0;
+  while (written < size)
+  {
+    ssize_t count = write(fd, bytes + written, size - written);
+    if (count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (count <= 0)
+    {
+      return false;
+    }
+    written += static_cast<std::size_t>(count);
+  }
+  return true;
+}
+
+int readMessage(int fd, void* msg, std::size_t size, int timeout_ms)
+{
+  std::uint8_t* bytes = static_cast<std::uint8_t*>(msg);
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+  std::size_t read_size = 0;
+  while (read_size < size)
+  {
+    if (timeout_ms > 0)
+    {
+      int remaining_ms = static_cast<int>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count());
+      struct pollfd poll_fd = { fd, POLLIN, 0 };
+      int ready = remaining_ms > 0 ? poll(&poll_fd, 1, remaining_ms) : 0;
+      if (ready < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (ready <= 0)
+      {
+        return -1;
+      }
+    }
+
+    ssize_t count = read(fd, bytes + read_size, size - read_size);
+    if (count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (count < 0)
+    {
+      return -1;
+    }
+    if (count == 0)
+    {
+      return 0;
+    }
+    read_size += static_cast<std::size_t>(count);
+  }
+  return 1;
+}
+
+std::size_t writeRequest(const std::string& config,
+                         const region_detection_core::RegionDetector::DataBundleVec& input,
+                         std::uint8_t* dst)
+{
+  BufferWriter writer(dst);
+  writer.put(REQUEST_MAGIC);
+  writer.putString(config);
+  writer.put<std::uint64_t>(input.size());
+  for (const region_detection_core::RegionDetector::DataBundle& data : input)
+  {
+    // image, the rows are packed without padding
+    const cv::Mat& image = data.image;
+    writer.put<std::int32_t>(image.rows);
+    writer.put<std::int32_t>(image.cols);
+    writer.put<std::int32_t>(image.type());
+    writer.align();
+    const std::size_t row_size = image.cols * image.elemSize();
+    for (int r = 0; r < image.rows; r++)
+    {
+      writer.putBytes(image.ptr(r), row_size);
+    }
+
+    // cloud
+    const pcl::PCLPointCloud2& cloud = data.cloud_blob;
+    writer.putString(cloud.header.frame_id);
+    writer.put<std::uint64_t>(cloud.header.stamp);
+    writer.put(cloud.width);
+    writer.put(cloud.height);
+    writer.put(cloud.point_step);
+    writer.put(cloud.row_step);
+    writer.put(cloud.is_bigendian);
+    writer.put(cloud.is_dense);
+    writer.put<std::uint64_t>(cloud.fields.size());
+    for (const pcl::PCLPointField& field : cloud.fields)
+    {
+      writer.putString(field.name);
+      writer.put(field.offset);
+      writer.put(field.datatype);
+      writer.put(field.count);
+    }
+    writer.put<std::uint64_t>(cloud.data.size());
+    writer.align();
+    writer.putBytes(cloud.data.data(), cloud.data.size());
+
+    writer.putBytes(data.transform.matrix().data(), 16 * sizeof(double));
+  }
+  return writer.getPosition();
+}
+
+bool readRequest(const std::uint8_t* src,
+                 std::size_t size,
+                 std::string& config,
+                 region_detection_core::RegionDetector::DataBundleVec& input)
+{
+  BufferReader reader(src, size);
+  std::uint32_t magic;
+  std::uint64_t num_bundles;
+  if (!reader.get(magic) || magic != REQUEST_MAGIC || !reader.getString(config) || !reader.get(num_bundles) ||
+      num_bundles > reader.getRemaining())
+  {
+    return false;
+  }
+
+  input.clear();
+  for (std::uint64_t i = 0; i < num_bundles; i++)
+  {
+    region_detection_core::RegionDetector::DataBundle data;
+
+    // image, mapped in place
+    std::int32_t rows, cols, type;
+    if (!reader.get(rows) || !reader.get(cols) || !reader.get(type) || !reader.align() || rows < 0 || cols < 0)
+    {
+      return false;
+    }
+    const std::size_t image_size = static_cast<std::size_t>(rows) * cols * CV_ELEM_SIZE(type);
+    const std::uint8_t* image_data = reader.getBytes(image_size);
+    if (!image_data)
+    {
+      return false;
+    }
+    data.image = cv::Mat(rows, cols, type, const_cast<std::uint8_t*>(image_data));
+
+    // cloud, the point buffer is copied since PCLPointCloud2 owns its data
+    pcl::PCLPointCloud2& cloud = data.cloud_blob;
+    std::uint64_t stamp, num_fields, data_size;
+    if (!reader.getString(cloud.header.frame_id) || !reader.get(stamp) || !reader.get(cloud.width) ||
+        !reader.get(cloud.height) || !reader.get(cloud.point_step) || !reader.get(cloud.row_step) ||
+        !reader.get(cloud.is_bigendian) || !reader.get(cloud.is_dense) || !reader.get(num_fields) ||
+        num_fields > reader.getRemaining())
+    {
+      return false;
+    }
+    cloud.header.stamp = stamp;
+    cloud.fields.resize(num_fields);
+    for (pcl::PCLPointField& field : cloud.fields)
+    {
+      if (!reader.getString(field.name) || !reader.get(field.offset) || !reader.get(field.datatype) ||
+          !reader.get(field.count))
+      {
+        return false;
+      }
+    }
+    const std::uint8_t* cloud_data;
+    if (!reader.get(data_size) || !reader.align() || !(cloud_data = reader.getBytes(data_size)))
+    {
+      return false;
+    }
+    cloud.data.assign(cloud_data, cloud_data + data_size);
+
+    const std::uint8_t* transform_data = reader.getBytes(16 * sizeof(double));
+    if (!transform_data)
+    {
+      return false;
+    }
+    std::memcpy(data.transform.matrix().data(), transform_data, 16 * sizeof(double));
+    input.push_back(data);
+  }
+  return true;
+}
+
+region_detection_core::RegionDetectionConfig restrictOutputs(region_detection_core::RegionDetectionConfig config)
+{
+  config.output_cfg.open_regions = false;
+  config.output_cfg.images = false;
+  config.output_cfg.contours = false;
+  return config;
+}
+
+std::size_t writeResults(bool succeeded,
+                         const std::string& err_msg,
+                         const region_detection_core::RegionDetector::RegionResults& results,
+                         std::uint8_t* dst)
+{
+  BufferWriter writer(dst);
+  writer.put(RESULTS_MAGIC);
+  writer.put<std::uint8_t>(succeeded);
+  writer.putString(err_msg);
+  writePoses(writer, results.closed_regions_poses);
+  writePoses(writer, results.open_regions_poses);
+  writer.put<std::uint64_t>(results.stage_stats.size());
+  for (const auto& kv : results.stage_stats)
+  {
+    writer.putString(kv.first);
+    writer.put<std::uint64_t>(kv.second.durations.size());
+    writer.putBytes(kv.second.durations.data(), kv.second.durations.size() * sizeof(double));
+  }
+  return writer.getPosition();
+}
+
+bool readResults(const std::uint8_t* src,
+                 std::size_t size,
+                 bool& succeeded,
+                 std::string& err_msg,
+                 region_detection_core::RegionDetector::RegionResults& results)
+{
+  BufferReader reader(src, size);
+  std::uint32_t magic;
+  std::uint8_t succeeded_flag;
+  std::uint64_t num_stages;
+  if (!reader.get(magic) || magic != RESULTS_MAGIC || !reader.get(succeeded_flag) || !reader.getString(err_msg) ||
+      !readPoses(reader, results.closed_regions_poses) || !readPoses(reader, results.open_regions_poses) ||
+      !reader.get(num_stages) || num_stages > reader.getRemaining())
+  {
+    return false;
+  }
+  succeeded = succeeded_flag != 0;
+
+  results.stage_stats.clear();
+  for (std::uint64_t i = 0; i < num_stages; i++)
+  {
+    std::string stage;
+    std::uint64_t num_durations;
+    const std::uint8_t* durations;
+    if (!reader.getString(stage) || !reader.get(num_durations) ||
+        num_durations > reader.getRemaining() / sizeof(double) ||
+        !(durations = reader.getBytes(num_durations * sizeof(double))))
+    {
+      return false;
+    }
+    std::vector<double>& stage_durations = results.stage_stats[stage].durations;
+    stage_durations.resize(num_durations);
+    std::memcpy(stage_durations.data(), durations, num_durations * sizeof(double));
+  }
+  return true;
+}
+
+}  // namespace region_detection_rclcpp
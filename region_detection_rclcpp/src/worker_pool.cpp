@@ -0,0 +1,287 @@
+/*
+ * @file worker_pool.cpp
+ * @date Oct 18, 2026
+ * @copyright Copyright (c) 2020, Southwest Research Institute
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2020, Southwest Research Institute
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *       * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *       * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *       * Neither the name of the Southwest Research Institute, nor the names
+ *       of its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "region_detection_rclcpp/shm_transport.h"
+#include "region_detection_rclcpp/worker_pool.h"
+
+extern char** environ;
+
+// the worker reads jobs from and writes replies to these descriptors, stdout is left to its logger
+static const int WORKER_JOB_FD = 3;
+static const int WORKER_REPLY_FD = 4;
+static const int MIN_PIPE_FD = 10;
+
+/**
+ * @brief creates a pipe whose ends are closed on exec and placed above the descriptors the worker expects
+ */
+static bool createPipe(int fds[2])
+{
+  int raw_fds[2];
+  if (pipe2(raw_fds, O_CLOEXEC) != 0)
+  {
+    return false;
+  }
+  for (int i = 0; i < 2; i++)
+  {
+    fds[i] = fcntl(raw_fds[i], F_DUPFD_CLOEXEC, MIN_PIPE_FD);
+    close(raw_fds[i]);
+  }
+  if (fds[0] < 0 || fds[1] < 0)
+  {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  return true;
+}
+
+namespace region_detection_rclcpp
+{
+WorkerPool::WorkerPool(const std::string& executable, std::size_t num_workers, double timeout, rclcpp::Logger logger)
+  : executable_(executable)
+  , timeout_ms_(static_cast<int>(std::round(timeout * 1000.0)))
+  , logger_(logger)
+  , workers_(num_workers)
+  , next_job_id_(0)
+{
+  // writing to the pipe of a crashed worker should fail instead of terminating the node
+  signal(SIGPIPE, SIG_IGN);
+
+  for (std::size_t i = 0; i < workers_.size(); i++)
+  {
+    std::string err_msg;
+    if (!spawn(workers_[i], err_msg))
+    {
+      RCLCPP_ERROR_STREAM(logger_, err_msg);
+    }
+    idle_.push_back(i);
+  }
+  RCLCPP_INFO(logger_, "Started %lu detector workers", workers_.size());
+}
+
+WorkerPool::~WorkerPool()
+{
+  for (Worker& worker : workers_)
+  {
+    terminate(worker, "");
+  }
+}
+
+bool WorkerPool::spawn(Worker& worker, std::string& err_msg)
+{
+  int job_pipe[2], reply_pipe[2];
+  if (!createPipe(job_pipe))
+  {
+    err_msg = std::string("Failed to create worker pipe: ") + std::strerror(errno);
+    return false;
+  }
+  if (!createPipe(reply_pipe))
+  {
+    err_msg = std::string("Failed to create worker pipe: ") + std::strerror(errno);
+    close(job_pipe[0]);
+    close(job_pipe[1]);
+    return false;
+  }
+
+  // dup2 clears the close on exec flag of the target descriptors only
+  posix_spawn_file_actions_t file_actions;
+  posix_spawn_file_actions_init(&file_actions);
+  posix_spawn_file_actions_adddup2(&file_actions, job_pipe[0], WORKER_JOB_FD);
+  posix_spawn_file_actions_adddup2(&file_actions, reply_pipe[1], WORKER_REPLY_FD);
+
+  std::vector<char*> argv = { const_cast<char*>(executable_.c_str()), nullptr };
+  pid_t pid;
+  int error = posix_spawn(&pid, executable_.c_str(), &file_actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&file_actions);
+  close(job_pipe[0]);
+  close(reply_pipe[1]);
+  if (error != 0)
+  {
+    err_msg = "Failed to start worker " + executable_ + ": " + std::strerror(error);
+    close(job_pipe[1]);
+    close(reply_pipe[0]);
+    return false;
+  }
+
+  worker.pid = pid;
+  worker.job_fd = job_pipe[1];
+  worker.reply_fd = reply_pipe[0];
+  RCLCPP_DEBUG(logger_, "Started detector worker %d", pid);
+  return true;
+}
+
+void WorkerPool::terminate(Worker& worker, const std::string& reason)
+{
+  if (worker.pid < 0)
+  {
+    return;
+  }
+
+  // a failed worker is killed, otherwise it is asked to stop which interrupts any request in progress
+  close(worker.job_fd);
+  close(worker.reply_fd);
+  kill(worker.pid, reason.empty() ? SIGTERM : SIGKILL);
+
+  int status = 0;
+  while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR)
+  {
+  }
+  if (!reason.empty())
+  {
+    if (WIFSIGNALED(status) && WTERMSIG(status) != SIGKILL && WTERMSIG(status) != SIGTERM)
+    {
+      RCLCPP_ERROR(logger_, "Detector worker %d %s, terminated by signal %d", worker.pid, reason.c_str(),
+                   WTERMSIG(status));
+    }
+    else
+    {
+      RCLCPP_ERROR(logger_, "Detector worker %d %s", worker.pid, reason.c_str());
+    }
+  }
+  worker = Worker();
+}
+
+std::size_t WorkerPool::acquire()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this]() { return !idle_.empty(); });
+  std::size_t index = idle_.front();
+  idle_.pop_front();
+  return index;
+}
+
+void WorkerPool::release(std::size_t index)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(index);
+  }
+  idle_cv_.notify_one();
+}
+
+bool WorkerPool::compute(const std::string& config,
+                         const region_detection_core::RegionDetector::DataBundleVec& input,
+                         region_detection_core::RegionDetector::RegionResults& results,
+                         bool& detected,
+                         std::string& err_msg)
+{
+  std::size_t index = acquire();
+  Worker& worker = workers_[index];
+  auto fail = [&](const std::string& msg) -> bool {
+    err_msg = msg;
+    release(index);
+    return false;
+  };
+
+  // a worker that crashed on a previous request is restarted here
+  if (worker.pid < 0 && !spawn(worker, err_msg))
+  {
+    return fail(err_msg);
+  }
+
+  // the request is written straight into the shared memory
+  WorkerJob job;
+  job.id = next_job_id_++;
+  std::string shm_name = "/region_detector_" + std::to_string(getpid()) + "_" + std::to_string(job.id);
+  std::snprintf(job.shm_name, sizeof(job.shm_name), "%s", shm_name.c_str());
+  job.size = writeRequest(config, input, nullptr);
+  std::shared_ptr<SharedMemory> request_shm = SharedMemory::create(shm_name, job.size, err_msg);
+  if (!request_shm)
+  {
+    return fail(err_msg);
+  }
+  writeRequest(config, input, request_shm->getData());
+
+  WorkerReply reply;
+  int status = -1;
+  const bool sent = writeMessage(worker.job_fd, &job, sizeof(job));
+  if (sent)
+  {
+    status = readMessage(worker.reply_fd, &reply, sizeof(reply), timeout_ms_);
+  }
+  request_shm.reset();
+  if (status != 1 || reply.id != job.id)
+  {
+    std::string reason = status < 0 ? "timed out while processing the request" : "crashed while processing the request";
+    if (!sent)
+    {
+      reason = "exited before the request was sent";
+    }
+    else if (status == 1)
+    {
+      reason = "replied to the wrong request";
+    }
+    terminate(worker, reason);
+
+    // a worker killed after creating the results object leaves it behind
+    SharedMemory::remove(getResultsShmName(shm_name));
+    return fail("The detector worker " + reason);
+  }
+
+  // the worker leaves the results in a new shared memory object that is removed once read
+  reply.shm_name[sizeof(reply.shm_name) - 1] = '\0';
+  std::shared_ptr<SharedMemory> results_shm = SharedMemory::open(reply.shm_name, err_msg);
+  if (!results_shm)
+  {
+    return fail(err_msg);
+  }
+  results_shm->unlink();
+  std::string detection_msg;
+  if (reply.size > results_shm->getSize() ||
+      !readResults(results_shm->getData(), reply.size, detected, detection_msg, results))
+  {
+    return fail("Failed to read the results of the detector worker");
+  }
+  if (!detection_msg.empty())
+  {
+    // the worker is fine but could not run the detection, e.g. an invalid configuration
+    return fail(detection_msg);
+  }
+
+  release(index);
+  return true;
+}
+
+}  // namespace region_detection_rclcpp
@@ -340,7 +340,14 @@ int main(int argc, char** argv)
     for (std::size_t j = 0; j < results.closed_regions_poses.size(); j++)
     {
       pcl::PointCloud<pcl::PointXYZ>::Ptr cropped_cloud = boost::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
-      crop.setRegion(results.closed_regions_poses[j]);
+      if (j < results.closed_regions_info.size())
+      {
+        crop.setRegion(results.closed_regions_poses[j], results.closed_regions_info[j].plane);
+      }
+      else
+      {
+        crop.setRegion(results.closed_regions_poses[j]);
+      }
       std::vector<int> indices = crop.filter();
 
       if (!indices.empty())